@@ -3,6 +3,7 @@ with System.Machine_Code;
 with Ada.Unchecked_Conversion;
 with Interfaces;
 with Bits;
+with Configure;
 with MMIO;
 with CPU;
 with M68k;
@@ -71,14 +72,17 @@ package body Application
    ----------------------------------------------------------------------------
    procedure Handle_Ethernet
       is
-      P       : PBUF.Pbuf_Ptr;
-      Success : Boolean;
+      Packets : Ethernet.Pbuf_Array (1 .. 4);
+      Count   : Natural;
    begin
-      Ethernet.Dequeue (Ethernet.Packet_Queue'Access, P, Success);
-      if Success then
-         Ethernet.Packet_Handler (P);
-         PBUF.Free (P);
-      end if;
+      Ethernet.Poll;
+      for Id in 1 .. Ethernet.Interface_Count loop
+         Ethernet.Dequeue_Batch (Ethernet.Packet_Queues (Id)'Access, Packets, Count);
+         for Index in 1 .. Count loop
+            Ethernet.Packet_Handler (Id, Packets (Index));
+            PBUF.Free (Packets (Index));
+         end loop;
+      end loop;
    end Handle_Ethernet;
 
    ----------------------------------------------------------------------------
@@ -95,9 +99,14 @@ package body Application
             -- Ethernet module initialization ------------------------------
             Ethernet_Descriptor.Haddress := A2065.A2065_MAC;
             Ethernet_Descriptor.Paddress := [192, 168, 3, 2];
+            Ethernet_Descriptor.Netmask  := [255, 255, 255, 0];
             Ethernet_Descriptor.RX       := null;
             Ethernet_Descriptor.TX       := A2065.Transmit'Access;
-            Ethernet.Init (Ethernet_Descriptor);
+            Ethernet_Descriptor.Poll     := A2065.Poll'Access;
+            Ethernet_Descriptor.MTU      := Ethernet.ETH_MTU;
+            Ethernet.Init;
+            Ethernet.Interface_Add (Ethernet_Descriptor, A2065.A2065_Interface_Id);
+            Ethernet.ARP_Aging_Start (Configure.TICK_FREQUENCY); -- 1 s, from the tick IRQ
             -- A2065 initialization ----------------------------------------
             A2065.Init;
          end;
@@ -108,9 +117,9 @@ package body Application
             Success   : Boolean;
             Partition : MBR.Partition_Entry_Type;
          begin
-            MBR.Read (BSP.IDE_Descriptor'Access, MBR.PARTITION1, Partition, Success);
+            MBR.Read (BSP.IDE_Block_Device'Access, MBR.PARTITION1, Partition, Success);
             if Success then
-               Fatfs_Object.Device := BSP.IDE_Descriptor'Access;
+               Fatfs_Object.Device := BSP.IDE_Block_Device'Access;
                FATFS.Open
                   (Fatfs_Object,
                    BlockDevices.Sector_Type (Partition.LBA_Start),
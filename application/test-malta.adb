@@ -71,9 +71,9 @@ package body Application
             Success   : Boolean;
             Partition : MBR.Partition_Entry_Type;
          begin
-            MBR.Read (Malta.PIIX4_IDE_Descriptor'Access, MBR.PARTITION1, Partition, Success);
+            MBR.Read (Malta.PIIX4_IDE_Block_Device'Access, MBR.PARTITION1, Partition, Success);
             if Success then
-               Fatfs_Object.Device := Malta.PIIX4_IDE_Descriptor'Access;
+               Fatfs_Object.Device := Malta.PIIX4_IDE_Block_Device'Access;
                FATFS.Open
                   (Fatfs_Object,
                    BlockDevices.Sector_Type (Partition.LBA_Start),
@@ -5,6 +5,7 @@ with System.Machine_Code;
 with Ada.Unchecked_Conversion;
 with Interfaces;
 with Definitions;
+with Configure;
 with Core;
 with Bits;
 with Malloc;
@@ -20,10 +21,17 @@ with BlockDevices;
 with MBR;
 with FATFS;
 with FATFS.Applications;
+with FATFS.Directory;
+with FATFS.Rawfile;
 with MC146818A;
 with UART16x50;
+with NE2000;
 with PBUF;
 with Ethernet;
+with TCPIP;
+with UDP_Sockets;
+with TCP_Sockets;
+with DHCP_Client;
 with Time;
 with PCICAN;
 with Console;
@@ -55,12 +63,47 @@ package body Application
        with Alignment               => 16#1000#,
             Suppress_Initialization => True; -- pragma Initialize_Scalars
 
-   Fatfs_Object : FATFS.Descriptor_Type;
+   Fatfs_Object  : FATFS.Descriptor_Type;
+   Fatfs_Mounted : Boolean := False;
+
+   -- DHCP is enabled by USE_DHCP in the subplatform configuration.in; the
+   -- lease is saved with the RTC time it was granted at, so that a stale
+   -- one is not reused after a long power-off
+   DHCP_LEASE_FILE : constant String := "DHCPLEAS.DAT";
+
+   type Lease_Record_Type is record
+      Lease   : DHCP_Client.Lease_Type;
+      Granted : Unsigned_32; -- seconds since 1970-01-01 00:00:00
+   end record;
+
+   UDP_ECHO_PORT : constant := 7; -- RFC 862
+   Echo_Socket   : UDP_Sockets.Socket_Type := UDP_Sockets.NO_SOCKET;
+   Echo_Data     : Byte_Array (0 .. UDP_Sockets.UDP_PAYLOAD_SIZE - 1);
+
+   -- benchmark statistics: any datagram is answered with the stack
+   -- counters, as big-endian 32-bit words, see share/netbench.py
+   UDP_STATS_PORT : constant := 9_001;
+   Stats_Socket   : UDP_Sockets.Socket_Type := UDP_Sockets.NO_SOCKET;
+
+   -- bulk TCP source: a connection to this port receives an endless stream
+   TCP_CHARGEN_PORT : constant := 19; -- RFC 864
+   Chargen_Listener : TCP_Sockets.Socket_Type := TCP_Sockets.NO_SOCKET;
+   Chargen_Socket   : TCP_Sockets.Socket_Type := TCP_Sockets.NO_SOCKET;
+   Chargen_Data     : constant Byte_Array (0 .. TCP_Sockets.TCP_MSS - 1) := [others => Character'Pos ('*')];
 
    function Tick_Count_Expired
       (Flash_Count : Unsigned_32;
        Timeout     : Unsigned_32)
       return Boolean;
+   function RTC_Seconds
+      return Unsigned_32;
+   function Lease_Load
+      return DHCP_Client.Lease_Type;
+   procedure Lease_Save
+      (Lease : in DHCP_Client.Lease_Type);
+   procedure Stats_Send
+      (Address : in TCPIP.IPv4_Address_Type;
+       Port    : in Unsigned_16);
    procedure Handle_Ethernet;
 
    --========================================================================--
@@ -83,20 +126,191 @@ package body Application
       return (BSP.Tick_Count - Flash_Count) > Timeout;
    end Tick_Count_Expired;
 
+   ----------------------------------------------------------------------------
+   -- RTC_Seconds
+   ----------------------------------------------------------------------------
+   -- Return the RTC time as seconds since 1970-01-01 00:00:00.
+   ----------------------------------------------------------------------------
+   function RTC_Seconds
+      return Unsigned_32
+      is
+      TM : Time.TM_Time;
+   begin
+      MC146818A.Time_Read (BSP.RTC_Descriptor, TM);
+      return Unsigned_32 (Time.Make_Time (TM.Year + 1_900, TM.Mon + 1, TM.MDay, TM.Hour, TM.Min, TM.Sec));
+   end RTC_Seconds;
+
+   ----------------------------------------------------------------------------
+   -- Lease_Load
+   ----------------------------------------------------------------------------
+   -- Read the DHCP lease saved by the last boot from the root directory of
+   -- the FAT volume. An expired lease is dropped, otherwise its time is cut
+   -- down to what is left of it.
+   ----------------------------------------------------------------------------
+   function Lease_Load
+      return DHCP_Client.Lease_Type
+      is
+      DCB     : FATFS.DCB_Type;
+      File    : FATFS.FCB_Type;
+      B       : BlockDevices.Block_Type (0 .. 511);
+      Data    : Lease_Record_Type
+         with Address    => B'Address,
+              Import     => True,
+              Convention => Ada;
+      Lease   : DHCP_Client.Lease_Type;
+      Now     : Unsigned_32;
+      Count   : Unsigned_32;
+      Success : Boolean;
+   begin
+      if not Fatfs_Mounted then
+         return DHCP_Client.LEASE_INVALID;
+      end if;
+      FATFS.Directory.Open_Root (Fatfs_Object, DCB, Success);
+      if Success then
+         FATFS.Rawfile.Open (Fatfs_Object, File, DCB, DHCP_LEASE_FILE, Success);
+      end if;
+      if not Success then
+         return DHCP_Client.LEASE_INVALID;
+      end if;
+      FATFS.Rawfile.Read_Cluster (Fatfs_Object, File, B, Count, Success);
+      FATFS.Rawfile.Close (Fatfs_Object, File);
+      if not Success or else Natural (Count) < Data'Size / Storage_Unit then
+         return DHCP_Client.LEASE_INVALID;
+      end if;
+      Lease := Data.Lease;
+      if Lease.Lease_Time /= DHCP_Client.LEASE_INFINITE then
+         Now := RTC_Seconds;
+         -- a clock behind the grant time cannot tell the age of the lease
+         if Now < Data.Granted or else Now - Data.Granted >= Lease.Lease_Time then
+            return DHCP_Client.LEASE_INVALID;
+         end if;
+         Lease.Lease_Time := @ - (Now - Data.Granted);
+      end if;
+      return Lease;
+   end Lease_Load;
+
+   ----------------------------------------------------------------------------
+   -- Lease_Save
+   ----------------------------------------------------------------------------
+   -- Called by the DHCP client when a lease is granted or dropped.
+   ----------------------------------------------------------------------------
+   procedure Lease_Save
+      (Lease : in DHCP_Client.Lease_Type)
+      is
+      DCB     : FATFS.DCB_Type;
+      File    : FATFS.WCB_Type;
+      B       : BlockDevices.Block_Type (0 .. 511);
+      Data    : Lease_Record_Type
+         with Address    => B'Address,
+              Import     => True,
+              Convention => Ada;
+      Success : Boolean;
+   begin
+      if not Fatfs_Mounted then
+         return;
+      end if;
+      FATFS.Directory.Open_Root (Fatfs_Object, DCB, Success);
+      if Success then
+         FATFS.Rawfile.Open (Fatfs_Object, File, DCB, DHCP_LEASE_FILE, Success);
+         if not Success then
+            FATFS.Directory.Open_Root (Fatfs_Object, DCB, Success);
+            if Success then
+               FATFS.Rawfile.Create (Fatfs_Object, File, DCB, DHCP_LEASE_FILE, Success);
+            end if;
+         end if;
+      end if;
+      if Success then
+         B := [others => 0];
+         Data := (Lease => Lease, Granted => RTC_Seconds);
+         FATFS.Rawfile.Write (Fatfs_Object, File, B, Unsigned_16 (Data'Size / Storage_Unit), Success);
+         FATFS.Rawfile.Close (Fatfs_Object, File, Success);
+      end if;
+   end Lease_Save;
+
+   ----------------------------------------------------------------------------
+   -- Stats_Send
+   ----------------------------------------------------------------------------
+   procedure Stats_Send
+      (Address : in TCPIP.IPv4_Address_Type;
+       Port    : in Unsigned_16)
+      is
+      NE2000_Descriptor : NE2000.Descriptor_Type renames BSP.NE2000_Descriptors (1);
+      Counters          : Ethernet.Counters_Type;
+      Stats             : U32_Array (0 .. 7);
+      Success           : Boolean;
+   begin
+      if NE2000_Descriptor.Interface_Id = Ethernet.NO_INTERFACE then
+         return;
+      end if;
+      Counters := Ethernet.Counters (NE2000_Descriptor.Interface_Id);
+      Stats := [
+         HToN (Counters.RX_Frames),
+         HToN (Counters.RX_Bytes),
+         HToN (Counters.RX_Dropped),
+         HToN (Counters.TX_Frames),
+         HToN (Counters.TX_Bytes),
+         HToN (NE2000_Descriptor.RX_Frames),
+         HToN (NE2000_Descriptor.RX_Dropped),
+         HToN (UDP_Sockets.Drops (Echo_Socket))
+         ];
+      UDP_Sockets.Send_To (Stats_Socket, Address, Port, Stats'Address, Stats'Length * 4, Success);
+   end Stats_Send;
+
    ----------------------------------------------------------------------------
    -- Handle_Ethernet
    ----------------------------------------------------------------------------
    procedure Handle_Ethernet
       is
+      Packets : Ethernet.Pbuf_Array (1 .. 4);
+      Count   : Natural;
       P       : PBUF.Pbuf_Ptr;
+      Length  : Natural;
+      Address : TCPIP.IPv4_Address_Type;
+      Port    : Unsigned_16;
       Success : Boolean;
    begin
       -- PPI_DataOut (Unsigned_8 (PBUF.Nalloc));                                      -- # of PBUFs allocated
-      -- PPI_StatusOut (Unsigned_8 (Ethernet.Nqueue (Ethernet.Packet_Queue'Access))); -- # of items in queue
-      Ethernet.Dequeue (Ethernet.Packet_Queue'Access, P, Success);
-      if Success then
-         Ethernet.Packet_Handler (P);
+      -- PPI_StatusOut (Unsigned_8 (Ethernet.Nqueue (Ethernet.Packet_Queues (1)'Access))); -- # of items in queue
+      Ethernet.Poll;
+      for Id in 1 .. Ethernet.Interface_Count loop
+         Ethernet.Dequeue_Batch (Ethernet.Packet_Queues (Id)'Access, Packets, Count);
+         for Index in 1 .. Count loop
+            Ethernet.Packet_Handler (Id, Packets (Index));
+            PBUF.Free (Packets (Index));
+         end loop;
+      end loop;
+      DHCP_Client.Service;
+      -- UDP echo service
+      loop
+         UDP_Sockets.Receive_From (Echo_Socket, P, Length, Address, Port, Success);
+         exit when not Success;
+         Length := Natural'Min (Length, Echo_Data'Length);
+         PBUF.Copy_Partial (P, Echo_Data'Address, Length);
          PBUF.Free (P);
+         UDP_Sockets.Send_To (Echo_Socket, Address, Port, Echo_Data'Address, Length, Success);
+      end loop;
+      -- benchmark statistics service
+      loop
+         UDP_Sockets.Receive_From (Stats_Socket, P, Length, Address, Port, Success);
+         exit when not Success;
+         PBUF.Free (P);
+         Stats_Send (Address, Port);
+      end loop;
+      -- TCP chargen service, the same constant buffer is queued over and over
+      TCP_Sockets.Service;
+      if Chargen_Socket = TCP_Sockets.NO_SOCKET then
+         TCP_Sockets.Accept_Connection (Chargen_Listener, Chargen_Socket);
+      end if;
+      if Chargen_Socket /= TCP_Sockets.NO_SOCKET then
+         if TCP_Sockets.State (Chargen_Socket) = TCP_Sockets.ESTABLISHED then
+            loop
+               TCP_Sockets.Send (Chargen_Socket, Chargen_Data'Address, Chargen_Data'Length, Success);
+               exit when not Success;
+            end loop;
+         else
+            TCP_Sockets.Close (Chargen_Socket);
+            Chargen_Socket := TCP_Sockets.NO_SOCKET;
+         end if;
       end if;
    end Handle_Ethernet;
 
@@ -161,14 +375,15 @@ package body Application
             Success   : Boolean;
             Partition : MBR.Partition_Entry_Type;
          begin
-            MBR.Read (BSP.IDE_Descriptors (1)'Access, MBR.PARTITION1, Partition, Success);
+            MBR.Read (BSP.IDE_Block_Devices (1)'Access, MBR.PARTITION1, Partition, Success);
             if Success then
-               Fatfs_Object.Device := BSP.IDE_Descriptors (1)'Access;
+               Fatfs_Object.Device := BSP.IDE_Block_Devices (1)'Access;
                FATFS.Open
                   (Fatfs_Object,
                    BlockDevices.Sector_Type (Partition.LBA_Start),
                    Success);
                if Success then
+                  Fatfs_Mounted := True;
                   FATFS.Applications.Test (Fatfs_Object);
                   FATFS.Applications.Load_AUTOEXECBAT (Fatfs_Object);
                end if;
@@ -182,14 +397,23 @@ package body Application
       -------------------------------------------------------------------------
       if True then
          declare
-            TC1 : Unsigned_32 := BSP.Tick_Count;
-            TC2 : Unsigned_32 := BSP.Tick_Count;
+            TC2     : Unsigned_32 := BSP.Tick_Count;
+            Success : Boolean;
          begin
+            if Configure.USE_DHCP and then BSP.NE2000_Descriptors (1).Interface_Id /= Ethernet.NO_INTERFACE then
+               DHCP_Client.Start (
+                  BSP.NE2000_Descriptors (1).Interface_Id,
+                  Lease_Load,
+                  Lease_Save'Access,
+                  Success
+                  );
+            end if;
+            UDP_Sockets.Bind (UDP_ECHO_PORT, Echo_Socket);
+            UDP_Sockets.Bind (UDP_STATS_PORT, Stats_Socket);
+            TCP_Sockets.Listen (TCP_CHARGEN_PORT, Chargen_Listener);
             loop
-               if Tick_Count_Expired (TC1, 50) then
-                  Handle_Ethernet;
-                  TC1 := BSP.Tick_Count;
-               end if;
+               -- poll the stack on every pass, the TCP clock paces itself
+               Handle_Ethernet;
                if Tick_Count_Expired (TC2, 300) then
                   TC2 := BSP.Tick_Count;
                end if;
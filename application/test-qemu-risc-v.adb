@@ -8,9 +8,17 @@ with Bits;
 with CPU;
 with RISCV;
 with Virt;
+with FATFS;
+with FATFS.Applications;
 with Console;
 with BSP;
 with Goldfish;
+with PBUF;
+with Ethernet;
+with TCPIP;
+with UDP_Sockets;
+with Timers;
+with Configure;
 with Time;
 with LLutils;
 with Mutex;
@@ -56,6 +64,25 @@ package body Application
    -- Console mutex
    M : Mutex.Semaphore_Binary := Mutex.SEMAPHORE_UNLOCKED;
 
+   Fatfs_Object : FATFS.Descriptor_Type;
+
+   -- UDP echo exercise over the loopback interface: a client socket sends
+   -- a sequence number to the echo port of 127.0.0.1 once per second
+   UDP_ECHO_PORT   : constant := 7; -- RFC 862
+   UDP_CLIENT_PORT : constant := 1_024;
+   Echo_Socket     : UDP_Sockets.Socket_Type := UDP_Sockets.NO_SOCKET;
+   Client_Socket   : UDP_Sockets.Socket_Type := UDP_Sockets.NO_SOCKET;
+   Echo_Data       : Bits.Byte_Array (0 .. UDP_Sockets.UDP_PAYLOAD_SIZE - 1);
+   Probe_Sequence  : Unsigned_32 := 0;
+   Probes_Sent     : Unsigned_32 := 0;
+   Echoes_Served   : Unsigned_32 := 0;
+   Replies_OK      : Unsigned_32 := 0;
+   Replies_Bad     : Unsigned_32 := 0;
+
+   procedure Handle_Ethernet;
+   procedure Probe_Send;
+   procedure Echo_Statistics;
+
    procedure StartAP;
 
    --========================================================================--
@@ -97,12 +124,109 @@ package body Application
       end loop;
    end StartAP;
 
+   ----------------------------------------------------------------------------
+   -- Handle_Ethernet
+   ----------------------------------------------------------------------------
+   procedure Handle_Ethernet
+      is
+      Packets : Ethernet.Pbuf_Array (1 .. 4);
+      Count   : Natural;
+      P       : PBUF.Pbuf_Ptr;
+      Length  : Natural;
+      Address : TCPIP.IPv4_Address_Type;
+      Port    : Unsigned_16;
+      Reply   : Unsigned_32;
+      Success : Boolean;
+   begin
+      Ethernet.Poll;
+      for Id in 1 .. Ethernet.Interface_Count loop
+         Ethernet.Dequeue_Batch (Ethernet.Packet_Queues (Id)'Access, Packets, Count);
+         for Index in 1 .. Count loop
+            Ethernet.Packet_Handler (Id, Packets (Index));
+            PBUF.Free (Packets (Index));
+         end loop;
+      end loop;
+      -- UDP echo service
+      loop
+         UDP_Sockets.Receive_From (Echo_Socket, P, Length, Address, Port, Success);
+         exit when not Success;
+         Length := Natural'Min (Length, Echo_Data'Length);
+         PBUF.Copy_Partial (P, Echo_Data'Address, Length);
+         PBUF.Free (P);
+         UDP_Sockets.Send_To (Echo_Socket, Address, Port, Echo_Data'Address, Length, Success);
+         if Success then
+            Echoes_Served := @ + 1;
+         end if;
+      end loop;
+      -- client side, the reply must carry back the last sequence number
+      loop
+         UDP_Sockets.Receive_From (Client_Socket, P, Length, Address, Port, Success);
+         exit when not Success;
+         if Length = 4 and then Port = UDP_ECHO_PORT then
+            PBUF.Copy_Partial (P, Reply'Address, 4);
+            if Reply = Probe_Sequence then
+               Replies_OK := @ + 1;
+            else
+               Replies_Bad := @ + 1;
+            end if;
+         else
+            Replies_Bad := @ + 1;
+         end if;
+         PBUF.Free (P);
+      end loop;
+   end Handle_Ethernet;
+
+   ----------------------------------------------------------------------------
+   -- Probe_Send
+   ----------------------------------------------------------------------------
+   procedure Probe_Send
+      is
+      Success : Boolean;
+   begin
+      Probe_Sequence := @ + 1;
+      UDP_Sockets.Send_To (
+         Client_Socket,
+         [127, 0, 0, 1],
+         UDP_ECHO_PORT,
+         Probe_Sequence'Address,
+         4,
+         Success
+         );
+      if Success then
+         Probes_Sent := @ + 1;
+      end if;
+   end Probe_Send;
+
+   ----------------------------------------------------------------------------
+   -- Echo_Statistics
+   ----------------------------------------------------------------------------
+   procedure Echo_Statistics
+      is
+   begin
+      Console.Print (Prefix => "UDP echo: sent ", Value => Probes_Sent);
+      Console.Print (Prefix => " served ", Value => Echoes_Served);
+      Console.Print (Prefix => " ok ", Value => Replies_OK);
+      Console.Print (Prefix => " bad ", Value => Replies_Bad);
+      Console.Print (Prefix => " drops ", Value => UDP_Sockets.Drops (Echo_Socket), NL => True);
+   end Echo_Statistics;
+
    ----------------------------------------------------------------------------
    -- Run
    ----------------------------------------------------------------------------
    procedure Run
       is
    begin
+      -- RAM disk -------------------------------------------------------------
+      if BSP.RAMDisk_Block_Device.Read_Blocks /= null then
+         declare
+            Success : Boolean;
+         begin
+            FATFS.Applications.Mount (Fatfs_Object, BSP.RAMDisk_Block_Device'Access, Success);
+            if Success then
+               FATFS.Applications.Load_AUTOEXECBAT (Fatfs_Object);
+            end if;
+         end;
+      end if;
       -- start "application" harts --------------------------------------------
       if True then
          declare
@@ -119,23 +243,31 @@ package body Application
       -------------------------------------------------------------------------
       if True then
          declare
-            Delay_Count : constant := 300_000_000;
-            TM          : Time.TM_Time;
+            Deadline : Unsigned_32 := BSP.Tick_Count;
+            TM       : Time.TM_Time;
          begin
+            UDP_Sockets.Bind (UDP_ECHO_PORT, Echo_Socket);
+            UDP_Sockets.Bind (UDP_CLIENT_PORT, Client_Socket);
             loop
-               Goldfish.Time_Read (BSP.RTC_Descriptor, TM);
-               Mutex.Acquire (M);
-               Console.Print (Prefix => "",  Value =>
-                  Time.Day_Of_Week (Time.NDay_Of_Week (TM.MDay, TM.Mon + 1, TM.Year + 1_900)));
-               Console.Print (Prefix => " ", Value => Time.Month_Name (TM.Mon + 1));
-               Console.Print (Prefix => " ", Value => TM.MDay);
-               Console.Print (Prefix => " ", Value => TM.Year + 1_900);
-               Console.Print (Prefix => " ", Value => TM.Hour);
-               Console.Print (Prefix => ":", Value => TM.Min);
-               Console.Print (Prefix => ":", Value => TM.Sec);
-               Console.Print_NewLine;
-               Mutex.Release (M);
-               for Delay_Loop_Count in 1 .. Delay_Count loop CPU.NOP; end loop;
+               -- poll the stack on every pass, the loopback delivers on ticks
+               Handle_Ethernet;
+               if Timers.Expired (Deadline, BSP.Tick_Count) then
+                  Deadline := @ + Configure.TICK_FREQUENCY; -- 1 s
+                  Probe_Send;
+                  Goldfish.Time_Read (BSP.RTC_Descriptor, TM);
+                  Mutex.Acquire (M);
+                  Console.Print (Prefix => "",  Value =>
+                     Time.Day_Of_Week (Time.NDay_Of_Week (TM.MDay, TM.Mon + 1, TM.Year + 1_900)));
+                  Console.Print (Prefix => " ", Value => Time.Month_Name (TM.Mon + 1));
+                  Console.Print (Prefix => " ", Value => TM.MDay);
+                  Console.Print (Prefix => " ", Value => TM.Year + 1_900);
+                  Console.Print (Prefix => " ", Value => TM.Hour);
+                  Console.Print (Prefix => ":", Value => TM.Min);
+                  Console.Print (Prefix => ":", Value => TM.Sec);
+                  Console.Print_NewLine;
+                  Echo_Statistics;
+                  Mutex.Release (M);
+               end if;
             end loop;
          end;
       end if;
@@ -0,0 +1,22 @@
+
+/*
+ * string-asm.h - Assembler string kernels.
+ *
+ * Copyright (C) 2020-2026 Gabriele Galeotti
+ *
+ * This work is licensed under the terms of the MIT License.
+ * Please consult the LICENSE.txt file located in the top-level directory.
+ */
+
+#ifndef _STRING_ASM_H
+#define _STRING_ASM_H 1
+
+/*
+ * Default header: no CPU-specific kernels, all functions in string.c are
+ * compiled in their portable version. A CPU which sets
+ * CLIBRARY_STRING_ASM_DIRECTORY in its configuration.in provides there its
+ * own string-asm.h (which takes precedence over this one) together with
+ * string-asm.S, defining STRING_ASM_<function> for every function supplied.
+ */
+
+#endif /* _STRING_ASM_H */
@@ -13,6 +13,9 @@
 #include <ctype.h>
 #include <stdbool.h>
 #include <string.h>
+#include <string-asm.h>
+
+#if !defined(STRING_ASM_MEMCHR)
 
 /******************************************************************************
  * void *memchr(const void *s, int c, size_t n)                               *
@@ -38,6 +41,8 @@ memchr(const void *s, int c, size_t n)
         return NULL;
 }
 
+#endif
+
 #if defined(ENABLE_MEMORY_FUNCTIONS)
 
 /******************************************************************************
@@ -209,6 +214,8 @@ strcat(char *s1, const char *s2)
         return p;
 }
 
+#if !defined(STRING_ASM_STRCHR)
+
 /******************************************************************************
  * char *strchr(const char *s, int c)                                         *
  *                                                                            *
@@ -229,6 +236,10 @@ strchr(const char *s, int c)
         return (char *)s;
 }
 
+#endif
+
+#if !defined(STRING_ASM_STRCMP)
+
 /******************************************************************************
  * int strcmp(const char *s1, const char *s2)                                 *
  *                                                                            *
@@ -255,6 +266,8 @@ strcmp(const char *s1, const char *s2)
         return result;
 }
 
+#endif
+
 /******************************************************************************
  * char *strcpy(char *s1, const char *s2)                                     *
  *                                                                            *
@@ -302,6 +315,8 @@ strcspn(const char *s1, const char *s2)
         return count;
 }
 
+#if !defined(STRING_ASM_STRLEN)
+
 /******************************************************************************
  * size_t strlen(const char *s)                                               *
  *                                                                            *
@@ -320,6 +335,8 @@ strlen(const char *s)
         return (size_t)(p - s);
 }
 
+#endif
+
 /******************************************************************************
  * int strncasecmp(const char *s1, const char *s2, size_t n)                  *
  *                                                                            *
@@ -293,4 +293,36 @@ package body LLutils
       is
    separate;
 
+   ----------------------------------------------------------------------------
+   -- Atomic_Load_32
+   ----------------------------------------------------------------------------
+   function Atomic_Load_32
+      (Object_Address : System.Address;
+       Memory_Order   : Integer)
+      return Interfaces.Unsigned_32
+      is
+   separate;
+
+   ----------------------------------------------------------------------------
+   -- Atomic_Store_32
+   ----------------------------------------------------------------------------
+   procedure Atomic_Store_32
+      (Object_Address : in System.Address;
+       Value          : in Interfaces.Unsigned_32;
+       Memory_Order   : in Integer)
+      is
+   separate;
+
+   ----------------------------------------------------------------------------
+   -- Atomic_Compare_Exchange_32
+   ----------------------------------------------------------------------------
+   function Atomic_Compare_Exchange_32
+      (Object_Address : System.Address;
+       Expected       : Interfaces.Unsigned_32;
+       Desired        : Interfaces.Unsigned_32;
+       Memory_Order   : Integer)
+      return Boolean
+      is
+   separate;
+
 end LLutils;
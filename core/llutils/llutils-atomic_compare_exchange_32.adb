@@ -0,0 +1,59 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ llutils-atomic_compare_exchange_32                                                                        --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with GCC.Defines;
+
+separate (LLutils)
+function Atomic_Compare_Exchange_32
+   (Object_Address : System.Address;
+    Expected       : Interfaces.Unsigned_32;
+    Desired        : Interfaces.Unsigned_32;
+    Memory_Order   : Integer)
+   return Boolean
+   is
+   function ACE
+      (OA  : System.Address;
+       EA  : System.Address;
+       D   : Interfaces.Unsigned_32;
+       W   : Boolean;
+       SMO : Integer;
+       FMO : Integer)
+      return Boolean
+      with Import        => True,
+           Convention    => Intrinsic,
+           External_Name => "__atomic_compare_exchange_4";
+   Expected_Value : aliased Interfaces.Unsigned_32 := Expected;
+   Object         : Interfaces.Unsigned_32
+      with Address    => Object_Address,
+           Volatile   => True,
+           Import     => True,
+           Convention => Ada;
+   use type Interfaces.Unsigned_32;
+begin
+   if GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+      -- strong exchange, relaxed ordering on failure
+      return ACE (Object_Address, Expected_Value'Address, Desired, False, Memory_Order, GCC.Defines.ATOMIC_RELAXED);
+   else
+      -- no native CAS (and no libatomic to call): plain compare and store,
+      -- the caller is responsible for masking interrupts around it
+      if Object /= Expected then
+         return False;
+      end if;
+      Object := Desired;
+      return True;
+   end if;
+end Atomic_Compare_Exchange_32;
@@ -0,0 +1,33 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ llutils-atomic_load_32                                                                                    --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+separate (LLutils)
+function Atomic_Load_32
+   (Object_Address : System.Address;
+    Memory_Order   : Integer)
+   return Interfaces.Unsigned_32
+   is
+   function AL
+      (OA : System.Address;
+       MO : Integer)
+      return Interfaces.Unsigned_32
+      with Import        => True,
+           Convention    => Intrinsic,
+           External_Name => "__atomic_load_4";
+begin
+   return AL (Object_Address, Memory_Order);
+end Atomic_Load_32;
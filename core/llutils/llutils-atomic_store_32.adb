@@ -0,0 +1,33 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ llutils-atomic_store_32                                                                                   --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+separate (LLutils)
+procedure Atomic_Store_32
+   (Object_Address : in System.Address;
+    Value          : in Interfaces.Unsigned_32;
+    Memory_Order   : in Integer)
+   is
+   procedure AS
+      (OA : in System.Address;
+       V  : in Interfaces.Unsigned_32;
+       MO : in Integer)
+      with Import        => True,
+           Convention    => Intrinsic,
+           External_Name => "__atomic_store_4";
+begin
+   AS (Object_Address, Value, Memory_Order);
+end Atomic_Store_32;
@@ -14,10 +14,11 @@
 -- This work is licensed under the terms of the MIT License.                                                         --
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
-
 pragma Restrictions (No_Elaboration_Code);
 
 with System.Storage_Elements;
+with Ada.Unchecked_Conversion;
+with Interfaces;
 with Integer_Math;
 with Mutex;
 with Console;
@@ -35,29 +36,85 @@ package body Malloc
 
    use System;
    use System.Storage_Elements;
+   use Interfaces;
    use Bits;
    use Integer_Math;
 
+   --------------------------------------------------------------------------
+   -- Two-Level Segregated Fit (TLSF) allocator.
+   --
+   -- Free blocks are kept in segregated doubly linked lists. The first level
+   -- index selects a power-of-two size range, the second level index
+   -- selects a linear subdivision of that range. Two bitmaps record which
+   -- lists are non-empty, so that a suitable free block is located with a
+   -- bounded number of operations, regardless of the heap history.
+   -- Physically adjacent blocks are linked by boundary tags, and a block is
+   -- coalesced with its free neighbours as soon as it is released. Blocks
+   -- larger than LARGE_BLOCK_SIZE are not size-segregated and live in a
+   -- single first-fit list.
+   --------------------------------------------------------------------------
+
    DEFAULT_ALIGNMENT    : constant := 16;
+   ALIGNMENT_LOG2       : constant := 4;
    -- Size includes Memory_Block tag
    MEMORYBLOCKTYPE_SIZE : constant :=
       DEFAULT_ALIGNMENT * ((
          ((Interfaces.C.size_t'Size + Standard'Address_Size) / Storage_Unit)
          + DEFAULT_ALIGNMENT - 1
          ) / DEFAULT_ALIGNMENT);
+   -- free list links overlap user data
+   FREELINKS_SIZE       : constant :=
+      DEFAULT_ALIGNMENT * ((
+         (2 * Standard'Address_Size / Storage_Unit)
+         + DEFAULT_ALIGNMENT - 1
+         ) / DEFAULT_ALIGNMENT);
+   MIN_BLOCK_SIZE       : constant := MEMORYBLOCKTYPE_SIZE + FREELINKS_SIZE;
+
+   SL_INDEX_COUNT_LOG2  : constant := 4;
+   SL_INDEX_COUNT       : constant := 2**SL_INDEX_COUNT_LOG2;
+   FL_INDEX_SHIFT       : constant := SL_INDEX_COUNT_LOG2 + ALIGNMENT_LOG2;
+   SMALL_BLOCK_SIZE     : constant := 2**FL_INDEX_SHIFT;
+   LARGE_BLOCK_LOG2     : constant := 24;
+   LARGE_BLOCK_SIZE     : constant := 2**LARGE_BLOCK_LOG2;
+   -- FL index 0 holds small blocks, the last FL index holds large blocks
+   FL_INDEX_COUNT       : constant := LARGE_BLOCK_LOG2 - FL_INDEX_SHIFT + 2;
+   FL_LARGE_INDEX       : constant := FL_INDEX_COUNT - 1;
+
+   subtype FL_Index_Type is Natural range 0 .. FL_INDEX_COUNT - 1;
+   subtype SL_Index_Type is Natural range 0 .. SL_INDEX_COUNT - 1;
 
    type Memory_Block_Type;
    type Memory_Block_Ptr is access all Memory_Block_Type;
 
+   -- Size includes Memory_Block tag, and bit #0 flags a free block;
+   -- Next_Ptr and Prev_Ptr are meaningful only in free blocks
    type Memory_Block_Type is record
-      Size     : Interfaces.C.size_t;
-      Next_Ptr : Memory_Block_Ptr;
+      Size          : Interfaces.C.size_t;
+      Prev_Phys_Ptr : Memory_Block_Ptr;
+      Next_Ptr      : Memory_Block_Ptr;
+      Prev_Ptr      : Memory_Block_Ptr;
    end record
-      with Pack      => True,
-           Alignment => DEFAULT_ALIGNMENT,
-           Size      => MEMORYBLOCKTYPE_SIZE * Storage_Unit;
+      with Alignment => DEFAULT_ALIGNMENT,
+           Size      => MIN_BLOCK_SIZE * Storage_Unit;
+   for Memory_Block_Type use record
+      Size          at 0                                                           range 0 .. Interfaces.C.size_t'Size - 1;
+      Prev_Phys_Ptr at Interfaces.C.size_t'Size / Storage_Unit                     range 0 .. Standard'Address_Size - 1;
+      Next_Ptr      at MEMORYBLOCKTYPE_SIZE                                        range 0 .. Standard'Address_Size - 1;
+      Prev_Ptr      at MEMORYBLOCKTYPE_SIZE + Standard'Address_Size / Storage_Unit range 0 .. Standard'Address_Size - 1;
+   end record;
+
+   BLOCK_FREE : constant Interfaces.C.size_t := 1;
 
-   Heap_Descriptor : aliased Memory_Block_Type := (Size => 0, Next_Ptr => null);
+   function To_MBP is new Ada.Unchecked_Conversion (Address, Memory_Block_Ptr);
+
+   FL_Bitmap  : Unsigned_32 := 0;
+   SL_Bitmap  : array (FL_Index_Type) of Unsigned_32 := [others => 0];
+   Free_Lists : array (0 .. FL_INDEX_COUNT * SL_INDEX_COUNT - 1) of Memory_Block_Ptr := [others => null];
+
+   Heap_Start : Address := Null_Address;
+   Heap_End   : Address := Null_Address;
+
+   Stats : Statistics_Type := (others => 0);
 
    Mtx : Mutex.Semaphore_Binary := Mutex.SEMAPHORE_UNLOCKED;
 
@@ -69,6 +126,55 @@ package body Malloc
       return Interfaces.C.size_t
       with Inline => True;
 
+   function FLS
+      (Value : Unsigned_32)
+      return Natural
+      with Inline => True;
+
+   function FFS
+      (Value : Unsigned_32)
+      return Natural
+      with Inline => True;
+
+   function Block_Size
+      (Memory_Block : Memory_Block_Ptr)
+      return Interfaces.C.size_t
+      with Inline => True;
+
+   function Is_Free
+      (Memory_Block : Memory_Block_Ptr)
+      return Boolean
+      with Inline => True;
+
+   function Next_Physical
+      (Memory_Block : Memory_Block_Ptr)
+      return Memory_Block_Ptr
+      with Inline => True;
+
+   procedure Mapping
+      (Size     : in     Interfaces.C.size_t;
+       FL_Index :    out FL_Index_Type;
+       SL_Index :    out SL_Index_Type)
+      with Inline => True;
+
+   procedure Insert_Free
+      (Memory_Block : in Memory_Block_Ptr);
+
+   procedure Remove_Free
+      (Memory_Block : in Memory_Block_Ptr);
+
+   function Locate_Free
+      (Size : Interfaces.C.size_t)
+      return Memory_Block_Ptr;
+
+   procedure Split_Block
+      (Memory_Block : in Memory_Block_Ptr;
+       Size         : in Interfaces.C.size_t);
+
+   function Size_Log2
+      (Size : Interfaces.C.size_t)
+      return Natural;
+
    --========================================================================--
    --                                                                        --
    --                                                                        --
@@ -89,6 +195,274 @@ package body Malloc
       return Interfaces.C.size_t (Roundup (Natural (Size), Alignment));
    end Round_Size;
 
+   ----------------------------------------------------------------------------
+   -- FLS
+   ----------------------------------------------------------------------------
+   -- Return the index of the most significant bit set, Value /= 0.
+   ----------------------------------------------------------------------------
+   function FLS
+      (Value : Unsigned_32)
+      return Natural
+      is
+      V      : Unsigned_32 := Value;
+      Result : Natural := 0;
+   begin
+      if V >= 2**16 then
+         V := Shift_Right (V, 16);
+         Result := @ + 16;
+      end if;
+      if V >= 2**8 then
+         V := Shift_Right (V, 8);
+         Result := @ + 8;
+      end if;
+      if V >= 2**4 then
+         V := Shift_Right (V, 4);
+         Result := @ + 4;
+      end if;
+      if V >= 2**2 then
+         V := Shift_Right (V, 2);
+         Result := @ + 2;
+      end if;
+      if V >= 2**1 then
+         Result := @ + 1;
+      end if;
+      return Result;
+   end FLS;
+
+   ----------------------------------------------------------------------------
+   -- FFS
+   ----------------------------------------------------------------------------
+   -- Return the index of the least significant bit set, Value /= 0.
+   ----------------------------------------------------------------------------
+   function FFS
+      (Value : Unsigned_32)
+      return Natural
+      is
+   begin
+      -- isolate the lowest bit set
+      return FLS (Value and (-Value));
+   end FFS;
+
+   ----------------------------------------------------------------------------
+   -- Size_Log2
+   ----------------------------------------------------------------------------
+   -- Return floor(log2(Size)), Size /= 0.
+   ----------------------------------------------------------------------------
+   function Size_Log2
+      (Size : Interfaces.C.size_t)
+      return Natural
+      is
+      use type Interfaces.C.size_t;
+      Value  : Interfaces.C.size_t := Size;
+      Result : Natural := 0;
+   begin
+      while Value > 1 loop
+         Value := Shift_Right (Value, 1);
+         Result := @ + 1;
+      end loop;
+      return Result;
+   end Size_Log2;
+
+   ----------------------------------------------------------------------------
+   -- Block_Size
+   ----------------------------------------------------------------------------
+   function Block_Size
+      (Memory_Block : Memory_Block_Ptr)
+      return Interfaces.C.size_t
+      is
+      use type Interfaces.C.size_t;
+   begin
+      return Memory_Block.all.Size and not BLOCK_FREE;
+   end Block_Size;
+
+   ----------------------------------------------------------------------------
+   -- Is_Free
+   ----------------------------------------------------------------------------
+   function Is_Free
+      (Memory_Block : Memory_Block_Ptr)
+      return Boolean
+      is
+      use type Interfaces.C.size_t;
+   begin
+      return (Memory_Block.all.Size and BLOCK_FREE) /= 0;
+   end Is_Free;
+
+   ----------------------------------------------------------------------------
+   -- Next_Physical
+   ----------------------------------------------------------------------------
+   function Next_Physical
+      (Memory_Block : Memory_Block_Ptr)
+      return Memory_Block_Ptr
+      is
+   begin
+      return To_MBP (Memory_Block.all'Address + Storage_Offset (Block_Size (Memory_Block)));
+   end Next_Physical;
+
+   ----------------------------------------------------------------------------
+   -- Mapping
+   ----------------------------------------------------------------------------
+   -- Compute the free list indexes of a block size.
+   ----------------------------------------------------------------------------
+   procedure Mapping
+      (Size     : in     Interfaces.C.size_t;
+       FL_Index :    out FL_Index_Type;
+       SL_Index :    out SL_Index_Type)
+      is
+      use type Interfaces.C.size_t;
+      Size32 : Unsigned_32;
+      F      : Natural;
+   begin
+      if Size < SMALL_BLOCK_SIZE then
+         FL_Index := 0;
+         SL_Index := SL_Index_Type (Size / (SMALL_BLOCK_SIZE / SL_INDEX_COUNT));
+      elsif Size < LARGE_BLOCK_SIZE then
+         Size32 := Unsigned_32 (Size);
+         F := FLS (Size32);
+         FL_Index := F - FL_INDEX_SHIFT + 1;
+         SL_Index := Natural (Shift_Right (Size32, F - SL_INDEX_COUNT_LOG2) - SL_INDEX_COUNT);
+      else
+         FL_Index := FL_LARGE_INDEX;
+         SL_Index := 0;
+      end if;
+   end Mapping;
+
+   ----------------------------------------------------------------------------
+   -- Insert_Free
+   ----------------------------------------------------------------------------
+   -- Put a block at the head of its free list, Mtx must be held.
+   ----------------------------------------------------------------------------
+   procedure Insert_Free
+      (Memory_Block : in Memory_Block_Ptr)
+      is
+      use type Interfaces.C.size_t;
+      FL_Index : FL_Index_Type;
+      SL_Index : SL_Index_Type;
+      Index    : Natural;
+   begin
+      Mapping (Block_Size (Memory_Block), FL_Index, SL_Index);
+      Index := FL_Index * SL_INDEX_COUNT + SL_Index;
+      Memory_Block.all.Next_Ptr := Free_Lists (Index);
+      Memory_Block.all.Prev_Ptr := null;
+      if Free_Lists (Index) /= null then
+         Free_Lists (Index).all.Prev_Ptr := Memory_Block;
+      end if;
+      Free_Lists (Index) := Memory_Block;
+      FL_Bitmap := @ or Shift_Left (1, FL_Index);
+      SL_Bitmap (FL_Index) := @ or Shift_Left (1, SL_Index);
+      Memory_Block.all.Size := @ or BLOCK_FREE;
+      Stats.Free_Blocks := @ + 1;
+   end Insert_Free;
+
+   ----------------------------------------------------------------------------
+   -- Remove_Free
+   ----------------------------------------------------------------------------
+   -- Unlink a block from its free list, Mtx must be held.
+   ----------------------------------------------------------------------------
+   procedure Remove_Free
+      (Memory_Block : in Memory_Block_Ptr)
+      is
+      use type Interfaces.C.size_t;
+      FL_Index : FL_Index_Type;
+      SL_Index : SL_Index_Type;
+      Index    : Natural;
+   begin
+      if Memory_Block.all.Prev_Ptr /= null then
+         Memory_Block.all.Prev_Ptr.all.Next_Ptr := Memory_Block.all.Next_Ptr;
+      else
+         -- block is the list head
+         Mapping (Block_Size (Memory_Block), FL_Index, SL_Index);
+         Index := FL_Index * SL_INDEX_COUNT + SL_Index;
+         Free_Lists (Index) := Memory_Block.all.Next_Ptr;
+         if Free_Lists (Index) = null then
+            SL_Bitmap (FL_Index) := @ and not Shift_Left (1, SL_Index);
+            if SL_Bitmap (FL_Index) = 0 then
+               FL_Bitmap := @ and not Shift_Left (1, FL_Index);
+            end if;
+         end if;
+      end if;
+      if Memory_Block.all.Next_Ptr /= null then
+         Memory_Block.all.Next_Ptr.all.Prev_Ptr := Memory_Block.all.Prev_Ptr;
+      end if;
+      Memory_Block.all.Next_Ptr := null;
+      Memory_Block.all.Prev_Ptr := null;
+      Memory_Block.all.Size := @ and not BLOCK_FREE;
+      Stats.Free_Blocks := @ - 1;
+   end Remove_Free;
+
+   ----------------------------------------------------------------------------
+   -- Locate_Free
+   ----------------------------------------------------------------------------
+   -- Find a free block of at least Size bytes, Mtx must be held.
+   ----------------------------------------------------------------------------
+   function Locate_Free
+      (Size : Interfaces.C.size_t)
+      return Memory_Block_Ptr
+      is
+      use type Interfaces.C.size_t;
+      Search_Size  : Interfaces.C.size_t;
+      FL_Index     : FL_Index_Type;
+      SL_Index     : SL_Index_Type;
+      Bitmap       : Unsigned_32;
+      Memory_Block : Memory_Block_Ptr;
+   begin
+      Search_Size := Size;
+      if Size >= SMALL_BLOCK_SIZE and then Size < LARGE_BLOCK_SIZE then
+         -- round up to the next list, so that every block found there fits
+         Search_Size := @ + Shift_Left (Interfaces.C.size_t'(1), FLS (Unsigned_32 (Size)) - SL_INDEX_COUNT_LOG2) - 1;
+      end if;
+      Mapping (Search_Size, FL_Index, SL_Index);
+      Bitmap := SL_Bitmap (FL_Index) and Shift_Left (16#FFFF_FFFF#, SL_Index);
+      if Bitmap = 0 then
+         -- no list in this range, look at the next larger ones
+         Bitmap := FL_Bitmap and Shift_Left (16#FFFF_FFFF#, FL_Index + 1);
+         if Bitmap = 0 then
+            return null;
+         end if;
+         FL_Index := FFS (Bitmap);
+         Bitmap := SL_Bitmap (FL_Index);
+      end if;
+      SL_Index := FFS (Bitmap);
+      Memory_Block := Free_Lists (FL_Index * SL_INDEX_COUNT + SL_Index);
+      if FL_Index = FL_LARGE_INDEX then
+         -- large-object path, blocks are not size-segregated
+         while Memory_Block /= null and then Block_Size (Memory_Block) < Size loop
+            Memory_Block := Memory_Block.all.Next_Ptr;
+         end loop;
+      end if;
+      return Memory_Block;
+   end Locate_Free;
+
+   ----------------------------------------------------------------------------
+   -- Split_Block
+   ----------------------------------------------------------------------------
+   -- Trim a used block to Size bytes; the tail, if it is large enough to be
+   -- a block, is merged with a free following block and released. Mtx must
+   -- be held.
+   ----------------------------------------------------------------------------
+   procedure Split_Block
+      (Memory_Block : in Memory_Block_Ptr;
+       Size         : in Interfaces.C.size_t)
+      is
+      use type Interfaces.C.size_t;
+      Tail_Block : Memory_Block_Ptr;
+      Next_Block : Memory_Block_Ptr;
+   begin
+      if Block_Size (Memory_Block) - Size < MIN_BLOCK_SIZE then
+         return;
+      end if;
+      Tail_Block := To_MBP (Memory_Block.all'Address + Storage_Offset (Size));
+      Tail_Block.all.Size          := Block_Size (Memory_Block) - Size;
+      Tail_Block.all.Prev_Phys_Ptr := Memory_Block;
+      Memory_Block.all.Size        := Size;
+      Next_Block := Next_Physical (Tail_Block);
+      if Is_Free (Next_Block) then
+         Remove_Free (Next_Block);
+         Tail_Block.all.Size := @ + Block_Size (Next_Block);
+      end if;
+      Next_Physical (Tail_Block).all.Prev_Phys_Ptr := Tail_Block;
+      Insert_Free (Tail_Block);
+   end Split_Block;
+
    ----------------------------------------------------------------------------
    -- Init
    ----------------------------------------------------------------------------
@@ -97,19 +471,37 @@ package body Malloc
        Size           : in Bytesize;
        Debug_Flag     : in Boolean)
       is
-      Heap_Block : aliased Memory_Block_Type
-         with Address    => Memory_Address,
-              Import     => True,
-              Convention => Ada;
+      ALIGNMENT_MASK : constant Integer_Address := DEFAULT_ALIGNMENT - 1;
+      Start_Address  : Address;
+      End_Address    : Address;
+      Heap_Block     : Memory_Block_Ptr;
+      Sentinel_Block : Memory_Block_Ptr;
    begin
       Debug := Debug_Flag;
-      -- simulate a request to sbrk()
-      Heap_Block.Size     := Size;
-      Heap_Block.Next_Ptr := null;
+      Start_Address := To_Address ((To_Integer (Memory_Address) + ALIGNMENT_MASK) and not ALIGNMENT_MASK);
+      End_Address   := To_Address (To_Integer (Memory_Address + Storage_Offset (Size)) and not ALIGNMENT_MASK);
+      if End_Address - Start_Address < MIN_BLOCK_SIZE + MEMORYBLOCKTYPE_SIZE then
+         raise Storage_Error;
+      end if;
+      FL_Bitmap  := 0;
+      SL_Bitmap  := [others => 0];
+      Free_Lists := [others => null];
+      Heap_Start := Start_Address;
+      Heap_End   := End_Address;
+      Stats      := (others => 0);
+      Stats.Heap_Size := Interfaces.C.size_t (End_Address - Start_Address);
+      -- the whole heap is a single free block, terminated by a zero-sized
+      -- tag which is never free and stops coalescing at the heap end
+      Heap_Block := To_MBP (Start_Address);
+      Heap_Block.all.Size          := Interfaces.C.size_t (End_Address - Start_Address - MEMORYBLOCKTYPE_SIZE);
+      Heap_Block.all.Prev_Phys_Ptr := null;
+      Sentinel_Block := Next_Physical (Heap_Block);
+      Sentinel_Block.all.Size          := 0;
+      Sentinel_Block.all.Prev_Phys_Ptr := Heap_Block;
       if Debug then
          Console.Print (
             Prefix => "Initializing:         ",
-            Value  => Heap_Block.Size,
+            Value  => Heap_Block.all.Size,
             NL     => True
             );
          Console.Print (
@@ -118,7 +510,9 @@ package body Malloc
             NL     => True
             );
       end if;
-      Free (Heap_Block'Address + MEMORYBLOCKTYPE_SIZE);
+      Mutex.Acquire (Mtx);
+      Insert_Free (Heap_Block);
+      Mutex.Release (Mtx);
    end Init;
 
    ----------------------------------------------------------------------------
@@ -158,4 +552,86 @@ package body Malloc
       is
    separate;
 
+   ----------------------------------------------------------------------------
+   -- Statistics
+   ----------------------------------------------------------------------------
+   function Statistics
+      return Statistics_Type
+      is
+      use type Interfaces.C.size_t;
+      FL_Index     : FL_Index_Type;
+      SL_Index     : SL_Index_Type;
+      Memory_Block : Memory_Block_Ptr;
+      Result       : Statistics_Type;
+   begin
+      Mutex.Acquire (Mtx);
+      Result := Stats;
+      Result.Largest_Free_Block := 0;
+      if FL_Bitmap /= 0 then
+         -- the largest block lives in the highest non-empty list
+         FL_Index := FLS (FL_Bitmap);
+         SL_Index := FLS (SL_Bitmap (FL_Index));
+         Memory_Block := Free_Lists (FL_Index * SL_INDEX_COUNT + SL_Index);
+         while Memory_Block /= null loop
+            if Block_Size (Memory_Block) > Result.Largest_Free_Block then
+               Result.Largest_Free_Block := Block_Size (Memory_Block);
+            end if;
+            Memory_Block := Memory_Block.all.Next_Ptr;
+         end loop;
+      end if;
+      Mutex.Release (Mtx);
+      return Result;
+   end Statistics;
+
+   ----------------------------------------------------------------------------
+   -- Heap_Walk
+   ----------------------------------------------------------------------------
+   procedure Heap_Walk
+      (Histogram : out Histogram_Type;
+       Valid     : out Boolean)
+      is
+      use type Interfaces.C.size_t;
+      Sentinel_Address : Address;
+      Memory_Block     : Memory_Block_Ptr;
+      Prev_Block       : Memory_Block_Ptr;
+      Free_Blocks      : Interfaces.C.size_t;
+   begin
+      Histogram := [others => 0];
+      Valid := True;
+      if Heap_Start = Null_Address then
+         return;
+      end if;
+      Mutex.Acquire (Mtx);
+      Sentinel_Address := Heap_End - MEMORYBLOCKTYPE_SIZE;
+      Memory_Block := To_MBP (Heap_Start);
+      Prev_Block := null;
+      Free_Blocks := 0;
+      while Memory_Block.all'Address /= Sentinel_Address loop
+         -- a tag must be aligned, link back to its neighbour and stay
+         -- inside the heap; two free neighbours must have been coalesced
+         if
+            Memory_Block.all.Prev_Phys_Ptr /= Prev_Block                                             or else
+            Block_Size (Memory_Block) < MIN_BLOCK_SIZE                                               or else
+            Block_Size (Memory_Block) mod DEFAULT_ALIGNMENT /= 0                                     or else
+            Sentinel_Address - Memory_Block.all'Address < Storage_Offset (Block_Size (Memory_Block)) or else
+            (Is_Free (Memory_Block) and then Prev_Block /= null and then Is_Free (Prev_Block))
+         then
+            Valid := False;
+            exit;
+         end if;
+         if Is_Free (Memory_Block) then
+            Free_Blocks := @ + 1;
+            Histogram (Size_Log2 (Block_Size (Memory_Block))) := @ + 1;
+         end if;
+         Prev_Block := Memory_Block;
+         Memory_Block := Next_Physical (Memory_Block);
+      end loop;
+      if Valid then
+         Valid := Memory_Block.all.Size = 0                   and then
+                  Memory_Block.all.Prev_Phys_Ptr = Prev_Block and then
+                  Free_Blocks = Stats.Free_Blocks;
+      end if;
+      Mutex.Release (Mtx);
+   end Heap_Walk;
+
 end Malloc;
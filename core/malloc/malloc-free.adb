@@ -20,68 +20,39 @@ procedure Free
    (Memory_Address : in Interfaces.C.Extensions.void_ptr)
    is
    use Interfaces.C;
-   P            : aliased Memory_Block_Ptr;
-   Q            : aliased Memory_Block_Ptr;
-   Memory_Block : aliased Memory_Block_Type
-      with Address    => Memory_Address - MEMORYBLOCKTYPE_SIZE, -- uncover the data structure
-           Import     => True,
-           Convention => Ada;
+   Memory_Block : Memory_Block_Ptr;
+   Next_Block   : Memory_Block_Ptr;
+   Prev_Block   : Memory_Block_Ptr;
 begin
    if Memory_Address = Null_Address then
       raise Storage_Error;
    end if;
+   -- uncover the data structure
+   Memory_Block := To_MBP (Memory_Address - MEMORYBLOCKTYPE_SIZE);
    Mutex.Acquire (Mtx);
-   -- traverse the list of free blocks, sorting by address
-   P := Heap_Descriptor'Access;
-   Q := Heap_Descriptor.Next_Ptr;
-   while Q /= null and then Q.all'Address < Memory_Block'Address loop
-      P := Q;
-      Q := Q.all.Next_Ptr;
-   end loop;
+   Stats.Frees := @ + 1;
+   Stats.Bytes_In_Use := @ - Block_Size (Memory_Block);
    -- try to merge with the following block
-   if Q /= null then
-      -- following block (pointed to by Q) with higher address exists
-      declare
-         Next_Block : aliased Memory_Block_Type
-            with Address    => Memory_Block'Address + Storage_Offset (Memory_Block.Size),
-                 Import     => True,
-                 Convention => Ada;
-      begin
-         -- check if they are the same (no hole in between)
-         if Next_Block'Address = Q.all'Address then
-            Memory_Block.Size     := @ + Next_Block.Size;
-            Memory_Block.Next_Ptr := Next_Block.Next_Ptr;
-         else
-            Memory_Block.Next_Ptr := Q;
-         end if;
-      end;
-   else
-      -- this is the last block
-      Memory_Block.Next_Ptr := null;
+   Next_Block := Next_Physical (Memory_Block);
+   if Is_Free (Next_Block) then
+      Remove_Free (Next_Block);
+      Memory_Block.all.Size := @ + Block_Size (Next_Block);
+      Next_Physical (Memory_Block).all.Prev_Phys_Ptr := Memory_Block;
    end if;
    -- try to merge with the preceding block
-   if P /= Heap_Descriptor'Access then
-      declare
-         Previous_Block : aliased Memory_Block_Type
-            with Address    => P.all'Address + Storage_Offset (P.all.Size),
-                 Import     => True,
-                 Convention => Ada;
-      begin
-         if Previous_Block'Address = Memory_Block'Address then
-            P.all.Size     := @ + Memory_Block.Size;
-            P.all.Next_Ptr := Memory_Block.Next_Ptr;
-         else
-            P.all.Next_Ptr := Memory_Block'Unchecked_Access;
-         end if;
-      end;
-   else
-      Heap_Descriptor.Next_Ptr := Memory_Block'Unchecked_Access;
+   Prev_Block := Memory_Block.all.Prev_Phys_Ptr;
+   if Prev_Block /= null and then Is_Free (Prev_Block) then
+      Remove_Free (Prev_Block);
+      Prev_Block.all.Size := @ + Block_Size (Memory_Block);
+      Memory_Block := Prev_Block;
+      Next_Physical (Memory_Block).all.Prev_Phys_Ptr := Memory_Block;
    end if;
+   Insert_Free (Memory_Block);
    Mutex.Release (Mtx);
    if Debug then
       Console.Print (
          Prefix => "Free block: ",
-         Value  => Memory_Block'Address,
+         Value  => Memory_Block.all'Address,
          NL     => True
          );
    end if;
@@ -21,9 +21,8 @@ function Malloc
    return Interfaces.C.Extensions.void_ptr
    is
    use Interfaces.C;
-   RSize : size_t;
-   P     : Memory_Block_Ptr;
-   Q     : Memory_Block_Ptr;
+   RSize        : size_t;
+   Memory_Block : Memory_Block_Ptr;
 begin
    if Debug then
       Console.Print (Prefix => "Requesting: ", Value => Size, NL => True);
@@ -32,56 +31,38 @@ begin
       return Null_Address;
    end if;
    RSize := Round_Size (MEMORYBLOCKTYPE_SIZE + Size, DEFAULT_ALIGNMENT);
+   if RSize < MIN_BLOCK_SIZE then
+      -- a block must be able to hold free list links once released
+      RSize := MIN_BLOCK_SIZE;
+   end if;
    if Debug then
       Console.Print (Prefix => "Rounded size: ", Value => RSize, NL => True);
    end if;
    Mutex.Acquire (Mtx);
-   -- traverse the list of free block
-   P := Heap_Descriptor'Access;
-   Q := Heap_Descriptor.Next_Ptr;
-   while Q /= null and then Q.all.Size < RSize loop
-      P := Q;
-      Q := Q.all.Next_Ptr;
-   end loop;
-   if Q = null then
+   Memory_Block := Locate_Free (RSize);
+   if Memory_Block = null then
+      Stats.Failures := @ + 1;
       Mutex.Release (Mtx);
       -- no block with sufficient size was found
       raise Storage_Error;
    end if;
+   Remove_Free (Memory_Block);
+   -- the memory block could be too big to be provided as a whole; if
+   -- possible, split it in two sub-blocks, one for the user and the other
+   -- stuck in the pool as available memory space
+   Split_Block (Memory_Block, RSize);
+   Stats.Allocations := @ + 1;
+   Stats.Bytes_In_Use := @ + Block_Size (Memory_Block);
+   if Stats.Bytes_In_Use > Stats.Peak_Bytes_In_Use then
+      Stats.Peak_Bytes_In_Use := Stats.Bytes_In_Use;
+   end if;
+   Mutex.Release (Mtx);
    if Debug then
       Console.Print (
          Prefix => "Found block @ ",
-         Value  => Q.all'Address,
+         Value  => Memory_Block.all'Address,
          NL     => True
          );
    end if;
-   -- the memory block could be too big to be provided as a whole; if
-   -- possible, split it in two sub-blocks, one for the user and the other
-   -- stuck in the pool as available memory space
-   if Q.all.Size - RSize >= 2 * MEMORYBLOCKTYPE_SIZE then
-      declare
-         Half_Block : aliased Memory_Block_Type
-            with Address    => Q.all'Address + Storage_Offset (RSize),
-                 Import     => True,
-                 Convention => Ada;
-      begin
-         if Debug then
-            Console.Print (
-               Prefix => "Creating free block @ ",
-               Value  => Half_Block'Address,
-               NL     => True
-               );
-         end if;
-         P.all.Next_Ptr := Half_Block'Unchecked_Access;
-         P.all.Next_Ptr.all.Size := Q.all.Size - RSize;
-         P.all.Next_Ptr.all.Next_Ptr := Q.all.Next_Ptr;
-         Q.all.Size := RSize;
-      end;
-   else
-      -- use whole block
-      P.all.Next_Ptr := Q.all.Next_Ptr;
-   end if;
-   Q.all.Next_Ptr := null;
-   Mutex.Release (Mtx);
-   return Q.all'Address + MEMORYBLOCKTYPE_SIZE;
+   return Memory_Block.all'Address + MEMORYBLOCKTYPE_SIZE;
 end Malloc;
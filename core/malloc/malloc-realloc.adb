@@ -24,15 +24,11 @@ function Realloc
    return Address
    is
    use Interfaces.C;
-   use Interfaces.C.Extensions;
-   Memory_Block         : aliased Memory_Block_Type
-      with Address    => Memory_Address - MEMORYBLOCKTYPE_SIZE, -- uncover the data structure
-           Import     => True,
-           Convention => Ada;
-   Memory_Block_Address : void_ptr;
-   RSize                : size_t;
-   P                    : Memory_Block_Ptr;
-   Q                    : Memory_Block_Ptr;
+   Memory_Block             : Memory_Block_Ptr;
+   Next_Block               : Memory_Block_Ptr;
+   Old_Size                 : size_t;
+   RSize                    : size_t;
+   New_Memory_Block_Address : Address;
 begin
    if Memory_Address = Null_Address then
       return Malloc (Size);
@@ -41,72 +37,44 @@ begin
       Free (Memory_Address);
       return Null_Address;
    end if;
-   Memory_Block_Address := Memory_Block'Address;
+   -- uncover the data structure
+   Memory_Block := To_MBP (Memory_Address - MEMORYBLOCKTYPE_SIZE);
    RSize := Round_Size (MEMORYBLOCKTYPE_SIZE + Size, DEFAULT_ALIGNMENT);
-   if Memory_Block.Size > RSize then
-      -- block is too big, split it in two parts
-      declare
-         Half_Block : aliased Memory_Block_Type
-            with Address    => Memory_Block_Address + Storage_Offset (RSize),
-                 Import     => True,
-                 Convention => Ada;
-      begin
-         Half_Block.Size := Memory_Block.Size - RSize;
-         Memory_Block.Size := RSize;
-         -- append the newly created block to free list
-         Free (Half_Block'Address + MEMORYBLOCKTYPE_SIZE);
-      end;
-   else
-      if Memory_Block.Size < RSize then
-         -- obviously, the allocated block is not in the free list, check
-         -- if the immediately following memory area is a free block
-         declare
-            End_Address : Address;
-         begin
-            Mutex.Acquire (Mtx);
-            P := Heap_Descriptor'Access;
-            Q := Heap_Descriptor.Next_Ptr;
-            while Q /= null and then Q.all'Address < Memory_Block_Address loop
-               P := Q;
-               Q := Q.all.Next_Ptr;
-            end loop;
-            -- compute memory block end address
-            End_Address := Memory_Block_Address + Storage_Offset (Memory_Block.Size);
-            if
-               Q /= null                               and then
-               End_Address = Q.all'Address             and then
-               Memory_Block.Size + Q.all.Size >= RSize
-            then
-               -- expand the block in-place
-               Memory_Block.Size := @ + Q.all.Size;
-               P.all.Next_Ptr := Q.all.Next_Ptr;
-               Q.all.Size     := 0;
-               Q.all.Next_Ptr := null;
-               Mutex.Release (Mtx);
-            else
-               Mutex.Release (Mtx);
-               -- failure, move the block
-               declare
-                  New_Memory_Block_Address : Address;
-               begin
-                  New_Memory_Block_Address := Malloc (RSize);
-                  if New_Memory_Block_Address /= Null_Address then
-                     New_Memory_Block_Address :=
-                        Memory_Functions.Memcpy (
-                           @,
-                           Memory_Block_Address,
-                           Memory_Block.Size - MEMORYBLOCKTYPE_SIZE
-                           );
-                     Free (Memory_Block_Address);
-                     -- update address
-                     Memory_Block_Address := New_Memory_Block_Address;
-                  else
-                     raise Storage_Error;
-                  end if;
-               end;
-            end if;
-         end;
+   if RSize < MIN_BLOCK_SIZE then
+      RSize := MIN_BLOCK_SIZE;
+   end if;
+   Mutex.Acquire (Mtx);
+   Old_Size := Block_Size (Memory_Block);
+   if RSize <= Old_Size then
+      -- shrink in-place, the tail is released
+      Split_Block (Memory_Block, RSize);
+      Stats.Bytes_In_Use := @ - (Old_Size - Block_Size (Memory_Block));
+      Mutex.Release (Mtx);
+      return Memory_Address;
+   end if;
+   -- boundary tags tell if the physically following block is free and
+   -- large enough to expand the block in-place
+   Next_Block := Next_Physical (Memory_Block);
+   if Is_Free (Next_Block) and then Old_Size + Block_Size (Next_Block) >= RSize then
+      Remove_Free (Next_Block);
+      Memory_Block.all.Size := Old_Size + Block_Size (Next_Block);
+      Next_Physical (Memory_Block).all.Prev_Phys_Ptr := Memory_Block;
+      Split_Block (Memory_Block, RSize);
+      Stats.Bytes_In_Use := @ + (Block_Size (Memory_Block) - Old_Size);
+      if Stats.Bytes_In_Use > Stats.Peak_Bytes_In_Use then
+         Stats.Peak_Bytes_In_Use := Stats.Bytes_In_Use;
       end if;
+      Mutex.Release (Mtx);
+      return Memory_Address;
    end if;
-   return Memory_Block_Address;
+   Mutex.Release (Mtx);
+   -- failure, move the block; Malloc raises Storage_Error on failure
+   New_Memory_Block_Address := Malloc (Size);
+   New_Memory_Block_Address := Memory_Functions.Memcpy (
+      @,
+      Memory_Address,
+      Old_Size - MEMORYBLOCKTYPE_SIZE
+      );
+   Free (Memory_Address);
+   return New_Memory_Block_Address;
 end Realloc;
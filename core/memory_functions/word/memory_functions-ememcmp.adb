@@ -0,0 +1,79 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memory_functions-ememcmp.adb                                                                              --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Storage_Elements;
+with Bits;
+
+separate (Memory_Functions)
+function EMemcmp
+   (S1 : Interfaces.C.Extensions.void_ptr;
+    S2 : Interfaces.C.Extensions.void_ptr;
+    N  : Interfaces.C.size_t)
+   return Interfaces.C.int
+   is
+   use System.Storage_Elements;
+   use Interfaces.C;
+   use Bits;
+   WORD_BYTES : constant := CPU_Unsigned'Size / System.Storage_Unit;
+   ALIGN_MASK : constant Integer_Address := WORD_BYTES - 1;
+   -- generic external memory area, word view
+   type Word_Area_Type is array (size_t) of CPU_Unsigned;
+   package MAPW is new System.Address_To_Access_Conversions (Word_Area_Type);
+   P_S1  : constant MAP.Object_Pointer := MAP.To_Pointer (S1);
+   P_S2  : constant MAP.Object_Pointer := MAP.To_Pointer (S2);
+   Index : size_t := 0;
+begin
+   -- word compares are possible only if both areas share the same
+   -- alignment; they only skip the equal prefix, the first differing byte
+   -- is then located bytewise, so the result does not depend on endianness
+   if
+      N >= 2 * WORD_BYTES and then
+      ((To_Integer (S1) xor To_Integer (S2)) and ALIGN_MASK) = 0
+   then
+      -- head: align to a word boundary, stop at the first mismatch
+      while
+         ((To_Integer (S1) + Integer_Address (Index)) and ALIGN_MASK) /= 0 and then
+         P_S1.all (Index) = P_S2.all (Index)
+      loop
+         Index := @ + 1;
+      end loop;
+      -- bulk: native word compares
+      if ((To_Integer (S1) + Integer_Address (Index)) and ALIGN_MASK) = 0 then
+         declare
+            W_S1   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S1 + Storage_Offset (Index));
+            W_S2   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S2 + Storage_Offset (Index));
+            NWords : constant size_t := (N - Index) / WORD_BYTES;
+            WIndex : size_t := 0;
+         begin
+            while WIndex < NWords and then W_S1.all (WIndex) = W_S2.all (WIndex) loop
+               WIndex := @ + 1;
+            end loop;
+            Index := @ + WIndex * WORD_BYTES;
+         end;
+      end if;
+   end if;
+   -- tail, differing word or whole area if not co-aligned
+   while Index < N loop
+      if    char'Pos (P_S1.all (Index)) < char'Pos (P_S2.all (Index)) then
+         return -1;
+      elsif char'Pos (P_S1.all (Index)) > char'Pos (P_S2.all (Index)) then
+         return 1;
+      end if;
+      Index := @ + 1;
+   end loop;
+   return 0;
+end EMemcmp;
@@ -0,0 +1,142 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memory_functions-ememmove.adb                                                                             --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Storage_Elements;
+with Bits;
+
+separate (Memory_Functions)
+function EMemmove
+   (S1 : Interfaces.C.Extensions.void_ptr;
+    S2 : Interfaces.C.Extensions.void_ptr;
+    N  : Interfaces.C.size_t)
+   return Interfaces.C.Extensions.void_ptr
+   is
+   use System.Storage_Elements;
+   use Interfaces.C;
+   use Bits;
+   WORD_BYTES : constant := CPU_Unsigned'Size / System.Storage_Unit;
+   ALIGN_MASK : constant Integer_Address := WORD_BYTES - 1;
+   -- generic external memory area, word view
+   type Word_Area_Type is array (size_t) of CPU_Unsigned;
+   package MAPW is new System.Address_To_Access_Conversions (Word_Area_Type);
+   P_S1      : constant MAP.Object_Pointer := MAP.To_Pointer (S1);
+   P_S2      : constant MAP.Object_Pointer := MAP.To_Pointer (S2);
+   Coaligned : constant Boolean :=
+      N >= 2 * WORD_BYTES and then
+      ((To_Integer (S1) xor To_Integer (S2)) and ALIGN_MASK) = 0;
+   Index     : size_t;
+   NWords    : size_t;
+begin
+   if S1 <= S2 then
+      -- ascending addresses
+      Index := 0;
+      if Coaligned then
+         -- head: align the destination to a word boundary
+         while ((To_Integer (S1) + Integer_Address (Index)) and ALIGN_MASK) /= 0 loop
+            P_S1.all (Index) := P_S2.all (Index);
+            Index := @ + 1;
+         end loop;
+         -- bulk: native word transfers, 8x unrolled on 64-bit CPUs, 4x otherwise
+         declare
+            W_S1   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S1 + Storage_Offset (Index));
+            W_S2   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S2 + Storage_Offset (Index));
+            WIndex : size_t := 0;
+         begin
+            NWords := (N - Index) / WORD_BYTES;
+            if WORD_BYTES = 8 then
+               while NWords - WIndex >= 8 loop
+                  W_S1.all (WIndex)     := W_S2.all (WIndex);
+                  W_S1.all (WIndex + 1) := W_S2.all (WIndex + 1);
+                  W_S1.all (WIndex + 2) := W_S2.all (WIndex + 2);
+                  W_S1.all (WIndex + 3) := W_S2.all (WIndex + 3);
+                  W_S1.all (WIndex + 4) := W_S2.all (WIndex + 4);
+                  W_S1.all (WIndex + 5) := W_S2.all (WIndex + 5);
+                  W_S1.all (WIndex + 6) := W_S2.all (WIndex + 6);
+                  W_S1.all (WIndex + 7) := W_S2.all (WIndex + 7);
+                  WIndex := @ + 8;
+               end loop;
+            end if;
+            while NWords - WIndex >= 4 loop
+               W_S1.all (WIndex)     := W_S2.all (WIndex);
+               W_S1.all (WIndex + 1) := W_S2.all (WIndex + 1);
+               W_S1.all (WIndex + 2) := W_S2.all (WIndex + 2);
+               W_S1.all (WIndex + 3) := W_S2.all (WIndex + 3);
+               WIndex := @ + 4;
+            end loop;
+            while WIndex < NWords loop
+               W_S1.all (WIndex) := W_S2.all (WIndex);
+               WIndex := @ + 1;
+            end loop;
+            Index := @ + NWords * WORD_BYTES;
+         end;
+      end if;
+      -- tail
+      while Index < N loop
+         P_S1.all (Index) := P_S2.all (Index);
+         Index := @ + 1;
+      end loop;
+   else
+      -- descending addresses, Index counts the bytes still to be moved
+      Index := N;
+      if Coaligned then
+         -- tail: align the destination end to a word boundary
+         while ((To_Integer (S1) + Integer_Address (Index)) and ALIGN_MASK) /= 0 loop
+            Index := @ - 1;
+            P_S1.all (Index) := P_S2.all (Index);
+         end loop;
+         -- bulk: native word transfers, 8x unrolled on 64-bit CPUs, 4x otherwise
+         NWords := Index / WORD_BYTES;
+         Index := @ - NWords * WORD_BYTES;
+         declare
+            W_S1   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S1 + Storage_Offset (Index));
+            W_S2   : constant MAPW.Object_Pointer := MAPW.To_Pointer (S2 + Storage_Offset (Index));
+            WIndex : size_t := NWords;
+         begin
+            if WORD_BYTES = 8 then
+               while WIndex >= 8 loop
+                  W_S1.all (WIndex - 1) := W_S2.all (WIndex - 1);
+                  W_S1.all (WIndex - 2) := W_S2.all (WIndex - 2);
+                  W_S1.all (WIndex - 3) := W_S2.all (WIndex - 3);
+                  W_S1.all (WIndex - 4) := W_S2.all (WIndex - 4);
+                  W_S1.all (WIndex - 5) := W_S2.all (WIndex - 5);
+                  W_S1.all (WIndex - 6) := W_S2.all (WIndex - 6);
+                  W_S1.all (WIndex - 7) := W_S2.all (WIndex - 7);
+                  W_S1.all (WIndex - 8) := W_S2.all (WIndex - 8);
+                  WIndex := @ - 8;
+               end loop;
+            end if;
+            while WIndex >= 4 loop
+               W_S1.all (WIndex - 1) := W_S2.all (WIndex - 1);
+               W_S1.all (WIndex - 2) := W_S2.all (WIndex - 2);
+               W_S1.all (WIndex - 3) := W_S2.all (WIndex - 3);
+               W_S1.all (WIndex - 4) := W_S2.all (WIndex - 4);
+               WIndex := @ - 4;
+            end loop;
+            while WIndex > 0 loop
+               WIndex := @ - 1;
+               W_S1.all (WIndex) := W_S2.all (WIndex);
+            end loop;
+         end;
+      end if;
+      -- head
+      while Index > 0 loop
+         Index := @ - 1;
+         P_S1.all (Index) := P_S2.all (Index);
+      end loop;
+   end if;
+   return S1;
+end EMemmove;
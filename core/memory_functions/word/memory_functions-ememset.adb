@@ -0,0 +1,96 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memory_functions-ememset.adb                                                                              --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with Ada.Unchecked_Conversion;
+with System.Storage_Elements;
+with Bits;
+
+separate (Memory_Functions)
+function EMemset
+   (S : Interfaces.C.Extensions.void_ptr;
+    C : Interfaces.C.int;
+    N : Interfaces.C.size_t)
+   return Interfaces.C.Extensions.void_ptr
+   is
+   use System.Storage_Elements;
+   use Interfaces.C;
+   use Bits;
+   WORD_BYTES : constant := CPU_Unsigned'Size / System.Storage_Unit;
+   ALIGN_MASK : constant Integer_Address := WORD_BYTES - 1;
+   type int_mod is mod 2**int'Size;
+   -- generic external memory area, word view
+   type Word_Area_Type is array (size_t) of CPU_Unsigned;
+   package MAPW is new System.Address_To_Access_Conversions (Word_Area_Type);
+   P     : constant MAP.Object_Pointer := MAP.To_Pointer (S);
+   Ic    : char;
+   Iw    : CPU_Unsigned;
+   Index : size_t := 0;
+   function To_im is new Ada.Unchecked_Conversion (int, int_mod);
+begin
+   -- int has negative values, so it is necessary to convert first to a
+   -- modular type in order to avoid warnings on implicit conditionals
+   -- when applying the mod operation which restricts output range to
+   -- char type values
+   Ic := char'Val (To_im (C) mod 2**char'Size);
+   if N >= 2 * WORD_BYTES then
+      -- head: align the destination to a word boundary
+      while ((To_Integer (S) + Integer_Address (Index)) and ALIGN_MASK) /= 0 loop
+         P.all (Index) := Ic;
+         Index := @ + 1;
+      end loop;
+      -- replicate the byte value in every byte lane of a word
+      Iw := (CPU_Unsigned'Last / 16#FF#) * CPU_Unsigned (char'Pos (Ic));
+      -- bulk: native word transfers, 8x unrolled on 64-bit CPUs, 4x otherwise
+      declare
+         W      : constant MAPW.Object_Pointer := MAPW.To_Pointer (S + Storage_Offset (Index));
+         NWords : constant size_t := (N - Index) / WORD_BYTES;
+         WIndex : size_t := 0;
+      begin
+         if WORD_BYTES = 8 then
+            while NWords - WIndex >= 8 loop
+               W.all (WIndex)     := Iw;
+               W.all (WIndex + 1) := Iw;
+               W.all (WIndex + 2) := Iw;
+               W.all (WIndex + 3) := Iw;
+               W.all (WIndex + 4) := Iw;
+               W.all (WIndex + 5) := Iw;
+               W.all (WIndex + 6) := Iw;
+               W.all (WIndex + 7) := Iw;
+               WIndex := @ + 8;
+            end loop;
+         end if;
+         while NWords - WIndex >= 4 loop
+            W.all (WIndex)     := Iw;
+            W.all (WIndex + 1) := Iw;
+            W.all (WIndex + 2) := Iw;
+            W.all (WIndex + 3) := Iw;
+            WIndex := @ + 4;
+         end loop;
+         while WIndex < NWords loop
+            W.all (WIndex) := Iw;
+            WIndex := @ + 1;
+         end loop;
+         Index := @ + NWords * WORD_BYTES;
+      end;
+   end if;
+   -- tail
+   while Index < N loop
+      P.all (Index) := Ic;
+      Index := @ + 1;
+   end loop;
+   return S;
+end EMemset;
@@ -0,0 +1,182 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ pools.adb                                                                                                 --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+pragma Restrictions (No_Elaboration_Code);
+
+with System.Storage_Elements;
+with CPU;
+
+package body Pools
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System;
+   use System.Storage_Elements;
+
+   -- 0 = no slot
+   subtype Slot_Index_Type is Natural range 0 .. Pool_Size;
+
+   -- a free slot holds the link to the next free slot, overlapping the
+   -- object; the discriminant is never stored
+   type Slot_Type (Free : Boolean := True) is record
+      case Free is
+         when True  => Next   : Slot_Index_Type;
+         when False => Object : aliased Object_Type;
+      end case;
+   end record
+      with Unchecked_Union => True;
+
+   Arena : array (1 .. Pool_Size) of aliased Slot_Type;
+
+   Free_List  : Slot_Index_Type := 0;
+   Carved     : Slot_Index_Type := 0;
+   In_Use     : Natural := 0;
+   High_Water : Natural := 0;
+   Failures   : Natural := 0;
+
+   function Slot_Index
+      (Object : Object_Ptr)
+      return Slot_Index_Type
+      with Inline => True;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Slot_Index
+   ----------------------------------------------------------------------------
+   -- Return the index of the slot holding Object, 0 if Object is not a slot.
+   ----------------------------------------------------------------------------
+   function Slot_Index
+      (Object : Object_Ptr)
+      return Slot_Index_Type
+      is
+      SLOT_SIZE : constant Storage_Offset := Arena'Component_Size / Storage_Unit;
+      Offset    : Storage_Offset;
+   begin
+      if Object = null                                       or else
+         Object.all'Address < Arena (Arena'First)'Address or else
+         Object.all'Address > Arena (Arena'Last)'Address
+      then
+         return 0;
+      end if;
+      Offset := Object.all'Address - Arena (Arena'First)'Address;
+      if Offset mod SLOT_SIZE /= 0 then
+         return 0;
+      end if;
+      return Slot_Index_Type (Offset / SLOT_SIZE) + Arena'First;
+   end Slot_Index;
+
+   ----------------------------------------------------------------------------
+   -- Allocate
+   ----------------------------------------------------------------------------
+   function Allocate
+      return Object_Ptr
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Index      : Slot_Index_Type;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      if Free_List /= 0 then
+         -- recycle the most recently released slot
+         Index := Free_List;
+         Free_List := Arena (Index).Next;
+      elsif Carved < Pool_Size then
+         -- carve a never used slot
+         Carved := @ + 1;
+         Index := Carved;
+      else
+         Failures := @ + 1;
+         CPU.Intcontext_Set (Intcontext);
+         return null;
+      end if;
+      In_Use := @ + 1;
+      if In_Use > High_Water then
+         High_Water := In_Use;
+      end if;
+      CPU.Intcontext_Set (Intcontext);
+      return Arena (Index).Object'Unchecked_Access;
+   end Allocate;
+
+   ----------------------------------------------------------------------------
+   -- Free
+   ----------------------------------------------------------------------------
+   procedure Free
+      (Object : in out Object_Ptr)
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Index      : Slot_Index_Type;
+   begin
+      Index := Slot_Index (Object);
+      if Index = 0 then
+         raise Storage_Error;
+      end if;
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      Arena (Index).Next := Free_List;
+      Free_List := Index;
+      In_Use := @ - 1;
+      CPU.Intcontext_Set (Intcontext);
+      Object := null;
+   end Free;
+
+   ----------------------------------------------------------------------------
+   -- Owns
+   ----------------------------------------------------------------------------
+   function Owns
+      (Object : Object_Ptr)
+      return Boolean
+      is
+   begin
+      return Slot_Index (Object) /= 0;
+   end Owns;
+
+   ----------------------------------------------------------------------------
+   -- Statistics
+   ----------------------------------------------------------------------------
+   function Statistics
+      return Statistics_Type
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Result     : Statistics_Type;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      Result := (
+         Capacity   => Pool_Size,
+         In_Use     => In_Use,
+         High_Water => High_Water,
+         Failures   => Failures
+         );
+      CPU.Intcontext_Set (Intcontext);
+      return Result;
+   end Statistics;
+
+end Pools;
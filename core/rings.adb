@@ -0,0 +1,165 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ rings.adb                                                                                                 --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with GCC.Defines;
+with LLutils;
+
+package body Rings
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   SIZE : constant Unsigned_32 := Unsigned_32 (Ring_Size);
+
+   function Slot
+      (Index : Unsigned_32)
+      return Natural
+      with Inline => True;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Slot
+   ----------------------------------------------------------------------------
+   function Slot
+      (Index : Unsigned_32)
+      return Natural
+      is
+   begin
+      return Natural (Index and (SIZE - 1));
+   end Slot;
+
+   ----------------------------------------------------------------------------
+   -- Count
+   ----------------------------------------------------------------------------
+   function Count
+      (R : access Ring_Type)
+      return Natural
+      is
+      Head : Unsigned_32;
+      Tail : Unsigned_32;
+   begin
+      Tail := LLutils.Atomic_Load_32 (R.all.Tail'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      Head := LLutils.Atomic_Load_32 (R.all.Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      return Natural (Head - Tail);
+   end Count;
+
+   ----------------------------------------------------------------------------
+   -- Put
+   ----------------------------------------------------------------------------
+   procedure Put
+      (R       : access Ring_Type;
+       Item    : in     Element_Type;
+       Success :    out Boolean)
+      is
+      Head : Unsigned_32;
+      Tail : Unsigned_32;
+   begin
+      Head := LLutils.Atomic_Load_32 (R.all.Head'Address, GCC.Defines.ATOMIC_RELAXED);
+      -- slots freed by the consumer are visible after this load
+      Tail := LLutils.Atomic_Load_32 (R.all.Tail'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      if Head - Tail = SIZE then
+         Success := False;
+      else
+         R.all.Items (Slot (Head)) := Item;
+         -- publish the item
+         LLutils.Atomic_Store_32 (R.all.Head'Address, Head + 1, GCC.Defines.ATOMIC_RELEASE);
+         Success := True;
+      end if;
+   end Put;
+
+   ----------------------------------------------------------------------------
+   -- Get
+   ----------------------------------------------------------------------------
+   procedure Get
+      (R       : access Ring_Type;
+       Item    :    out Element_Type;
+       Success :    out Boolean)
+      is
+      Head : Unsigned_32;
+      Tail : Unsigned_32;
+   begin
+      Tail := LLutils.Atomic_Load_32 (R.all.Tail'Address, GCC.Defines.ATOMIC_RELAXED);
+      -- items published by the producer are visible after this load
+      Head := LLutils.Atomic_Load_32 (R.all.Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      if Head = Tail then
+         Success := False;
+      else
+         Item := R.all.Items (Slot (Tail));
+         -- release the slot
+         LLutils.Atomic_Store_32 (R.all.Tail'Address, Tail + 1, GCC.Defines.ATOMIC_RELEASE);
+         Success := True;
+      end if;
+   end Get;
+
+   ----------------------------------------------------------------------------
+   -- Put_Batch
+   ----------------------------------------------------------------------------
+   procedure Put_Batch
+      (R     : access Ring_Type;
+       Items : in     Item_Array;
+       Count :    out Natural)
+      is
+      Head : Unsigned_32;
+      Tail : Unsigned_32;
+   begin
+      Head := LLutils.Atomic_Load_32 (R.all.Head'Address, GCC.Defines.ATOMIC_RELAXED);
+      Tail := LLutils.Atomic_Load_32 (R.all.Tail'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      Count := Natural'Min (Items'Length, Natural (SIZE - (Head - Tail)));
+      for Index in 0 .. Count - 1 loop
+         R.all.Items (Slot (Head + Unsigned_32 (Index))) := Items (Items'First + Index);
+      end loop;
+      if Count /= 0 then
+         LLutils.Atomic_Store_32 (R.all.Head'Address, Head + Unsigned_32 (Count), GCC.Defines.ATOMIC_RELEASE);
+      end if;
+   end Put_Batch;
+
+   ----------------------------------------------------------------------------
+   -- Get_Batch
+   ----------------------------------------------------------------------------
+   procedure Get_Batch
+      (R     : access Ring_Type;
+       Items :    out Item_Array;
+       Count :    out Natural)
+      is
+      Head : Unsigned_32;
+      Tail : Unsigned_32;
+   begin
+      Tail := LLutils.Atomic_Load_32 (R.all.Tail'Address, GCC.Defines.ATOMIC_RELAXED);
+      Head := LLutils.Atomic_Load_32 (R.all.Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+      Count := Natural'Min (Items'Length, Natural (Head - Tail));
+      for Index in 0 .. Count - 1 loop
+         Items (Items'First + Index) := R.all.Items (Slot (Tail + Unsigned_32 (Index)));
+      end loop;
+      if Count /= 0 then
+         LLutils.Atomic_Store_32 (R.all.Tail'Address, Tail + Unsigned_32 (Count), GCC.Defines.ATOMIC_RELEASE);
+      end if;
+   end Get_Batch;
+
+end Rings;
@@ -32,6 +32,9 @@ package body Timers
 
    Timer_List : aliased Timer_Ptr;
 
+   procedure Periodic_Tick
+      (Data : in Address);
+
    --========================================================================--
    --                                                                        --
    --                                                                        --
@@ -47,21 +50,20 @@ package body Timers
       (T : in Timer_Ptr)
       is
       PTPtr      : Timer_PPtr := Timer_List'Access;
-      P          : Timer_Ptr renames PTPtr.all;
       Intcontext : CPU.Intcontext_Type;
    begin
       CPU.Intcontext_Get (Intcontext);
       CPU.Irq_Disable;
-      while P /= null loop
-         if P.all.Expire > T.all.Expire then
-            P.all.Expire := @ - T.all.Expire;
-            T.all.Next := P;
+      while PTPtr.all /= null loop
+         if PTPtr.all.all.Expire > T.all.Expire then
+            PTPtr.all.all.Expire := @ - T.all.Expire;
             exit;
          end if;
-         T.all.Expire := @ - P.all.Expire;
-         PTPtr := P.all.Next'Access;
+         T.all.Expire := @ - PTPtr.all.all.Expire;
+         PTPtr := PTPtr.all.all.Next'Access;
       end loop;
-      P := T;
+      T.all.Next := PTPtr.all;
+      PTPtr.all := T;
       CPU.Intcontext_Set (Intcontext);
    end Add;
 
@@ -74,24 +76,23 @@ package body Timers
       is
       Intcontext : CPU.Intcontext_Type;
       PTPtr      : Timer_PPtr := Timer_List'Access;
-      P          : Timer_Ptr renames PTPtr.all;
       E          : Unsigned_32 := 0;
       Result     : Boolean := False;
    begin
       CPU.Intcontext_Get (Intcontext);
       CPU.Irq_Disable;
-      while P /= null loop
-         if P = T then
-            P := @.all.Next;
-            if P /= null then
-               P.all.Expire := @ + T.all.Expire;
+      while PTPtr.all /= null loop
+         if PTPtr.all = T then
+            PTPtr.all := T.all.Next;
+            if PTPtr.all /= null then
+               PTPtr.all.all.Expire := @ + T.all.Expire;
             end if;
             T.all.Expire := @ + E;
             Result := True;
             exit;
          end if;
-         E := @ + P.all.Expire;
-         PTPtr := P.all.Next'Access;
+         E := @ + PTPtr.all.all.Expire;
+         PTPtr := PTPtr.all.all.Next'Access;
       end loop;
       CPU.Intcontext_Set (Intcontext);
       return Result;
@@ -102,18 +103,79 @@ package body Timers
    ----------------------------------------------------------------------------
    procedure Process
       is
+      T : Timer_Ptr;
    begin
       if Timer_List /= null then
          if Timer_List.all.Expire /= 0 then
             Timer_List.all.Expire := @ - 1;
          end if;
-         if Timer_List.all.Expire = 0 then
+         -- unlink before calling, so that the procedure can re-add its timer
+         while Timer_List /= null and then Timer_List.all.Expire = 0 loop
+            T := Timer_List;
+            Timer_List := @.all.Next;
+            T.all.Next := null;
             CPU.Irq_Enable;
-            Timer_List.all.Proc (Timer_List.all.Data);
+            T.all.Proc (T.all.Data);
             CPU.Irq_Disable;
-            Timer_List := @.all.Next;
-         end if;
+         end loop;
       end if;
    end Process;
 
+   ----------------------------------------------------------------------------
+   -- Periodic_Tick
+   ----------------------------------------------------------------------------
+   -- Timer procedure of every periodic timer, Data is the Periodic_Type.
+   ----------------------------------------------------------------------------
+   procedure Periodic_Tick
+      (Data : in Address)
+      is
+      P : Periodic_Type
+         with Address    => Data,
+              Import     => True,
+              Convention => Ada;
+   begin
+      P.Count := @ + 1;
+      if P.Proc /= null then
+         P.Proc (P.Data);
+      end if;
+      P.Timer.Expire := P.Period;
+      Add (P.Timer'Unchecked_Access);
+   end Periodic_Tick;
+
+   ----------------------------------------------------------------------------
+   -- Periodic_Start
+   ----------------------------------------------------------------------------
+   procedure Periodic_Start
+      (P      : in Periodic_Ptr;
+       Period : in Unsigned_32;
+       Proc   : in Timer_Proc := null;
+       Data   : in Address    := Null_Address)
+      is
+      Unused : Boolean;
+   begin
+      Unused := Delete (P.all.Timer'Access);
+      P.all.Period := Unsigned_32'Max (Period, 1);
+      P.all.Proc   := Proc;
+      P.all.Data   := Data;
+      P.all.Timer  := (
+         Expire => P.all.Period,
+         Next   => null,
+         Proc   => Periodic_Tick'Access,
+         Data   => P.all'Address
+         );
+      Add (P.all.Timer'Access);
+   end Periodic_Start;
+
+   ----------------------------------------------------------------------------
+   -- Expired
+   ----------------------------------------------------------------------------
+   function Expired
+      (Deadline : Unsigned_32;
+       Clock    : Unsigned_32)
+      return Boolean
+      is
+   begin
+      return Clock - Deadline < 16#8000_0000#;
+   end Expired;
+
 end Timers;
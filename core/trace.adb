@@ -0,0 +1,276 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ trace.adb                                                                                                 --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with GCC.Defines;
+with LLutils;
+with CPU;
+with Console;
+
+package body Trace
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   pragma Compile_Time_Error (
+      (Unsigned_32 (TRACE_SIZE) and Unsigned_32 (TRACE_SIZE - 1)) /= 0,
+      "TRACE_SIZE must be a power of two"
+      );
+
+   SIZE : constant Unsigned_32 := TRACE_SIZE;
+
+   type Ring_Array is array (Natural range 0 .. TRACE_SIZE - 1) of Record_Type
+      with Suppress_Initialization => True;
+
+   Ring         : Ring_Array;
+   Head         : aliased Unsigned_32 := 0 -- next slot to reserve, shared by producers
+      with Volatile => True;
+   Tail         : Unsigned_32 := 0;        -- next slot to drain, consumer only
+   Lost_Records : Unsigned_32 := 0;
+   Clock        : Timestamp_Ptr := null;
+
+   function Slot
+      (Index : Unsigned_32)
+      return Natural
+      with Inline => True;
+
+   function Level_Name
+      (Level : Level_Type)
+      return String;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Slot
+   ----------------------------------------------------------------------------
+   function Slot
+      (Index : Unsigned_32)
+      return Natural
+      is
+   begin
+      return Natural (Index and (SIZE - 1));
+   end Slot;
+
+   ----------------------------------------------------------------------------
+   -- Level_Name
+   ----------------------------------------------------------------------------
+   function Level_Name
+      (Level : Level_Type)
+      return String
+      is
+   begin
+      case Level is
+         when LEVEL_NONE  => return "NONE ";
+         when LEVEL_ERROR => return "ERROR";
+         when LEVEL_INFO  => return "INFO ";
+         when LEVEL_DEBUG => return "DEBUG";
+      end case;
+   end Level_Name;
+
+   ----------------------------------------------------------------------------
+   -- Timestamp_Set
+   ----------------------------------------------------------------------------
+   procedure Timestamp_Set
+      (Clock : in Timestamp_Ptr)
+      is
+   begin
+      Trace.Clock := Clock;
+   end Timestamp_Set;
+
+   ----------------------------------------------------------------------------
+   -- Put
+   ----------------------------------------------------------------------------
+   procedure Put
+      (Level : in Event_Level_Type;
+       Id    : in Event_Id_Type;
+       Arg1  : in Unsigned_32;
+       Arg2  : in Unsigned_32)
+      is
+      Index      : Unsigned_32;
+      Sequence   : Unsigned_32;
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      -- without a native CAS, the exchanges below are plain compare and
+      -- store, so mask interrupts until the slot is reserved and invalid
+      if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+         CPU.Intcontext_Get (Intcontext);
+         CPU.Irq_Disable;
+      end if;
+      -- reserve a slot; an interrupting producer simply takes the next one
+      loop
+         Index := LLutils.Atomic_Load_32 (Head'Address, GCC.Defines.ATOMIC_RELAXED);
+         exit when LLutils.Atomic_Compare_Exchange_32 (Head'Address, Index, Index + 1, GCC.Defines.ATOMIC_ACQ_REL);
+      end loop;
+      declare
+         R : Record_Type renames Ring (Slot (Index));
+      begin
+         -- invalidate the slot before touching it; the acquire side of the
+         -- exchange keeps the stores below from being hoisted above it
+         loop
+            Sequence := LLutils.Atomic_Load_32 (R.Sequence'Address, GCC.Defines.ATOMIC_RELAXED);
+            exit when LLutils.Atomic_Compare_Exchange_32 (R.Sequence'Address, Sequence, 0, GCC.Defines.ATOMIC_ACQ_REL);
+         end loop;
+         if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+            CPU.Intcontext_Set (Intcontext);
+         end if;
+         R.Timestamp := (if Clock /= null then Clock.all else 0);
+         R.Event     := Id;
+         R.Level     := Level;
+         R.Arg1      := Arg1;
+         R.Arg2      := Arg2;
+         -- commit
+         LLutils.Atomic_Store_32 (R.Sequence'Address, Index + 1, GCC.Defines.ATOMIC_RELEASE);
+      end;
+   end Put;
+
+   ----------------------------------------------------------------------------
+   -- Event
+   ----------------------------------------------------------------------------
+   procedure Event
+      (Level : in Event_Level_Type;
+       Id    : in Event_Id_Type;
+       Arg1  : in Unsigned_32 := 0;
+       Arg2  : in Unsigned_32 := 0)
+      is
+   begin
+      if Level <= TRACE_LEVEL then
+         Put (Level, Id, Arg1, Arg2);
+      end if;
+      if Level <= CONSOLE_LEVEL then
+         Print ((
+            Sequence  => 0,
+            Timestamp => (if Clock /= null then Clock.all else 0),
+            Event     => Id,
+            Level     => Level,
+            Arg1      => Arg1,
+            Arg2      => Arg2
+            ));
+      end if;
+   end Event;
+
+   ----------------------------------------------------------------------------
+   -- Get
+   ----------------------------------------------------------------------------
+   procedure Get
+      (Item    : out Record_Type;
+       Success : out Boolean)
+      is
+      Index      : Unsigned_32;
+      Unchanged  : Boolean;
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      Success := False;
+      loop
+         Index := LLutils.Atomic_Load_32 (Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+         exit when Index = Tail;
+         if Index - Tail > SIZE then
+            -- lapped by the producers, skip to the oldest surviving record
+            Lost_Records := @ + (Index - Tail - SIZE);
+            Tail := Index - SIZE;
+         end if;
+         declare
+            R : Record_Type renames Ring (Slot (Tail));
+         begin
+            if LLutils.Atomic_Load_32 (R.Sequence'Address, GCC.Defines.ATOMIC_ACQUIRE) /= Tail + 1 then
+               -- either still being written, or already reused by a
+               -- producer that lapped us: Head tells the two apart
+               Index := LLutils.Atomic_Load_32 (Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+               exit when Index - Tail <= SIZE;
+            else
+               Item := R;
+               -- check that the record was not reused while being copied;
+               -- a no-op exchange gives the release ordering a plain load
+               -- would not; without a native CAS the store back must not
+               -- race with a producer invalidating the slot
+               if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+                  CPU.Intcontext_Get (Intcontext);
+                  CPU.Irq_Disable;
+               end if;
+               Unchanged := LLutils.Atomic_Compare_Exchange_32 (
+                               R.Sequence'Address,
+                               Tail + 1,
+                               Tail + 1,
+                               GCC.Defines.ATOMIC_ACQ_REL
+                               );
+               if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+                  CPU.Intcontext_Set (Intcontext);
+               end if;
+               if Unchanged then
+                  Tail := @ + 1;
+                  Success := True;
+                  exit;
+               end if;
+               Lost_Records := @ + 1;
+               Tail := @ + 1;
+            end if;
+         end;
+      end loop;
+   end Get;
+
+   ----------------------------------------------------------------------------
+   -- Lost
+   ----------------------------------------------------------------------------
+   function Lost
+      return Unsigned_32
+      is
+   begin
+      return Lost_Records;
+   end Lost;
+
+   ----------------------------------------------------------------------------
+   -- Print
+   ----------------------------------------------------------------------------
+   procedure Print
+      (Item : in Record_Type)
+      is
+   begin
+      Console.Print (Prefix => "[", Value => Item.Timestamp);
+      Console.Print ("] ");
+      Console.Print (Level_Name (Item.Level));
+      Console.Print (Prefix => " ", Value => Unsigned_16 (Item.Event));
+      Console.Print (Prefix => " ", Value => Item.Arg1);
+      Console.Print (Prefix => " ", Value => Item.Arg2, NL => True);
+   end Print;
+
+   ----------------------------------------------------------------------------
+   -- Dump
+   ----------------------------------------------------------------------------
+   procedure Dump
+      is
+      Item    : Record_Type;
+      Success : Boolean;
+   begin
+      loop
+         Get (Item, Success);
+         exit when not Success;
+         Print (Item);
+      end loop;
+      Console.Print (Prefix => "lost: ", Value => Lost_Records, NL => True);
+   end Dump;
+
+end Trace;
@@ -0,0 +1,54 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memory_functions-ememcpy.adb                                                                              --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Machine_Code;
+with Ada.Characters.Latin_1;
+
+separate (Memory_Functions)
+function EMemcpy
+   (S1 : Interfaces.C.Extensions.void_ptr;
+    S2 : Interfaces.C.Extensions.void_ptr;
+    N  : Interfaces.C.size_t)
+   return Interfaces.C.Extensions.void_ptr
+   is
+   use System.Machine_Code;
+   package ISO88591 renames Ada.Characters.Latin_1;
+   CRLF  : constant String := ISO88591.CR & ISO88591.LF;
+   Dest  : System.Address with Unreferenced => True;
+   Src   : System.Address with Unreferenced => True;
+   Count : Interfaces.C.size_t with Unreferenced => True;
+begin
+   -- ERMS "rep movsb", DF is clear as mandated by the ABI
+   Asm (
+        Template => ""                    & CRLF &
+                    "        rep movsb  " & CRLF &
+                    "",
+        Outputs  => [
+                     System.Address'Asm_Output ("=D", Dest),
+                     System.Address'Asm_Output ("=S", Src),
+                     Interfaces.C.size_t'Asm_Output ("=c", Count)
+                    ],
+        Inputs   => [
+                     System.Address'Asm_Input ("0", S1),
+                     System.Address'Asm_Input ("1", S2),
+                     Interfaces.C.size_t'Asm_Input ("2", N)
+                    ],
+        Clobber  => "memory",
+        Volatile => True
+       );
+   return S1;
+end EMemcpy;
@@ -0,0 +1,58 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memory_functions-ememset.adb                                                                              --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Machine_Code;
+with Ada.Characters.Latin_1;
+with Ada.Unchecked_Conversion;
+
+separate (Memory_Functions)
+function EMemset
+   (S : Interfaces.C.Extensions.void_ptr;
+    C : Interfaces.C.int;
+    N : Interfaces.C.size_t)
+   return Interfaces.C.Extensions.void_ptr
+   is
+   use System.Machine_Code;
+   use Interfaces.C;
+   package ISO88591 renames Ada.Characters.Latin_1;
+   type int_mod is mod 2**int'Size;
+   CRLF   : constant String := ISO88591.CR & ISO88591.LF;
+   Ic     : Interfaces.Unsigned_8;
+   Dest   : System.Address with Unreferenced => True;
+   Count  : size_t with Unreferenced => True;
+   function To_im is new Ada.Unchecked_Conversion (int, int_mod);
+begin
+   Ic := Interfaces.Unsigned_8 (To_im (C) mod 2**8);
+   -- ERMS "rep stosb", DF is clear as mandated by the ABI
+   Asm (
+        Template => ""                    & CRLF &
+                    "        rep stosb  " & CRLF &
+                    "",
+        Outputs  => [
+                     System.Address'Asm_Output ("=D", Dest),
+                     size_t'Asm_Output ("=c", Count)
+                    ],
+        Inputs   => [
+                     System.Address'Asm_Input ("0", S),
+                     size_t'Asm_Input ("1", N),
+                     Interfaces.Unsigned_8'Asm_Input ("a", Ic)
+                    ],
+        Clobber  => "memory",
+        Volatile => True
+       );
+   return S;
+end EMemset;
@@ -0,0 +1,23 @@
+
+/*
+ * string-asm.h - x86-64 assembler string kernels.
+ *
+ * Copyright (C) 2020-2026 Gabriele Galeotti
+ *
+ * This work is licensed under the terms of the MIT License.
+ * Please consult the LICENSE.txt file located in the top-level directory.
+ */
+
+#ifndef _STRING_ASM_H
+#define _STRING_ASM_H 1
+
+/*
+ * Functions provided by string-asm.S, the generic versions in string.c are
+ * not compiled.
+ */
+#define STRING_ASM_MEMCHR 1
+#define STRING_ASM_STRCHR 1
+#define STRING_ASM_STRCMP 1
+#define STRING_ASM_STRLEN 1
+
+#endif /* _STRING_ASM_H */
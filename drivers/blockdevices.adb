@@ -90,4 +90,96 @@ package body BlockDevices
           S => (Natural (Sector_Number) rem CHS_Geometry.S) + 1);
    end To_CHS;
 
+   --------------------------------------------------------------------------
+   -- Read
+   --------------------------------------------------------------------------
+   procedure Read
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       B       :    out Block_Type;
+       Success :    out Boolean)
+      is
+      Chunk_Size : constant Natural := D.Max_Transfer * D.Block_Size;
+      First      : Natural;
+      Last       : Natural;
+      Block      : Sector_Type;
+   begin
+      if D.Read_Blocks = null or else B'Length mod D.Block_Size /= 0 then
+         Success := False;
+         return;
+      end if;
+      Success := True;
+      First := B'First;
+      Block := S;
+      while Success and then First <= B'Last loop
+         Last := Natural'Min (First + Chunk_Size - 1, B'Last);
+         D.Read_Blocks (D.Data_Address, Block, B (First .. Last), Success);
+         Block := @ + Sector_Type ((Last - First + 1) / D.Block_Size);
+         First := Last + 1;
+      end loop;
+   end Read;
+
+   --------------------------------------------------------------------------
+   -- Write
+   --------------------------------------------------------------------------
+   procedure Write
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       B       : in     Block_Type;
+       Success :    out Boolean)
+      is
+      Chunk_Size : constant Natural := D.Max_Transfer * D.Block_Size;
+      First      : Natural;
+      Last       : Natural;
+      Block      : Sector_Type;
+   begin
+      if D.Write_Blocks = null or else B'Length mod D.Block_Size /= 0 then
+         Success := False;
+         return;
+      end if;
+      Success := True;
+      First := B'First;
+      Block := S;
+      while Success and then First <= B'Last loop
+         Last := Natural'Min (First + Chunk_Size - 1, B'Last);
+         D.Write_Blocks (D.Data_Address, Block, B (First .. Last), Success);
+         Block := @ + Sector_Type ((Last - First + 1) / D.Block_Size);
+         First := Last + 1;
+      end loop;
+   end Write;
+
+   --------------------------------------------------------------------------
+   -- Flush
+   --------------------------------------------------------------------------
+   procedure Flush
+      (D       : in     Descriptor_Type;
+       Success :    out Boolean)
+      is
+   begin
+      if D.Flush /= null then
+         D.Flush (D.Data_Address, Success);
+      else
+         Success := True;
+      end if;
+   end Flush;
+
+   --------------------------------------------------------------------------
+   -- Map
+   --------------------------------------------------------------------------
+   procedure Map
+      (D             : in     Descriptor_Type;
+       S             : in     Sector_Type;
+       Count         : in     Positive;
+       Block_Address :    out Address;
+       Success       :    out Boolean)
+      is
+   begin
+      if D.Map_Blocks /= null then
+         D.Map_Blocks (D.Data_Address, S, Count, Block_Address, Success);
+      else
+         Block_Address := Null_Address;
+         Success := False;
+      end if;
+   end Map;
+
 end BlockDevices;
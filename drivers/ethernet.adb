@@ -15,7 +15,9 @@
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
 
+with System.Storage_Elements;
 with CPU;
+with Timers;
 with Console;
 
 package body Ethernet
@@ -31,17 +33,121 @@ package body Ethernet
 
 pragma Warnings (Off, "* is not referenced");
 
+   use System.Storage_Elements;
+
    IEEE8023_Max_Length : constant := 1500;
+   ETH_FRAME_MIN       : constant := 60;   -- without FCS
 
    EtherType_IPv4 : constant := 16#0800#;
    EtherType_ARP  : constant := 16#0806#;
    EtherType_RARP : constant := 16#8035#;
    EtherType_IPv6 : constant := 16#86DD#;
 
-   The_Descriptor : Descriptor_Type := DESCRIPTOR_INVALID;
+   ----------------------------------------------------------------------------
+   -- Interfaces
+   ----------------------------------------------------------------------------
+
+   Descriptors        : array (Valid_Interface_Id_Type) of Descriptor_Type := [others => DESCRIPTOR_INVALID];
+   Interface_Counters : array (Valid_Interface_Id_Type) of Counters_Type;
+   Ninterfaces        : Interface_Id_Type := 0;
+   Current            : Interface_Id_Type := NO_INTERFACE;
+
+   -- set by device interrupt handlers, cleared by Poll
+   Poll_Flags : array (Valid_Interface_Id_Type) of Boolean := [others => False]
+      with Atomic_Components => True;
+
+   ----------------------------------------------------------------------------
+   -- Routing table
+   ----------------------------------------------------------------------------
+
+   type Route_Type is record
+      Destination : IPv4_Address_Type := [others => 0];
+      Netmask     : IPv4_Address_Type := [others => 0];
+      Gateway     : IPv4_Address_Type := [others => 0];
+      Prefix      : Natural           := 0;            -- Netmask length
+      Id          : Interface_Id_Type := NO_INTERFACE; -- NO_INTERFACE = free
+   end record;
+
+   Routes : array (1 .. ETH_NROUTES) of Route_Type;
+
+   function Masked
+      (Paddress : IPv4_Address_Type;
+       Netmask  : IPv4_Address_Type)
+      return IPv4_Address_Type
+      with Inline => True;
+   function Prefix_Length
+      (Netmask : IPv4_Address_Type)
+      return Natural;
+   function Is_Broadcast
+      (Id       : Valid_Interface_Id_Type;
+       Paddress : IPv4_Address_Type)
+      return Boolean;
+
+   ----------------------------------------------------------------------------
+   -- ARP cache
+   ----------------------------------------------------------------------------
+
+   ARP_NSETS : constant := ARP_NENTRIES / ARP_NWAYS;
+
+   type ARP_State_Type is (ARP_FREE, ARP_PENDING, ARP_RESOLVED);
+
+   subtype ARP_Queue_Count_Type is Natural range 0 .. ARP_NQUEUED;
+
+   type ARP_Queue_Type is array (1 .. ARP_NQUEUED) of Pbuf_Ptr;
+
+   type ARP_Entry_Type is record
+      State    : ARP_State_Type       := ARP_FREE;
+      Paddress : IPv4_Address_Type    := [others => 0];
+      Haddress : MAC_Address_Type     := [others => 0];
+      Id       : Interface_Id_Type    := NO_INTERFACE;     -- link of the neighbour
+      TTL      : Natural              := 0;                -- aging periods left
+      Request  : Boolean              := False;            -- (re)send a request
+      Queued   : ARP_Queue_Type       := [others => null]; -- waiting for resolution, oldest first
+      Nqueued  : ARP_Queue_Count_Type := 0;
+   end record;
+
+   subtype ARP_Way_Type is Natural range 0 .. ARP_NWAYS - 1;
+   subtype ARP_Set_Type is Natural range 0 .. ARP_NSETS - 1;
+
+   ARP_Cache : array (ARP_Set_Type, ARP_Way_Type) of ARP_Entry_Type;
+
+   ARP_Timer : aliased Timers.Periodic_Type;
+
+   function ARP_Set
+      (Paddress : IPv4_Address_Type)
+      return ARP_Set_Type
+      with Inline => True;
+   procedure ARP_Lookup
+      (Paddress : in     IPv4_Address_Type;
+       Set      :    out ARP_Set_Type;
+       Way      :    out ARP_Way_Type;
+       Found    :    out Boolean);
+   procedure ARP_Insert
+      (Id       : in     Valid_Interface_Id_Type;
+       Paddress : in     IPv4_Address_Type;
+       Set      :    out ARP_Set_Type;
+       Way      :    out ARP_Way_Type);
+   procedure ARP_Queue_Flush
+      (E : in out ARP_Entry_Type);
+   procedure ARP_Update
+      (Id       : in Valid_Interface_Id_Type;
+       Haddress : in MAC_Address_Type;
+       Paddress : in IPv4_Address_Type;
+       Create   : in Boolean);
+   procedure ARP_Request_Send
+      (Id       : in Valid_Interface_Id_Type;
+       Paddress : in IPv4_Address_Type);
+   procedure ARP_Age
+      (Data : in Address);
+   procedure ARP_Service;
+   procedure Frame_Send
+      (Id       : in Valid_Interface_Id_Type;
+       P        : in Pbuf_Ptr;
+       Haddress : in MAC_Address_Type);
 
    procedure ARP_Handler
-      (P : in Pbuf_Ptr);
+      (Id : in Valid_Interface_Id_Type;
+       P  : in Pbuf_Ptr);
 
    --========================================================================--
    --                                                                        --
@@ -51,38 +157,370 @@ pragma Warnings (Off, "* is not referenced");
    --                                                                        --
    --========================================================================--
 
+   ----------------------------------------------------------------------------
+   -- Masked
+   ----------------------------------------------------------------------------
+   function Masked
+      (Paddress : IPv4_Address_Type;
+       Netmask  : IPv4_Address_Type)
+      return IPv4_Address_Type
+      is
+   begin
+      return [
+         Paddress (0) and Netmask (0),
+         Paddress (1) and Netmask (1),
+         Paddress (2) and Netmask (2),
+         Paddress (3) and Netmask (3)
+         ];
+   end Masked;
+
+   ----------------------------------------------------------------------------
+   -- Prefix_Length
+   ----------------------------------------------------------------------------
+   function Prefix_Length
+      (Netmask : IPv4_Address_Type)
+      return Natural
+      is
+      Result : Natural := 0;
+   begin
+      for Value of Netmask loop
+         for Bit in 0 .. 7 loop
+            if (Value and Shift_Left (Unsigned_8'(1), Bit)) /= 0 then
+               Result := @ + 1;
+            end if;
+         end loop;
+      end loop;
+      return Result;
+   end Prefix_Length;
+
+   ----------------------------------------------------------------------------
+   -- Is_Broadcast
+   ----------------------------------------------------------------------------
+   -- Limited broadcast, or directed broadcast of the network of interface
+   -- Id.
+   ----------------------------------------------------------------------------
+   function Is_Broadcast
+      (Id       : Valid_Interface_Id_Type;
+       Paddress : IPv4_Address_Type)
+      return Boolean
+      is
+      D : Descriptor_Type renames Descriptors (Id);
+   begin
+      if Paddress = [255, 255, 255, 255] then
+         return True;
+      end if;
+      if D.Paddress = [0, 0, 0, 0] or else D.Netmask = [255, 255, 255, 255] then
+         return False;
+      end if;
+      for Index in Paddress'Range loop
+         if Paddress (Index) /= (D.Paddress (Index) or not D.Netmask (Index)) then
+            return False;
+         end if;
+      end loop;
+      return True;
+   end Is_Broadcast;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Set
+   ----------------------------------------------------------------------------
+   function ARP_Set
+      (Paddress : IPv4_Address_Type)
+      return ARP_Set_Type
+      is
+   begin
+      return ARP_Set_Type (
+         (Paddress (0) xor Paddress (1) xor Paddress (2) xor Paddress (3)) mod ARP_NSETS
+         );
+   end ARP_Set;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Lookup
+   ----------------------------------------------------------------------------
+   -- Called with interrupts disabled.
+   ----------------------------------------------------------------------------
+   procedure ARP_Lookup
+      (Paddress : in     IPv4_Address_Type;
+       Set      :    out ARP_Set_Type;
+       Way      :    out ARP_Way_Type;
+       Found    :    out Boolean)
+      is
+   begin
+      Set := ARP_Set (Paddress);
+      for Index in ARP_Way_Type loop
+         if ARP_Cache (Set, Index).State /= ARP_FREE and then
+            ARP_Cache (Set, Index).Paddress = Paddress
+         then
+            Way := Index;
+            Found := True;
+            return;
+         end if;
+      end loop;
+      Way := ARP_Way_Type'First;
+      Found := False;
+   end ARP_Lookup;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Insert
+   ----------------------------------------------------------------------------
+   -- Claim an entry for Paddress, evicting the one closest to expiry if
+   -- the set is full; called with interrupts disabled.
+   ----------------------------------------------------------------------------
+   procedure ARP_Insert
+      (Id       : in     Valid_Interface_Id_Type;
+       Paddress : in     IPv4_Address_Type;
+       Set      :    out ARP_Set_Type;
+       Way      :    out ARP_Way_Type)
+      is
+   begin
+      Set := ARP_Set (Paddress);
+      Way := ARP_Way_Type'First;
+      for Index in ARP_Way_Type loop
+         if ARP_Cache (Set, Index).State = ARP_FREE then
+            Way := Index;
+            exit;
+         end if;
+         if ARP_Cache (Set, Index).TTL < ARP_Cache (Set, Way).TTL then
+            Way := Index;
+         end if;
+      end loop;
+      ARP_Queue_Flush (ARP_Cache (Set, Way));
+      ARP_Cache (Set, Way) := (
+         State    => ARP_PENDING,
+         Paddress => Paddress,
+         Haddress => [others => 0],
+         Id       => Id,
+         TTL      => ARP_RETRIES,
+         Request  => False,
+         Queued   => [others => null],
+         Nqueued  => 0
+         );
+   end ARP_Insert;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Queue_Flush
+   ----------------------------------------------------------------------------
+   -- Drop the packets waiting for an entry; called with interrupts disabled.
+   ----------------------------------------------------------------------------
+   procedure ARP_Queue_Flush
+      (E : in out ARP_Entry_Type)
+      is
+   begin
+      for Index in 1 .. E.Nqueued loop
+         Free (E.Queued (Index));
+         E.Queued (Index) := null;
+      end loop;
+      E.Nqueued := 0;
+   end ARP_Queue_Flush;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Update
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 826 "Packet Reception"
+   -- Merge a sender mapping into the cache, adding it only if Create; the
+   -- packets waiting for the mapping are sent, in order.
+   ----------------------------------------------------------------------------
+   procedure ARP_Update
+      (Id       : in Valid_Interface_Id_Type;
+       Haddress : in MAC_Address_Type;
+       Paddress : in IPv4_Address_Type;
+       Create   : in Boolean)
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Set        : ARP_Set_Type;
+      Way        : ARP_Way_Type;
+      Found      : Boolean;
+      Queued     : ARP_Queue_Type;
+      Nqueued    : ARP_Queue_Count_Type := 0;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      ARP_Lookup (Paddress, Set, Way, Found);
+      if not Found and then Create then
+         ARP_Insert (Id, Paddress, Set, Way);
+         Found := True;
+      end if;
+      if Found then
+         ARP_Cache (Set, Way).State    := ARP_RESOLVED;
+         ARP_Cache (Set, Way).Haddress := Haddress;
+         ARP_Cache (Set, Way).Id       := Id;
+         ARP_Cache (Set, Way).TTL      := ARP_TTL;
+         ARP_Cache (Set, Way).Request  := False;
+         Queued  := ARP_Cache (Set, Way).Queued;
+         Nqueued := ARP_Cache (Set, Way).Nqueued;
+         ARP_Cache (Set, Way).Queued   := [others => null];
+         ARP_Cache (Set, Way).Nqueued  := 0;
+      end if;
+      CPU.Intcontext_Set (Intcontext);
+      for Index in 1 .. Nqueued loop
+         Frame_Send (Id, Queued (Index), Haddress);
+         Free (Queued (Index));
+      end loop;
+   end ARP_Update;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Request_Send
+   ----------------------------------------------------------------------------
+   procedure ARP_Request_Send
+      (Id       : in Valid_Interface_Id_Type;
+       Paddress : in IPv4_Address_Type)
+      is
+      P : Pbuf_Ptr;
+   begin
+      P := Allocate (ETH_FRAME_MIN);
+      if P = null then
+         return;
+      end if;
+      P.all.Payload (0 .. ETH_FRAME_MIN - 1) := [others => 0];
+      declare
+         ETH_Header : aliased Ethernet_Header_Type
+            with Address    => Payload_CurrentAddress (P),
+                 Import     => True,
+                 Convention => Ada;
+         ARP_Header : aliased ARP_Header_Type
+            with Address    => Payload_CurrentAddress (P) + ETH_HDR_SIZE,
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         ETH_Header.MAC_Destination := BROADCAST_MAC;
+         ETH_Header.MAC_Source      := Descriptors (Id).Haddress;
+         ETH_Header.Type_or_Length  := HToN (Unsigned_16'(EtherType_ARP));
+         ARP_Header.Htype           := HToN (Unsigned_16'(1));              -- Ethernet
+         ARP_Header.Ptype           := HToN (Unsigned_16'(EtherType_IPv4));
+         ARP_Header.Hlen            := 6;
+         ARP_Header.Plen            := 4;
+         ARP_Header.Oper            := HToN (Unsigned_16'(ARP_REQUEST));
+         ARP_Header.Sha             := Descriptors (Id).Haddress;
+         ARP_Header.Spa             := Descriptors (Id).Paddress;
+         ARP_Header.Tha             := [others => 0];
+         ARP_Header.Tpa             := Paddress;
+      end;
+      TX (Id, P);
+      Free (P);
+   end ARP_Request_Send;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Age
+   ----------------------------------------------------------------------------
+   -- Timer procedure, runs once per aging period from Timers.Process.
+   ----------------------------------------------------------------------------
+   procedure ARP_Age
+      (Data : in Address)
+      is
+      pragma Unreferenced (Data);
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      for E of ARP_Cache loop
+         if E.State /= ARP_FREE then
+            if E.TTL /= 0 then
+               E.TTL := @ - 1;
+            end if;
+            if E.TTL = 0 then
+               ARP_Queue_Flush (E);
+               E.State := ARP_FREE;
+            elsif E.State = ARP_PENDING then
+               -- requests are sent by ARP_Service, outside interrupt context
+               E.Request := True;
+            end if;
+         end if;
+      end loop;
+      CPU.Intcontext_Set (Intcontext);
+   end ARP_Age;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Service
+   ----------------------------------------------------------------------------
+   -- Send the requests flagged by ARP_Age.
+   ----------------------------------------------------------------------------
+   procedure ARP_Service
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Paddress   : IPv4_Address_Type;
+      Id         : Interface_Id_Type;
+      Request    : Boolean;
+   begin
+      for E of ARP_Cache loop
+         CPU.Intcontext_Get (Intcontext);
+         CPU.Irq_Disable;
+         Request := E.Request;
+         E.Request := False;
+         Paddress := E.Paddress;
+         Id := E.Id;
+         CPU.Intcontext_Set (Intcontext);
+         if Request and then Id /= NO_INTERFACE then
+            ARP_Request_Send (Id, Paddress);
+         end if;
+      end loop;
+   end ARP_Service;
+
+   ----------------------------------------------------------------------------
+   -- Frame_Send
+   ----------------------------------------------------------------------------
+   -- Prepend the Ethernet header to the IPv4 packet at the current payload
+   -- of P and transmit it.
+   ----------------------------------------------------------------------------
+   procedure Frame_Send
+      (Id       : in Valid_Interface_Id_Type;
+       P        : in Pbuf_Ptr;
+       Haddress : in MAC_Address_Type)
+      is
+   begin
+      Payload_Adjust (P, +ETH_HDR_SIZE);
+      declare
+         ETH_Header : aliased Ethernet_Header_Type
+            with Address    => Payload_CurrentAddress (P),
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         ETH_Header.MAC_Destination := Haddress;
+         ETH_Header.MAC_Source      := Descriptors (Id).Haddress;
+         ETH_Header.Type_or_Length  := HToN (Unsigned_16'(EtherType_IPv4));
+      end;
+      TX (Id, P);
+   end Frame_Send;
+
    ----------------------------------------------------------------------------
    -- ARP_Handler
    ----------------------------------------------------------------------------
    procedure ARP_Handler
-      (P : in Pbuf_Ptr)
+      (Id : in Valid_Interface_Id_Type;
+       P  : in Pbuf_Ptr)
       is
       ARP_Header : aliased ARP_Header_Type
          with Address    => Payload_CurrentAddress (P),
               Import     => True,
               Convention => Ada;
+      For_Us     : Boolean;
    begin
+      if NToH (ARP_Header.Htype) /= 1 or else NToH (ARP_Header.Ptype) /= EtherType_IPv4 then
+         return;
+      end if;
+      -- an interface still without address owns none
+      For_Us := Descriptors (Id).Paddress /= [0, 0, 0, 0] and then ARP_Header.Tpa = Descriptors (Id).Paddress;
+      -- learn the sender from requests, replies and gratuitous ARP alike
+      -- (an address probe has Spa = 0.0.0.0)
+      if ARP_Header.Spa /= [0, 0, 0, 0] then
+         ARP_Update (Id, ARP_Header.Sha, ARP_Header.Spa, Create => For_Us);
+      end if;
       case NToH (ARP_Header.Oper) is
          when ARP_REQUEST =>
             -- Console.Print ("ARP_REQUEST", NL => True);
-            if ARP_Header.Tpa = The_Descriptor.Paddress then
+            if For_Us then
                -- __FIX__ exploit received packet: change src/dst IP
-               ARP_Header.Oper := HToN (ARP_REPLY);                -- reply
-               ARP_Header.Tha  := ARP_Header.Sha;                  -- target IP is sender IP
+               ARP_Header.Oper := HToN (ARP_REPLY);                  -- reply
+               ARP_Header.Tha  := ARP_Header.Sha;                    -- target IP is sender IP
                ARP_Header.Tpa  := ARP_Header.Spa;
-               ARP_Header.Sha  := The_Descriptor.Haddress;         -- sender = myself
-               ARP_Header.Spa  := The_Descriptor.Paddress;
-               Payload_Rewind (P);                                 -- uncover ETH header
-               P.all.Payload (0 .. 5)  := P.all.Payload (6 .. 11); -- target MAC is sender MAC
-               P.all.Payload (6 .. 11) := The_Descriptor.Haddress; -- sender = myself
-               TX (P);
+               ARP_Header.Sha  := Descriptors (Id).Haddress;         -- sender = myself
+               ARP_Header.Spa  := Descriptors (Id).Paddress;
+               Payload_Rewind (P);                                   -- uncover ETH header
+               P.all.Payload (0 .. 5)  := P.all.Payload (6 .. 11);   -- target MAC is sender MAC
+               P.all.Payload (6 .. 11) := Descriptors (Id).Haddress; -- sender = myself
+               TX (Id, P);
             end if;
          when ARP_REPLY =>
-            -- "gratuitous" ARP, check for:
-            -- sender's hardware and protocol addresses (SHA and SPA)
-            -- duplicated in the target fields (TPA=SPA, THA=SHA)
-            -- action: update ARP cache
-            -- Console.Print ("ARP_REPLY (gratuitous ARP)", NL => True);
+            -- cache already updated
+            -- Console.Print ("ARP_REPLY", NL => True);
             null;
          when others =>
             -- Console.Print ("ARP unknown operation", NL => True);
@@ -94,29 +532,130 @@ pragma Warnings (Off, "* is not referenced");
    -- Init
    ----------------------------------------------------------------------------
    procedure Init
-      (D : in Descriptor_Type) is
+      is
    begin
       PBUF.Init;
-      The_Descriptor := D;
+      Descriptors := [others => DESCRIPTOR_INVALID];
+      Interface_Counters := [others => <>];
+      Ninterfaces := 0;
+      Current := NO_INTERFACE;
+      Routes := [others => <>];
    end Init;
 
+   ----------------------------------------------------------------------------
+   -- Interface_Add
+   ----------------------------------------------------------------------------
+   procedure Interface_Add
+      (D  : in     Descriptor_Type;
+       Id :    out Interface_Id_Type)
+      is
+      Success : Boolean;
+   begin
+      if Ninterfaces = ETH_NINTERFACES then
+         Id := NO_INTERFACE;
+         return;
+      end if;
+      Ninterfaces := @ + 1;
+      Id := Ninterfaces;
+      Descriptors (Id) := D;
+      if D.Paddress /= [0, 0, 0, 0] then
+         Route_Add (Masked (D.Paddress, D.Netmask), D.Netmask, [0, 0, 0, 0], Id, Success);
+      end if;
+   end Interface_Add;
+
+   ----------------------------------------------------------------------------
+   -- Address_Set
+   ----------------------------------------------------------------------------
+   procedure Address_Set
+      (Id       : in Valid_Interface_Id_Type;
+       Paddress : in IPv4_Address_Type;
+       Netmask  : in IPv4_Address_Type)
+      is
+      Success : Boolean;
+   begin
+      if Descriptors (Id).Paddress /= [0, 0, 0, 0] then
+         Route_Delete (
+            Masked (Descriptors (Id).Paddress, Descriptors (Id).Netmask),
+            Descriptors (Id).Netmask,
+            Id
+            );
+      end if;
+      Descriptors (Id).Paddress := Paddress;
+      Descriptors (Id).Netmask  := Netmask;
+      if Paddress /= [0, 0, 0, 0] then
+         Route_Add (Masked (Paddress, Netmask), Netmask, [0, 0, 0, 0], Id, Success);
+      end if;
+   end Address_Set;
+
+   ----------------------------------------------------------------------------
+   -- Interface_Count
+   ----------------------------------------------------------------------------
+   function Interface_Count
+      return Interface_Id_Type
+      is
+   begin
+      return Ninterfaces;
+   end Interface_Count;
+
    ----------------------------------------------------------------------------
    -- Descriptor_Get
    ----------------------------------------------------------------------------
    function Descriptor_Get
+      (Id : Valid_Interface_Id_Type)
       return Descriptor_Type
       is
    begin
-      return The_Descriptor;
+      return Descriptors (Id);
    end Descriptor_Get;
 
+   ----------------------------------------------------------------------------
+   -- Counters
+   ----------------------------------------------------------------------------
+   function Counters
+      (Id : Valid_Interface_Id_Type)
+      return Counters_Type
+      is
+   begin
+      return Interface_Counters (Id);
+   end Counters;
+
+   ----------------------------------------------------------------------------
+   -- Current_Interface
+   ----------------------------------------------------------------------------
+   function Current_Interface
+      return Interface_Id_Type
+      is
+   begin
+      return Current;
+   end Current_Interface;
+
+   ----------------------------------------------------------------------------
+   -- Is_Local
+   ----------------------------------------------------------------------------
+   function Is_Local
+      (Paddress : IPv4_Address_Type)
+      return Boolean
+      is
+   begin
+      if Paddress = [0, 0, 0, 0] then
+         return False;
+      end if;
+      for Id in 1 .. Ninterfaces loop
+         if Descriptors (Id).Paddress = Paddress then
+            return True;
+         end if;
+      end loop;
+      return False;
+   end Is_Local;
+
    ----------------------------------------------------------------------------
    -- Packet_Handler
    ----------------------------------------------------------------------------
    -- src/netif/ethernetif.c:ethernetif_input()
    ----------------------------------------------------------------------------
    procedure Packet_Handler
-      (P : in Pbuf_Ptr)
+      (Id : in Valid_Interface_Id_Type;
+       P  : in Pbuf_Ptr)
       is
       ETH_Header : aliased Ethernet_Header_Type
          with Address    => Payload_CurrentAddress (P),
@@ -126,12 +665,13 @@ pragma Warnings (Off, "* is not referenced");
       -- Console.Print ("---------------------------------------------------------", NL => True);
       -- Console.Print (P.all.Total_Size, Prefix => "length: ", NL => True);
       -- Console.Print_Memory (Payload_Address (P), Bytelength (P.all.Size), 16);
+      Current := Id;
       Payload_Adjust (P, -ETH_HDR_SIZE);
       case NToH (ETH_Header.Type_or_Length) is
          ---------------------
          when EtherType_ARP =>
             -- Console.Print ("ARP", NL => True);
-            ARP_Handler (P);
+            ARP_Handler (Id, P);
          ----------------------
          when EtherType_IPv4 =>
             -- Console.Print ("IPv4", NL => True);
@@ -141,18 +681,310 @@ pragma Warnings (Off, "* is not referenced");
             -- Console.Print ("UNKNOWN", NL => True);
             null;
       end case;
+      Current := NO_INTERFACE;
    end Packet_Handler;
 
    ----------------------------------------------------------------------------
    -- TX
    ----------------------------------------------------------------------------
    procedure TX
-      (P : in Pbuf_Ptr)
+      (Id : in Valid_Interface_Id_Type;
+       P  : in Pbuf_Ptr)
       is
    begin
-      The_Descriptor.TX.all (The_Descriptor.Data_Address, P);
+      Interface_Counters (Id).TX_Frames := @ + 1;
+      Interface_Counters (Id).TX_Bytes  := @ + Unsigned_32 (P.all.Total_Size);
+      Descriptors (Id).TX.all (Descriptors (Id).Data_Address, P);
    end TX;
 
+   ----------------------------------------------------------------------------
+   -- Input
+   ----------------------------------------------------------------------------
+   procedure Input
+      (Id      : in     Interface_Id_Type;
+       P       : in     Pbuf_Ptr;
+       Success :    out Boolean)
+      is
+      Size : Natural;
+   begin
+      if Id = NO_INTERFACE then
+         -- device not attached yet
+         Success := False;
+         return;
+      end if;
+      -- once queued, P belongs to the consumer
+      Size := P.all.Total_Size;
+      Packet_Rings.Put (Packet_Queues (Id)'Access, P, Success);
+      if Success then
+         Interface_Counters (Id).RX_Frames := @ + 1;
+         Interface_Counters (Id).RX_Bytes  := @ + Unsigned_32 (Size);
+      else
+         Interface_Counters (Id).RX_Dropped := @ + 1;
+      end if;
+   end Input;
+
+   ----------------------------------------------------------------------------
+   -- Route_Add
+   ----------------------------------------------------------------------------
+   procedure Route_Add
+      (Destination : in     IPv4_Address_Type;
+       Netmask     : in     IPv4_Address_Type;
+       Gateway     : in     IPv4_Address_Type;
+       Id          : in     Valid_Interface_Id_Type;
+       Success     :    out Boolean)
+      is
+   begin
+      for R of Routes loop
+         if R.Id = NO_INTERFACE then
+            R := (
+               Destination => Masked (Destination, Netmask),
+               Netmask     => Netmask,
+               Gateway     => Gateway,
+               Prefix      => Prefix_Length (Netmask),
+               Id          => Id
+               );
+            Success := True;
+            return;
+         end if;
+      end loop;
+      Success := False;
+   end Route_Add;
+
+   ----------------------------------------------------------------------------
+   -- Route_Delete
+   ----------------------------------------------------------------------------
+   procedure Route_Delete
+      (Destination : in IPv4_Address_Type;
+       Netmask     : in IPv4_Address_Type;
+       Id          : in Valid_Interface_Id_Type)
+      is
+   begin
+      for R of Routes loop
+         if R.Id = Id                                     and then
+            R.Netmask = Netmask                           and then
+            R.Destination = Masked (Destination, Netmask)
+         then
+            R := (others => <>);
+         end if;
+      end loop;
+   end Route_Delete;
+
+   ----------------------------------------------------------------------------
+   -- Route_Lookup
+   ----------------------------------------------------------------------------
+   procedure Route_Lookup
+      (Paddress : in     IPv4_Address_Type;
+       Id       :    out Interface_Id_Type;
+       Next_Hop :    out IPv4_Address_Type)
+      is
+      Best : Natural := 0;
+   begin
+      Id := NO_INTERFACE;
+      Next_Hop := Paddress;
+      if Paddress = [255, 255, 255, 255] then
+         -- limited broadcast: a host route, or the first interface; a
+         -- default route must not catch it
+         for R of Routes loop
+            if R.Id /= NO_INTERFACE and then R.Prefix = 32 and then R.Destination = Paddress then
+               Id := R.Id;
+               return;
+            end if;
+         end loop;
+         if Ninterfaces /= 0 then
+            Id := 1;
+         end if;
+         return;
+      end if;
+      for Index in Routes'Range loop
+         if Routes (Index).Id /= NO_INTERFACE                                    and then
+            Masked (Paddress, Routes (Index).Netmask) = Routes (Index).Destination and then
+            (Best = 0 or else Routes (Index).Prefix > Routes (Best).Prefix)
+         then
+            Best := Index;
+         end if;
+      end loop;
+      if Best /= 0 then
+         Id := Routes (Best).Id;
+         if Routes (Best).Gateway /= [0, 0, 0, 0] then
+            Next_Hop := Routes (Best).Gateway;
+         end if;
+      end if;
+   end Route_Lookup;
+
+   ----------------------------------------------------------------------------
+   -- Source_Address
+   ----------------------------------------------------------------------------
+   function Source_Address
+      (Paddress : IPv4_Address_Type)
+      return IPv4_Address_Type
+      is
+      Id       : Interface_Id_Type;
+      Next_Hop : IPv4_Address_Type;
+   begin
+      Route_Lookup (Paddress, Id, Next_Hop);
+      if Id = NO_INTERFACE then
+         return [0, 0, 0, 0];
+      else
+         return Descriptors (Id).Paddress;
+      end if;
+   end Source_Address;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Aging_Start
+   ----------------------------------------------------------------------------
+   procedure ARP_Aging_Start
+      (Period : in Unsigned_32)
+      is
+   begin
+      Timers.Periodic_Start (ARP_Timer'Access, Period, ARP_Age'Access);
+   end ARP_Aging_Start;
+
+   ----------------------------------------------------------------------------
+   -- ARP_Resolve
+   ----------------------------------------------------------------------------
+   procedure ARP_Resolve
+      (Id       : in     Valid_Interface_Id_Type;
+       Paddress : in     IPv4_Address_Type;
+       Haddress :    out MAC_Address_Type;
+       Success  :    out Boolean)
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Set        : ARP_Set_Type;
+      Way        : ARP_Way_Type;
+      Found      : Boolean;
+   begin
+      if Paddress = [255, 255, 255, 255] then
+         Haddress := BROADCAST_MAC;
+         Success := True;
+         return;
+      end if;
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      ARP_Lookup (Paddress, Set, Way, Found);
+      if not Found then
+         ARP_Insert (Id, Paddress, Set, Way);
+      end if;
+      Success := ARP_Cache (Set, Way).State = ARP_RESOLVED;
+      Haddress := ARP_Cache (Set, Way).Haddress;
+      CPU.Intcontext_Set (Intcontext);
+      if not Found then
+         ARP_Request_Send (Id, Paddress);
+      end if;
+   end ARP_Resolve;
+
+   ----------------------------------------------------------------------------
+   -- Output
+   ----------------------------------------------------------------------------
+   procedure Output
+      (P        : in Pbuf_Ptr;
+       Paddress : in IPv4_Address_Type)
+      is
+      Id       : Interface_Id_Type;
+      Next_Hop : IPv4_Address_Type;
+   begin
+      Route_Lookup (Paddress, Id, Next_Hop);
+      if Id /= NO_INTERFACE then
+         Output (P, Id, Next_Hop);
+      end if;
+   end Output;
+
+   procedure Output
+      (P        : in Pbuf_Ptr;
+       Id       : in Valid_Interface_Id_Type;
+       Next_Hop : in IPv4_Address_Type)
+      is
+      Intcontext : CPU.Intcontext_Type;
+      Set        : ARP_Set_Type;
+      Way        : ARP_Way_Type;
+      Haddress   : MAC_Address_Type;
+      Success    : Boolean;
+      Dropped    : Pbuf_Ptr := null;
+   begin
+      if Is_Broadcast (Id, Next_Hop) then
+         Frame_Send (Id, P, BROADCAST_MAC);
+         return;
+      end if;
+      ARP_Resolve (Id, Next_Hop, Haddress, Success);
+      if Success then
+         Frame_Send (Id, P, Haddress);
+         return;
+      end if;
+      -- queue the packet, dropping the oldest one when the queue is full;
+      -- RFC 1122 2.3.2.2 asks to keep at least the most recent one, here
+      -- the fragments of a datagram are kept together
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      ARP_Lookup (Next_Hop, Set, Way, Success);
+      if Success and then ARP_Cache (Set, Way).State = ARP_PENDING then
+         declare
+            E : ARP_Entry_Type renames ARP_Cache (Set, Way);
+         begin
+            Reference (P);
+            if E.Nqueued = ARP_NQUEUED then
+               Dropped := E.Queued (1);
+               E.Queued (1 .. ARP_NQUEUED - 1) := E.Queued (2 .. ARP_NQUEUED);
+               E.Nqueued := @ - 1;
+            end if;
+            E.Nqueued := @ + 1;
+            E.Queued (E.Nqueued) := P;
+         end;
+      end if;
+      CPU.Intcontext_Set (Intcontext);
+      if Dropped /= null then
+         Free (Dropped);
+      end if;
+   end Output;
+
+   ----------------------------------------------------------------------------
+   -- Poll_Schedule
+   ----------------------------------------------------------------------------
+   procedure Poll_Schedule
+      (Id : in Interface_Id_Type)
+      is
+   begin
+      if Id /= NO_INTERFACE then
+         Poll_Flags (Id) := True;
+      end if;
+   end Poll_Schedule;
+
+   ----------------------------------------------------------------------------
+   -- Poll_Pending
+   ----------------------------------------------------------------------------
+   function Poll_Pending
+      return Boolean
+      is
+   begin
+      for Flag of Poll_Flags loop
+         if Flag then
+            return True;
+         end if;
+      end loop;
+      return False;
+   end Poll_Pending;
+
+   ----------------------------------------------------------------------------
+   -- Poll
+   ----------------------------------------------------------------------------
+   procedure Poll
+      (Budget : in Positive := POLL_BUDGET)
+      is
+      Done : Boolean;
+   begin
+      ARP_Service;
+      for Id in 1 .. Ninterfaces loop
+         if Poll_Flags (Id) and then Descriptors (Id).Poll /= null then
+            -- device RX interrupts are masked while the flag is set, so
+            -- clearing it here cannot lose a schedule request
+            Poll_Flags (Id) := False;
+            Descriptors (Id).Poll.all (Descriptors (Id).Data_Address, Budget, Done);
+            if not Done then
+               -- budget exhausted, frames still pending in the device
+               Poll_Flags (Id) := True;
+            end if;
+         end if;
+      end loop;
+   end Poll;
+
    ----------------------------------------------------------------------------
    -- Nqueue
    ----------------------------------------------------------------------------
@@ -161,7 +993,7 @@ pragma Warnings (Off, "* is not referenced");
       return Natural
       is
    begin
-      return Q.all.Count;
+      return Packet_Rings.Count (Q);
    end Nqueue;
 
    ----------------------------------------------------------------------------
@@ -172,19 +1004,8 @@ pragma Warnings (Off, "* is not referenced");
        P       : in     Pbuf_Ptr;
        Success :    out Boolean)
       is
-      Intcontext : CPU.Intcontext_Type;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
-      if (Q.all.Head + 1) = Q.all.Tail then
-         Success := False;
-      else
-         Q.all.Queue (Q.all.Head) := P;
-         Q.all.Head := @ + 1;
-         Q.all.Count := @ + 1;
-         Success := True;
-      end if;
-      CPU.Intcontext_Set (Intcontext);
+      Packet_Rings.Put (Q, P, Success);
    end Enqueue;
 
    ----------------------------------------------------------------------------
@@ -195,22 +1016,37 @@ pragma Warnings (Off, "* is not referenced");
        P       : out    Pbuf_Ptr;
        Success : out    Boolean)
       is
-      Intcontext : CPU.Intcontext_Type;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
-      if Q.all.Tail = Q.all.Head then
+      Packet_Rings.Get (Q, P, Success);
+      if not Success then
          P := null;
-         Success := False;
-      else
-         P := Q.all.Queue (Q.all.Tail);
-         Q.all.Tail := @ + 1;
-         Q.all.Count := @ - 1;
-         Success := True;
       end if;
-      CPU.Intcontext_Set (Intcontext);
    end Dequeue;
 
+   ----------------------------------------------------------------------------
+   -- Enqueue_Batch
+   ----------------------------------------------------------------------------
+   procedure Enqueue_Batch
+      (Q       : access Queue_Type;
+       Packets : in     Pbuf_Array;
+       Count   :    out Natural)
+      is
+   begin
+      Packet_Rings.Put_Batch (Q, Packets, Count);
+   end Enqueue_Batch;
+
+   ----------------------------------------------------------------------------
+   -- Dequeue_Batch
+   ----------------------------------------------------------------------------
+   procedure Dequeue_Batch
+      (Q       : access Queue_Type;
+       Packets :    out Pbuf_Array;
+       Count   :    out Natural)
+      is
+   begin
+      Packet_Rings.Get_Batch (Q, Packets, Count);
+   end Dequeue_Batch;
+
 pragma Warnings (On, "* is not referenced");
 
 end Ethernet;
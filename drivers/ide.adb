@@ -153,8 +153,47 @@ pragma Warnings (Off, "* is not referenced");
    -- Local declarations
    ----------------------------------------------------------------------------
 
-   CMD_PIO_READ  : constant := 16#20#;
-   CMD_PIO_WRITE : constant := 16#30#;
+   CMD_PIO_READ           : constant := 16#20#;
+   CMD_PIO_READ_EXT       : constant := 16#24#;
+   CMD_READ_DMA_EXT       : constant := 16#25#;
+   CMD_READ_MULTIPLE_EXT  : constant := 16#29#;
+   CMD_PIO_WRITE          : constant := 16#30#;
+   CMD_PIO_WRITE_EXT      : constant := 16#34#;
+   CMD_WRITE_DMA_EXT      : constant := 16#35#;
+   CMD_WRITE_MULTIPLE_EXT : constant := 16#39#;
+   CMD_READ_MULTIPLE      : constant := 16#C4#;
+   CMD_WRITE_MULTIPLE     : constant := 16#C5#;
+   CMD_SET_MULTIPLE       : constant := 16#C6#;
+   CMD_READ_DMA           : constant := 16#C8#;
+   CMD_WRITE_DMA          : constant := 16#CA#;
+   CMD_FLUSH_CACHE        : constant := 16#E7#;
+   CMD_FLUSH_CACHE_EXT    : constant := 16#EA#;
+   CMD_IDENTIFY           : constant := 16#EC#;
+
+   -- Bus Master IDE registers, offsets from the channel base
+   BMICOM : constant := 0; -- command
+   BMISTA : constant := 2; -- status
+   BMIDTP : constant := 4; -- descriptor table pointer
+
+   BMICOM_SSBM  : constant := 16#01#; -- start/stop bus master
+   BMICOM_RWCON : constant := 16#08#; -- bus master writes to memory (disk read)
+
+   BMISTA_BMIDEA    : constant := 16#01#; -- bus master active
+   BMISTA_ERROR     : constant := 16#02#; -- write 1 to clear
+   BMISTA_INTERRUPT : constant := 16#04#; -- write 1 to clear
+
+   DMA_TIMEOUT : constant := 10_000_000; -- status polls
+
+   LBA28_LIMIT : constant := 2**28;
+
+   -- sectors per command
+   MAX_SECTORS     : constant := 2**8;
+   MAX_SECTORS_EXT : constant := 2**16;
+
+   SECTOR_WORDS : constant := SECTOR_SIZE / 2;
+
+   type Word_Array is array (Natural range <>) of Unsigned_16
+      with Pack => True;
 
    ----------------------------------------------------------------------------
    -- Local subprograms
@@ -202,6 +241,54 @@ pragma Warnings (Off, "* is not referenced");
       (D : Descriptor_Type)
       return Boolean;
 
+   function Is_Ext
+      (LBA   : Unsigned_64;
+       Count : Positive)
+      return Boolean
+      with Inline => True;
+
+   procedure Command_Issue
+      (D       : in Descriptor_Type;
+       LBA     : in Unsigned_64;
+       Count   : in Positive;
+       Opcode  : in Unsigned_8);
+
+   function BM_Read_8
+      (D      : Descriptor_Type;
+       Offset : Storage_Offset)
+      return Unsigned_8
+      with Inline => True;
+
+   procedure BM_Write_8
+      (D      : in Descriptor_Type;
+       Offset : in Storage_Offset;
+       Value  : in Unsigned_8)
+      with Inline => True;
+
+   procedure Transfer
+      (D              : in     Descriptor_Type;
+       LBA            : in     Unsigned_64;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean);
+
+   procedure Transfer_DMA
+      (D              : in     Descriptor_Type;
+       LBA            : in     Unsigned_64;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean);
+
+   procedure Transfer_Multiple
+      (D              : in     Descriptor_Type;
+       S              : in     Sector_Type;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean);
+
    --========================================================================--
    --                                                                        --
    --                                                                        --
@@ -285,6 +372,9 @@ pragma Warnings (Off, "* is not referenced");
    ----------------------------------------------------------------------------
    -- Is_DRQ_Active
    ----------------------------------------------------------------------------
+   -- Wait for the drive to request the next DRQ block; False on timeout or
+   -- if the command ends with an error.
+   ----------------------------------------------------------------------------
    function Is_DRQ_Active
       (D : Descriptor_Type)
       return Boolean
@@ -292,10 +382,19 @@ pragma Warnings (Off, "* is not referenced");
       Success : Boolean := False;
    begin
       for Loop_Count in 1 .. 100_000 loop
-         if To_STATUS (Register_Read_8 (D, STATUS)).DRQ then
-            Success := True;
-            exit;
-         end if;
+         declare
+            Drive_Status : STATUS_Type;
+         begin
+            Drive_Status := To_STATUS (Register_Read_8 (D, STATUS));
+            -- if BSY is set, no other bits are valid
+            if not Drive_Status.BSY then
+               exit when Drive_Status.ERR;
+               if Drive_Status.DRQ then
+                  Success := True;
+                  exit;
+               end if;
+            end if;
+         end;
       end loop;
       return Success;
    end Is_DRQ_Active;
@@ -328,18 +427,103 @@ pragma Warnings (Off, "* is not referenced");
    end DRIVE_Set;
 
    ----------------------------------------------------------------------------
-   -- Read
+   -- Is_Ext
    ----------------------------------------------------------------------------
-   procedure Read
-      (D       : in     Descriptor_Type;
-       S       : in     Sector_Type;
-       B       :    out Block_Type;
-       Success :    out Boolean)
+   -- True if the command needs the 48-bit (EXT) form.
+   ----------------------------------------------------------------------------
+   function Is_Ext
+      (LBA   : Unsigned_64;
+       Count : Positive)
+      return Boolean
+      is
+   begin
+      return LBA + Unsigned_64 (Count) > LBA28_LIMIT or else Count > MAX_SECTORS;
+   end Is_Ext;
+
+   ----------------------------------------------------------------------------
+   -- Command_Issue
+   ----------------------------------------------------------------------------
+   -- Load the task file with LBA and Count, in 28- or 48-bit form as per
+   -- Is_Ext, and issue Opcode; the drive must be ready.
+   ----------------------------------------------------------------------------
+   procedure Command_Issue
+      (D       : in Descriptor_Type;
+       LBA     : in Unsigned_64;
+       Count   : in Positive;
+       Opcode  : in Unsigned_8)
       is
-      type HD_Buffer_Type is array (0 .. 255) of Unsigned_16
-         with Pack => True;
-      Buffer : HD_Buffer_Type
-         with Address => B (0)'Address;
+      function LBA_Byte (Shift : Natural) return Unsigned_8 is
+         (Unsigned_8 (Shift_Right (LBA, Shift) and 16#FF#));
+   begin
+      if Is_Ext (LBA, Count) then
+         -- high-order bytes first, then low-order bytes
+         Register_Write_8 (D, SC, Unsigned_8 ((Count / 2**8) mod 2**8));
+         Register_Write_8 (D, SN, LBA_Byte (24));
+         Register_Write_8 (D, CL, LBA_Byte (32));
+         Register_Write_8 (D, CM, LBA_Byte (40));
+         Register_Write_8 (D, SC, Unsigned_8 (Count mod 2**8));
+         Register_Write_8 (D, SN, LBA_Byte (0));
+         Register_Write_8 (D, CL, LBA_Byte (8));
+         Register_Write_8 (D, CM, LBA_Byte (16));
+         Register_Write_8 (D, HEAD, HEAD_Set (0));
+      else
+         Register_Write_8 (D, SC, Unsigned_8 (Count mod 2**8));
+         Register_Write_8 (D, SN, LBA_Byte (0));
+         Register_Write_8 (D, CL, LBA_Byte (8));
+         Register_Write_8 (D, CM, LBA_Byte (16));
+         Register_Write_8 (D, HEAD, HEAD_Set (LBA_Byte (24)));
+      end if;
+      Register_Write_8 (D, FEATURE, 0);
+      Register_Write_8 (D, COMMAND, Opcode);
+   end Command_Issue;
+
+   ----------------------------------------------------------------------------
+   -- BM_Read_8/BM_Write_8
+   ----------------------------------------------------------------------------
+   -- Bus Master IDE register access.
+   ----------------------------------------------------------------------------
+   function BM_Read_8
+      (D      : Descriptor_Type;
+       Offset : Storage_Offset)
+      return Unsigned_8
+      is
+   begin
+      return D.Read_8 (D.DMA.all.BM_Address + Offset);
+   end BM_Read_8;
+
+   procedure BM_Write_8
+      (D      : in Descriptor_Type;
+       Offset : in Storage_Offset;
+       Value  : in Unsigned_8)
+      is
+   begin
+      D.Write_8 (D.DMA.all.BM_Address + Offset, Value);
+   end BM_Write_8;
+
+   ----------------------------------------------------------------------------
+   -- Transfer
+   ----------------------------------------------------------------------------
+   -- Issue a single PIO READ/WRITE command for Count sectors starting at
+   -- LBA, and move the data one DRQ block at a time.
+   ----------------------------------------------------------------------------
+   procedure Transfer
+      (D              : in     Descriptor_Type;
+       LBA            : in     Unsigned_64;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean)
+      is
+      Buffer   : Word_Array (0 .. Count * SECTOR_WORDS - 1)
+         with Address    => Buffer_Address,
+              Import     => True,
+              Convention => Ada;
+      Ext      : constant Boolean := Is_Ext (LBA, Count);
+      Multiple : constant Boolean := D.Multiple_Count > 1;
+      Block    : constant Positive := (if Multiple then D.Multiple_Count else 1);
+      Opcode   : Unsigned_8;
+      Index    : Natural;
+      Sectors  : Natural;
    begin
       ----------------------------------------------------
       DRIVE_Set (D, MASTER);
@@ -348,21 +532,196 @@ pragma Warnings (Off, "* is not referenced");
          Success := False;
          return;
       end if;
-      -- perform read ------------------------------------
-      Register_Write_8 (D, SN, Unsigned_8 (S mod 2**8));
-      Register_Write_8 (D, CL, Unsigned_8 ((S / 2**8) mod 2**8));
-      Register_Write_8 (D, CM, Unsigned_8 ((S / 2**16) mod 2**8));
-      Register_Write_8 (D, HEAD, HEAD_Set (0));
-      Register_Write_8 (D, FEATURE, 0);
-      Register_Write_8 (D, SC, 1);
-      Register_Write_8 (D, COMMAND, CMD_PIO_READ);
+      -- issue command -----------------------------------
+      if Write then
+         Opcode := (if Ext then (if Multiple then CMD_WRITE_MULTIPLE_EXT else CMD_PIO_WRITE_EXT)
+                    else (if Multiple then CMD_WRITE_MULTIPLE else CMD_PIO_WRITE));
+      else
+         Opcode := (if Ext then (if Multiple then CMD_READ_MULTIPLE_EXT else CMD_PIO_READ_EXT)
+                    else (if Multiple then CMD_READ_MULTIPLE else CMD_PIO_READ));
+      end if;
+      Command_Issue (D, LBA, Count, Opcode);
+      -- move data, one DRQ block at a time --------------
+      Index := 0;
+      while Index < Buffer'Length loop
+         if not Is_DRQ_Active (D) then
+            Success := False;
+            return;
+         end if;
+         Sectors := Natural'Min (Block, (Buffer'Length - Index) / SECTOR_WORDS);
+         if Write then
+            for Word in Index .. Index + Sectors * SECTOR_WORDS - 1 loop
+               Register_Write_16 (D, DATA, Buffer (Word));
+            end loop;
+         else
+            for Word in Index .. Index + Sectors * SECTOR_WORDS - 1 loop
+               Buffer (Word) := Register_Read_16 (D, DATA);
+            end loop;
+         end if;
+         Index := @ + Sectors * SECTOR_WORDS;
+      end loop;
+      ----------------------------------------------------
+      if Write then
+         -- wait for the last block to reach the medium
+         Success := Is_Drive_Ready (D) and then not To_STATUS (Register_Read_8 (D, STATUS)).ERR;
+      else
+         Success := True;
+      end if;
+   end Transfer;
+
+   ----------------------------------------------------------------------------
+   -- Transfer_DMA
+   ----------------------------------------------------------------------------
+   -- Describe the buffer in the PRD table, splitting it at 64 KiB
+   -- boundaries, issue a single READ/WRITE DMA command for Count sectors and
+   -- wait for the channel interrupt.
+   ----------------------------------------------------------------------------
+   procedure Transfer_DMA
+      (D              : in     Descriptor_Type;
+       LBA            : in     Unsigned_64;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean)
+      is
+      DMA          : DMA_Descriptor_Type renames D.DMA.all;
+      Ext          : constant Boolean := Is_Ext (LBA, Count);
+      Direction    : constant Unsigned_8 := (if Write then 0 else BMICOM_RWCON);
+      Base         : Unsigned_32;
+      Remaining    : Unsigned_32;
+      Chunk        : Unsigned_32;
+      Index        : Natural;
+      BM_Status    : Unsigned_8;
+      Drive_Status : STATUS_Type;
+   begin
+      -- build the PRD table -----------------------------
+      Base := Unsigned_32 (To_Integer (Buffer_Address));
+      Remaining := Unsigned_32 (Count) * SECTOR_SIZE;
+      Index := DMA.PRD_Table'First;
+      loop
+         if Index > DMA.PRD_Table'Last then
+            Success := False;
+            return;
+         end if;
+         Chunk := Unsigned_32'Min (Remaining, 16#0001_0000# - (Base and 16#0000_FFFF#));
+         DMA.PRD_Table (Index) := (
+            Base_Address => Base,
+            Byte_Count   => Unsigned_16 (Chunk and 16#0000_FFFF#),
+            EOT          => Chunk = Remaining,
+            others       => <>
+            );
+         exit when Chunk = Remaining;
+         Base := @ + Chunk;
+         Remaining := @ - Chunk;
+         Index := @ + 1;
+      end loop;
       ----------------------------------------------------
-      for Index in Buffer'Range loop
-         exit when not Is_DRQ_Active (D);
-         Buffer (Index) := Register_Read_16 (D, DATA);
+      DRIVE_Set (D, MASTER);
+      if not Is_Drive_Ready (D) then
+         Console.Print ("Drive not ready.", NL => True);
+         Success := False;
+         return;
+      end if;
+      -- program the bus master --------------------------
+      BM_Write_8 (D, BMICOM, Direction);
+      DMA.Write_32 (DMA.BM_Address + BMIDTP, Unsigned_32 (To_Integer (DMA.PRD_Table'Address)));
+      BM_Write_8 (D, BMISTA, BM_Read_8 (D, BMISTA) or BMISTA_ERROR or BMISTA_INTERRUPT);
+      DMA.Done := False;
+      -- issue command and start the bus master ----------
+      if Write then
+         Command_Issue (D, LBA, Count, (if Ext then CMD_WRITE_DMA_EXT else CMD_WRITE_DMA));
+      else
+         Command_Issue (D, LBA, Count, (if Ext then CMD_READ_DMA_EXT else CMD_READ_DMA));
+      end if;
+      BM_Write_8 (D, BMICOM, Direction or BMICOM_SSBM);
+      -- wait for completion -----------------------------
+      BM_Status := 0;
+      for Loop_Count in 1 .. DMA_TIMEOUT loop
+         if DMA.Done then
+            BM_Status := DMA.Status;
+            exit;
+         end if;
+         -- interrupt not delivered (e.g. masked), look at the channel
+         BM_Status := BM_Read_8 (D, BMISTA);
+         exit when (BM_Status and BMISTA_INTERRUPT) /= 0;
       end loop;
+      BM_Write_8 (D, BMICOM, Direction);
+      BM_Write_8 (D, BMISTA, BM_Read_8 (D, BMISTA) or BMISTA_ERROR or BMISTA_INTERRUPT);
+      Drive_Status := To_STATUS (Register_Read_8 (D, STATUS));
       ----------------------------------------------------
+      Success := (BM_Status and BMISTA_INTERRUPT) /= 0 and then
+                 (BM_Status and BMISTA_ERROR) = 0     and then
+                 not Drive_Status.BSY                 and then
+                 not Drive_Status.ERR;
+   end Transfer_DMA;
+
+   ----------------------------------------------------------------------------
+   -- Transfer_Multiple
+   ----------------------------------------------------------------------------
+   -- Split a transfer into commands of at most MAX_SECTORS sectors, or
+   -- MAX_SECTORS_EXT sectors when the drive supports LBA48 and the transfer
+   -- is done with PIO; a DMA command must fit in the PRD table.
+   ----------------------------------------------------------------------------
+   procedure Transfer_Multiple
+      (D              : in     Descriptor_Type;
+       S              : in     Sector_Type;
+       Count          : in     Positive;
+       Buffer_Address : in     Address;
+       Write          : in     Boolean;
+       Success        :    out Boolean)
+      is
+      -- the bus master needs a word-aligned buffer
+      Use_DMA : constant Boolean := D.DMA /= null and then
+                                    D.DMA_Supported and then
+                                    (To_Integer (Buffer_Address) and 1) = 0;
+      Limit   : constant Positive := (if D.LBA48 and then not Use_DMA then MAX_SECTORS_EXT else MAX_SECTORS);
+      LBA     : Unsigned_64;
+      Done    : Natural;
+      Chunk   : Positive;
+   begin
+      if not D.LBA48 and then Unsigned_64 (S) + Unsigned_64 (Count) > LBA28_LIMIT then
+         Success := False;
+         return;
+      end if;
+      LBA := Unsigned_64 (S);
+      Done := 0;
       Success := True;
+      while Success and then Done < Count loop
+         Chunk := Positive'Min (Limit, Count - Done);
+         if Use_DMA then
+            Transfer_DMA (
+               D,
+               LBA + Unsigned_64 (Done),
+               Chunk,
+               Buffer_Address + Storage_Offset (Done * SECTOR_SIZE),
+               Write,
+               Success
+               );
+         else
+            Transfer (
+               D,
+               LBA + Unsigned_64 (Done),
+               Chunk,
+               Buffer_Address + Storage_Offset (Done * SECTOR_SIZE),
+               Write,
+               Success
+               );
+         end if;
+         Done := @ + Chunk;
+      end loop;
+   end Transfer_Multiple;
+
+   ----------------------------------------------------------------------------
+   -- Read
+   ----------------------------------------------------------------------------
+   procedure Read
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       B       :    out Block_Type;
+       Success :    out Boolean)
+      is
+   begin
+      Read_Multiple (D, S, 1, B, Success);
    end Read;
 
    ----------------------------------------------------------------------------
@@ -374,34 +733,108 @@ pragma Warnings (Off, "* is not referenced");
        B       : in     Block_Type;
        Success :    out Boolean)
       is
-      type HD_Buffer_Type is array (0 .. 255) of Unsigned_16
-         with Pack => True;
-      Buffer : HD_Buffer_Type
-         with Address => B (0)'Address;
    begin
-      ----------------------------------------------------
+      Write_Multiple (D, S, 1, B, Success);
+   end Write;
+
+   ----------------------------------------------------------------------------
+   -- Read_Multiple
+   ----------------------------------------------------------------------------
+   procedure Read_Multiple
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       Count   : in     Positive;
+       B       :    out Block_Type;
+       Success :    out Boolean)
+      is
+   begin
+      if B'Length < Count * SECTOR_SIZE then
+         Success := False;
+         return;
+      end if;
+      Transfer_Multiple (D, S, Count, B (B'First)'Address, False, Success);
+   end Read_Multiple;
+
+   ----------------------------------------------------------------------------
+   -- Write_Multiple
+   ----------------------------------------------------------------------------
+   procedure Write_Multiple
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       Count   : in     Positive;
+       B       : in     Block_Type;
+       Success :    out Boolean)
+      is
+   begin
+      if B'Length < Count * SECTOR_SIZE then
+         Success := False;
+         return;
+      end if;
+      Transfer_Multiple (D, S, Count, B (B'First)'Address, True, Success);
+   end Write_Multiple;
+
+   ----------------------------------------------------------------------------
+   -- Read_Blocks
+   ----------------------------------------------------------------------------
+   procedure Read_Blocks
+      (Data_Address : in     Address;
+       S            : in     Sector_Type;
+       B            :    out Block_Type;
+       Success      :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      if B'Length = 0 or else B'Length mod SECTOR_SIZE /= 0 then
+         Success := False;
+         return;
+      end if;
+      Read_Multiple (D, S, B'Length / SECTOR_SIZE, B, Success);
+   end Read_Blocks;
+
+   ----------------------------------------------------------------------------
+   -- Write_Blocks
+   ----------------------------------------------------------------------------
+   procedure Write_Blocks
+      (Data_Address : in     Address;
+       S            : in     Sector_Type;
+       B            : in     Block_Type;
+       Success      :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      if B'Length = 0 or else B'Length mod SECTOR_SIZE /= 0 then
+         Success := False;
+         return;
+      end if;
+      Write_Multiple (D, S, B'Length / SECTOR_SIZE, B, Success);
+   end Write_Blocks;
+
+   ----------------------------------------------------------------------------
+   -- Flush
+   ----------------------------------------------------------------------------
+   procedure Flush
+      (Data_Address : in     Address;
+       Success      :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
       DRIVE_Set (D, MASTER);
       if not Is_Drive_Ready (D) then
-         Console.Print ("Drive not ready.", NL => True);
          Success := False;
          return;
       end if;
-      -- perform write -----------------------------------
-      Register_Write_8 (D, SN, Unsigned_8 (S mod 2**8));
-      Register_Write_8 (D, CL, Unsigned_8 ((S / 2**8) mod 2**8));
-      Register_Write_8 (D, CM, Unsigned_8 ((S / 2**16) mod 2**8));
-      Register_Write_8 (D, HEAD, HEAD_Set (0));
-      Register_Write_8 (D, FEATURE, 0);
-      Register_Write_8 (D, SC, 1);
-      Register_Write_8 (D, COMMAND, CMD_PIO_WRITE);
-      ----------------------------------------------------
-      for Index in Buffer'Range loop
-         exit when not Is_DRQ_Active (D);
-         Register_Write_16 (D, DATA, Buffer (Index));
-      end loop;
-      ----------------------------------------------------
-      Success := True;
-   end Write;
+      Register_Write_8 (D, COMMAND, (if D.LBA48 then CMD_FLUSH_CACHE_EXT else CMD_FLUSH_CACHE));
+      Success := Is_Drive_Ready (D) and then not To_STATUS (Register_Read_8 (D, STATUS)).ERR;
+   end Flush;
 
    ----------------------------------------------------------------------------
    -- Init
@@ -409,10 +842,80 @@ pragma Warnings (Off, "* is not referenced");
    procedure Init
       (D : in out Descriptor_Type)
       is
+      Identify : Word_Array (0 .. SECTOR_WORDS - 1);
+      Maximum  : Natural;
+      Count    : Positive;
    begin
-      null;
+      D.Multiple_Count := 1;
+      D.LBA48 := False;
+      D.DMA_Supported := False;
+      ----------------------------------------------------
+      DRIVE_Set (D, MASTER);
+      if not Is_Drive_Ready (D) then
+         return;
+      end if;
+      Register_Write_8 (D, HEAD, HEAD_Set (0));
+      Register_Write_8 (D, COMMAND, CMD_IDENTIFY);
+      if not Is_DRQ_Active (D) then
+         return;
+      end if;
+      -- the data port delivers bytes in disk order, IDENTIFY words are
+      -- little-endian
+      for Index in Identify'Range loop
+         Identify (Index) := LE_To_CPUE (Register_Read_16 (D, DATA));
+      end loop;
+      -- word 83 bit 10: 48-bit Address feature set supported
+      D.LBA48 := (Identify (83) and 16#0400#) /= 0;
+      -- word 49 bit 8: DMA supported
+      D.DMA_Supported := (Identify (49) and 16#0100#) /= 0;
+      -- word 47 bits 7..0: maximum sectors per DRQ block
+      Maximum := Natural'Min (Natural (Identify (47) and 16#00FF#), IDE_MULTIPLE_MAX);
+      if Maximum < 2 then
+         return;
+      end if;
+      Count := 1;
+      while Count * 2 <= Maximum loop
+         Count := @ * 2;
+      end loop;
+      if not Is_Drive_Ready (D) then
+         return;
+      end if;
+      Register_Write_8 (D, SC, Unsigned_8 (Count));
+      Register_Write_8 (D, HEAD, HEAD_Set (0));
+      Register_Write_8 (D, COMMAND, CMD_SET_MULTIPLE);
+      if Is_Drive_Ready (D) and then not To_STATUS (Register_Read_8 (D, STATUS)).ERR then
+         D.Multiple_Count := Count;
+      end if;
    end Init;
 
+   ----------------------------------------------------------------------------
+   -- Interrupt_Handler
+   ----------------------------------------------------------------------------
+   procedure Interrupt_Handler
+      (Descriptor_Address : in Address)
+      is
+      D         : Descriptor_Type
+         with Address    => Descriptor_Address,
+              Import     => True,
+              Convention => Ada;
+      BM_Status : Unsigned_8;
+      Unused    : Unsigned_8;
+   begin
+      if D.DMA /= null then
+         BM_Status := BM_Read_8 (D, BMISTA);
+         if (BM_Status and BMISTA_INTERRUPT) /= 0 then
+            -- stop the bus master and clear the interrupt and error bits
+            BM_Write_8 (D, BMICOM, BM_Read_8 (D, BMICOM) and not BMICOM_SSBM);
+            BM_Write_8 (D, BMISTA, BM_Status);
+            D.DMA.all.Status := BM_Status;
+            D.DMA.all.Interrupts := @ + 1;
+            D.DMA.all.Done := True;
+         end if;
+      end if;
+      -- reading STATUS acknowledges the drive interrupt
+      Unused := Register_Read_8 (D, STATUS);
+   end Interrupt_Handler;
+
 pragma Warnings (On, "* is not referenced");
 
 end IDE;
@@ -0,0 +1,159 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ loopback.adb                                                                                              --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with Timers;
+
+package body Loopback
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   Loopback_Clock : aliased Timers.Periodic_Type;
+
+   Seed : Unsigned_32 := 16#2545_F491#;
+
+   function Random
+      return Unsigned_32;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Random
+   ----------------------------------------------------------------------------
+   -- Numerical Recipes LCG, good enough to pick the frames to lose.
+   ----------------------------------------------------------------------------
+   function Random
+      return Unsigned_32
+      is
+   begin
+      Seed := @ * 1_664_525 + 1_013_904_223;
+      return Seed;
+   end Random;
+
+   ----------------------------------------------------------------------------
+   -- Timer_Start
+   ----------------------------------------------------------------------------
+   procedure Timer_Start
+      (Period : in Unsigned_32)
+      is
+   begin
+      Timers.Periodic_Start (Loopback_Clock'Access, Period);
+   end Timer_Start;
+
+   ----------------------------------------------------------------------------
+   -- Poll
+   ----------------------------------------------------------------------------
+   -- Deliver at most Budget frames whose latency has elapsed; Done = False
+   -- while frames are still queued, so that Ethernet.Poll keeps the
+   -- interface scheduled until they are due.
+   ----------------------------------------------------------------------------
+   procedure Poll
+      (Descriptor_Address : in     Address;
+       Budget             : in     Positive;
+       Done               :    out Boolean)
+      is
+      D       : Descriptor_Type
+         with Address    => Descriptor_Address,
+              Import     => True,
+              Convention => Ada;
+      Frame   : Frame_Type;
+      Success : Boolean;
+   begin
+      for Count in 1 .. Budget loop
+         exit when D.Head = D.Tail;
+         Frame := D.Frames (Natural (D.Tail mod LOOPBACK_QUEUE_SIZE));
+         exit when not Timers.Expired (Frame.Due, Loopback_Clock.Count);
+         D.Frames (Natural (D.Tail mod LOOPBACK_QUEUE_SIZE)).P := null;
+         D.Tail := @ + 1;
+         Ethernet.Input (D.Interface_Id, Frame.P, Success);
+         if Success then
+            D.RX_Frames := @ + 1;
+         else
+            D.RX_Dropped := @ + 1;
+            Free (Frame.P);
+         end if;
+      end loop;
+      Done := D.Head = D.Tail;
+   end Poll;
+
+   ----------------------------------------------------------------------------
+   -- Transmit
+   ----------------------------------------------------------------------------
+   -- The caller keeps its own reference to P, and must not modify the frame
+   -- once transmitted.
+   ----------------------------------------------------------------------------
+   procedure Transmit
+      (Descriptor_Address : in Address;
+       P                  : in Pbuf_Ptr)
+      is
+      D : Descriptor_Type
+         with Address    => Descriptor_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      D.TX_Frames := @ + 1;
+      if D.Loss_Rate > 0 and then Natural (Random mod 1_000) < D.Loss_Rate then
+         D.TX_Lost := @ + 1;
+         return;
+      end if;
+      if D.Head - D.Tail = LOOPBACK_QUEUE_SIZE then
+         D.TX_Overruns := @ + 1;
+         return;
+      end if;
+      Reference (P);
+      D.Frames (Natural (D.Head mod LOOPBACK_QUEUE_SIZE)) := (
+         P   => P,
+         Due => Loopback_Clock.Count + D.Latency
+         );
+      D.Head := @ + 1;
+      Ethernet.Poll_Schedule (D.Interface_Id);
+   end Transmit;
+
+   ----------------------------------------------------------------------------
+   -- Init
+   ----------------------------------------------------------------------------
+   procedure Init
+      (D : in out Descriptor_Type)
+      is
+   begin
+      while D.Head /= D.Tail loop
+         Free (D.Frames (Natural (D.Tail mod LOOPBACK_QUEUE_SIZE)).P);
+         D.Frames (Natural (D.Tail mod LOOPBACK_QUEUE_SIZE)).P := null;
+         D.Tail := @ + 1;
+      end loop;
+      D.Head        := 0;
+      D.Tail        := 0;
+      D.TX_Frames   := 0;
+      D.TX_Lost     := 0;
+      D.TX_Overruns := 0;
+      D.RX_Frames   := 0;
+      D.RX_Dropped  := 0;
+   end Init;
+
+end Loopback;
@@ -21,6 +21,7 @@ with Bits;
 with MMIO;
 with CPU;
 with Console;
+with Trace;
 
 package body NE2000
    is
@@ -36,6 +37,12 @@ package body NE2000
    use System.Storage_Elements;
    use Bits;
 
+   -- receive remote DMA transfers whole words into every pbuf of a chain
+   pragma Compile_Time_Error (PBUF_PAYLOAD_SIZE mod 4 /= 0, "PBUF_PAYLOAD_SIZE must be a multiple of 4");
+
+   -- CR polls waiting for the previous frame to leave before giving up
+   TX_TIMEOUT : constant := 100_000;
+
 pragma Warnings (Off, "* is not referenced");
 
    ----------------------------------------------------------------------------
@@ -413,6 +420,9 @@ pragma Warnings (Off, "* is not referenced");
    function To_U8 is new Ada.Unchecked_Conversion (IMR_Type, Unsigned_8);
    function To_IMR is new Ada.Unchecked_Conversion (Unsigned_8, IMR_Type);
 
+   IMR_RXTX : constant IMR_Type := (PRXE => True, PTXE => True, others => False);
+   IMR_TX   : constant IMR_Type := (PTXE => True, others => False);              -- RX deferred to Poll
+
    ----------------------------------------------------------------------------
    -- 9346CR: 9346 Command Register (01H; Type=R/W except Bit0=R)
    ----------------------------------------------------------------------------
@@ -534,6 +544,17 @@ pragma Warnings (Off, "* is not referenced");
    function To_U8 is new Ada.Unchecked_Conversion (CONFIG3_Type, Unsigned_8);
    function To_CONFIG3 is new Ada.Unchecked_Conversion (Unsigned_8, CONFIG3_Type);
 
+   ----------------------------------------------------------------------------
+   -- Buffer memory (pages 16#40# .. 16#7F#)
+   ----------------------------------------------------------------------------
+   -- The transmit buffer holds a maximum-size frame and lies outside the
+   -- receive ring, so that transmission never overwrites received frames.
+   ----------------------------------------------------------------------------
+
+   TX_PAGE       : constant := 16#40#; -- 6 pages, 1536 bytes
+   RX_PAGE_START : constant := 16#46#;
+   RX_PAGE_STOP  : constant := 16#80#;
+
    ----------------------------------------------------------------------------
    -- Ring descriptor
    ----------------------------------------------------------------------------
@@ -576,6 +597,10 @@ pragma Warnings (Off, "* is not referenced");
       (D : in out Descriptor_Type);
    procedure Update
       (D : in out Descriptor_Type);
+   procedure Receive_Frames
+      (D       : in out Descriptor_Type;
+       Budget  : in     Positive;
+       Drained :    out Boolean);
 
    --========================================================================--
    --                                                                        --
@@ -711,15 +736,11 @@ pragma Warnings (Off, "* is not referenced");
          OFST   => False,
          Unused => 0
          )));
-      Out8 (PA (BAR, BNRY), 16#40#);             -- BNRY: set boundary
-      Out8 (PA (BAR, PSTARTW), 16#40#);          -- PSTART: set page start
-      Out8 (PA (BAR, PSTOPW), 16#7F#);           -- PSTOP: set page stop
+      Out8 (PA (BAR, BNRY), RX_PAGE_START);      -- BNRY: set boundary
+      Out8 (PA (BAR, PSTARTW), RX_PAGE_START);   -- PSTART: set page start
+      Out8 (PA (BAR, PSTOPW), RX_PAGE_STOP);     -- PSTOP: set page stop
       Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRALL)); -- clear all interrupt flags
-      Out8 (PA (BAR, IMRW), To_U8 (IMR_Type'(
-         PRXE   => True,
-         PTXE   => True,
-         others => False
-         )));
+      Out8 (PA (BAR, IMRW), To_U8 (IMR_RXTX));
       -- Page 1 registers setup -----------------------------------------------
       Out8 (PA (BAR, CR), To_U8 (CR_Type'(
          STP => True,
@@ -739,8 +760,8 @@ pragma Warnings (Off, "* is not referenced");
       for MAR in Register_Type range MAR0 .. MAR7 loop
          Out8 (PA (BAR, MAR), 16#FF#);
       end loop;
-      Out8 (PA (BAR, CURR), 16#40#); -- CURR: set current page
-      D.Next_Ptr := 16#40#;
+      Out8 (PA (BAR, CURR), RX_PAGE_START); -- CURR: set current page
+      D.Next_Ptr := RX_PAGE_START;
       -- Page 0 registers setup: START and disable loopback
       Out8 (PA (BAR, CR), To_U8 (CR_Type'(
          STP => False,
@@ -786,12 +807,12 @@ pragma Warnings (Off, "* is not referenced");
       -- Page 0 NODMA
       Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
       Status := To_ISR (In8 (PA (BAR, ISRR)));
+      Trace.Event (Trace.LEVEL_DEBUG, Trace.NIC_IRQ, Unsigned_32 (To_U8 (Status)));
       if Status.PRX then
-         -- Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPRX));
-         Receive (D);
-         -- Console.Print ("RX", NL => True);
-         Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
-         -- Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPRX));
+         -- mask RX and acknowledge, the ring is drained by Poll
+         Out8 (PA (BAR, IMRW), To_U8 (IMR_TX));
+         Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPRX));
+         Ethernet.Poll_Schedule (D.Interface_Id);
       end if;
       if Status.PTX then
          Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPTX));
@@ -810,26 +831,34 @@ pragma Warnings (Off, "* is not referenced");
       BAR := D.BAR;
       -- Page 1 NODMA
       Out8 (PA (BAR, CR), To_U8 (CR_PAGE1));
-      Out8 (PA (BAR, CURR), 16#40#);         -- CURR: set current page
+      Out8 (PA (BAR, CURR), RX_PAGE_START);  -- CURR: set current page
       -- Page 0 NODMA
       Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
       Out8 (PA (BAR, RBCR0), 16#00#);        -- RBCR0: clear remote byte count LO
       Out8 (PA (BAR, RBCR1), 16#00#);        -- RBCR1: clear remote byte count HI
-      Out8 (PA (BAR, BNRY), 16#40#);         -- BNRY: set boundary
+      Out8 (PA (BAR, BNRY), RX_PAGE_START);  -- BNRY: set boundary
       -- update Next pointer
-      D.Next_Ptr := 16#40#;
+      D.Next_Ptr := RX_PAGE_START;
    end Update;
 
    ----------------------------------------------------------------------------
-   -- Receive
+   -- Receive_Frames
    ----------------------------------------------------------------------------
-   procedure Receive
-      (D : in out Descriptor_Type)
+   -- Transfer at most Budget frames from the NIC ring; Drained = False when
+   -- the budget was exhausted with frames still pending in the ring.
+   ----------------------------------------------------------------------------
+   procedure Receive_Frames
+      (D       : in out Descriptor_Type;
+       Budget  : in     Positive;
+       Drained :    out Boolean)
       is
+      Count             : Natural;
       BAR               : Unsigned_16;
       NIC_Packet_Header : Ring_Descriptor_Type;
       P                 : Pbuf_Ptr;
+      Q                 : Pbuf_Ptr;
       Index             : Storage_Offset;
+      Wide_Transfers    : Boolean;
       function In8 (Port : Unsigned_16) return Unsigned_8 renames D.Read_8.all;
       function In16 (Port : Unsigned_16) return Unsigned_16 renames D.Read_16.all;
       function In32 (Port : Unsigned_16) return Unsigned_32 renames D.Read_32.all;
@@ -852,6 +881,9 @@ pragma Warnings (Off, "* is not referenced");
       end Setup_DMA_Port;
    begin
       BAR := D.BAR;
+      Wide_Transfers := D.NE2000PCI and then D.Read_32 /= null;
+      Drained := True;
+      Count := 0;
       loop
          -- Page 0 NODMA
          Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
@@ -859,6 +891,15 @@ pragma Warnings (Off, "* is not referenced");
          -- Page 1 NODMA
          Out8 (PA (BAR, CR), To_U8 (CR_PAGE1));
          exit when In8 (PA (BAR, CURR)) /= D.Next_Ptr;
+         if Count = Budget then
+            -- budget exhausted: keep the ring, move the boundary just
+            -- behind the next frame so that the NIC does not overwrite it
+            Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
+            Out8 (PA (BAR, BNRY), (if D.Next_Ptr = RX_PAGE_START then RX_PAGE_STOP - 1 else D.Next_Ptr - 1));
+            Drained := False;
+            return;
+         end if;
+         Count := @ + 1;
          Setup_DMA_Port (Unsigned_16 (D.Next_Ptr) * 2**8, RING_DESCRIPTOR_SIZE);
          -- Page 0 RD
          Out8 (PA (BAR, CR), To_U8 (CR_RD));
@@ -881,6 +922,7 @@ pragma Warnings (Off, "* is not referenced");
             To_RSR (NIC_Packet_Header.Receive_Status).MPA
          then
             -- RX error
+            Trace.Event (Trace.LEVEL_ERROR, Trace.NIC_RX_ERROR, Unsigned_32 (NIC_Packet_Header.Receive_Status));
             Update (D);
             return;
          end if;
@@ -895,57 +937,100 @@ pragma Warnings (Off, "* is not referenced");
          Out8 (PA (BAR, CR), To_U8 (CR_RD));
          -- Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPRX));
          -- Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRRDC));
-         -- allocate a Pbuf
+         -- allocate a Pbuf chain
          P := Allocate (Natural (NIC_Packet_Header.Receive_Byte_Count));
          Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRPRX));
          if P = null then
-            -- __FIX__ --------------------------------------------------
-            -- dump packet information
-            Console.Print ("*** Error: no pbufs available", NL => True);
-            Console.Print (Prefix => "RSR:           ", Value => NIC_Packet_Header.Receive_Status, NL => True);
-            Console.Print (Prefix => "packet length: ", Value => Integer (NIC_Packet_Header.Receive_Byte_Count), NL => True);
-            loop null; end loop;
-            -- update packet pointer according to NIC-created packet header informations
-            -- Descriptor.Next_Ptr := NIC_Packet_Header.Next_Packet_Pointer;
-            -- reselect PAGE1, otherwise the while loop test condition fails
-            -- Out8 (BAR + 16#00#, To_U8 (CR_Type'(STP => True, STA => False, TXP => False, RD => ABRT_CMPLT, PS => PAGE1)));
-            -- __FIX__ --------------------------------------------------
+            -- no pbufs available, drop the frame and skip to the next one;
+            -- abort the remote read programmed for it and acknowledge the
+            -- completion, so that the next header read starts clean
+            Out8 (PA (BAR, CR), To_U8 (CR_NODMA));
+            Out8 (PA (BAR, ISRW), To_U8 (ISR_CLRRDC));
+            D.RX_Dropped := @ + 1;
+            Trace.Event (Trace.LEVEL_INFO, Trace.NIC_RX_DROP, Unsigned_32 (NIC_Packet_Header.Receive_Byte_Count));
          else
-            -- read packet data
-            Index := 0;
-            if D.NE2000PCI then
-               loop
-                  -- exit when To_ISR (In8 (BAR + 16#07#)).RDC;
-                  MMIO.Write (Payload_Address (P) + Index, In32 (PA (BAR, RDMA)));
-                  Index := @ + 4;
-                  exit when Index >= Storage_Offset (NIC_Packet_Header.Receive_Byte_Count);
-               end loop;
-            else
-               loop
-                  -- exit when To_ISR (In8 (BAR + 16#07#)).RDC;
-                  MMIO.Write (Payload_Address (P) + Index, In16 (PA (BAR, RDMA)));
-                  Index := @ + 2;
-                  exit when Index >= Storage_Offset (NIC_Packet_Header.Receive_Byte_Count);
-               end loop;
-            end if;
-            -- update packet pointer according to NIC-created packet header informations
-            D.Next_Ptr := NIC_Packet_Header.Next_Packet_Pointer;
+            -- remote DMA the frame directly into the payloads of the chain,
+            -- with the widest port accessor available; every pbuf but the
+            -- last is full, and PBUF_PAYLOAD_SIZE is a multiple of 4, so
+            -- transfers never straddle two payloads
+            Q := P;
+            while Q /= null loop
+               Index := 0;
+               if Wide_Transfers then
+                  while Index < Storage_Offset (Q.all.Size) loop
+                     MMIO.Write (Payload_CurrentAddress (Q) + Index, In32 (PA (BAR, RDMA)));
+                     Index := @ + 4;
+                  end loop;
+               else
+                  while Index < Storage_Offset (Q.all.Size) loop
+                     MMIO.Write (Payload_CurrentAddress (Q) + Index, In16 (PA (BAR, RDMA)));
+                     Index := @ + 2;
+                  end loop;
+               end if;
+               Q := Q.all.Next;
+            end loop;
             -- Console.Print_Memory (Payload_Address (P), Bits.Bytesize (NIC_Packet_Header.Receive_Byte_Count));
+            -- hand the frame to the stack by pointer
             declare
                Success : Boolean;
             begin
-               Ethernet.Enqueue (Ethernet.Packet_Queue'Access, P, Success);
-               if not Success then
-                  Console.Print ("*** Error: no FIFO slots available", NL => True);
+               Ethernet.Input (D.Interface_Id, P, Success);
+               if Success then
+                  D.RX_Frames := @ + 1;
+               else
+                  -- no FIFO slots available
+                  D.RX_Dropped := @ + 1;
+                  Trace.Event (Trace.LEVEL_INFO, Trace.NIC_RX_DROP, Unsigned_32 (NIC_Packet_Header.Receive_Byte_Count));
                   Free (P);
-                  -- loop null; end loop;
                end if;
             end;
          end if;
+         -- update packet pointer according to NIC-created packet header informations
+         D.Next_Ptr := NIC_Packet_Header.Next_Packet_Pointer;
       end loop;
       Update (D);
+   end Receive_Frames;
+
+   ----------------------------------------------------------------------------
+   -- Receive
+   ----------------------------------------------------------------------------
+   procedure Receive
+      (D : in out Descriptor_Type)
+      is
+      Unused : Boolean;
+   begin
+      Receive_Frames (D, Positive'Last, Unused);
    end Receive;
 
+   ----------------------------------------------------------------------------
+   -- Poll
+   ----------------------------------------------------------------------------
+   procedure Poll
+      (Descriptor_Address : in     Address;
+       Budget             : in     Positive;
+       Done               :    out Boolean)
+      is
+      D          : Descriptor_Type
+         with Address    => Descriptor_Address,
+              Import     => True,
+              Convention => Ada;
+      BAR        : Unsigned_16;
+      Intcontext : CPU.Intcontext_Type;
+      procedure Out8 (Port : in Unsigned_16; Value : in Unsigned_8) renames D.Write_8.all;
+   begin
+      -- the register page is shared with the interrupt handler
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      Receive_Frames (D, Budget, Done);
+      if Done then
+         -- ring empty, let the NIC interrupt again on the next frame
+         BAR := D.BAR;
+         Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
+         Out8 (PA (BAR, IMRW), To_U8 (IMR_RXTX));
+      end if;
+      CPU.Intcontext_Set (Intcontext);
+   end Poll;
+
    ----------------------------------------------------------------------------
    -- Transmit
    ----------------------------------------------------------------------------
@@ -959,8 +1044,11 @@ pragma Warnings (Off, "* is not referenced");
               Import     => True,
               Convention => Ada;
       BAR        : Unsigned_16;
-      Byte_Idx   : Integer;
+      Length     : Unsigned_16;
+      Q          : Pbuf_Ptr;
+      Byte_Idx   : Natural;
       Data       : Unsigned_32;
+      Busy       : Boolean;
       Intcontext : CPU.Intcontext_Type;
       function In8 (Port : Unsigned_16) return Unsigned_8 renames D.Read_8.all;
       procedure Out8 (Port : in Unsigned_16; Value : in Unsigned_8) renames D.Write_8.all;
@@ -971,47 +1059,58 @@ pragma Warnings (Off, "* is not referenced");
          is
       begin
          Console.Print (Prefix => "Packet tx is: ", Value => P.all.Size, NL => True);
-         Console.Print_Memory (Payload_Address (P), Bits.Bytesize (P.all.Size));
+         Console.Print_Memory (Payload_CurrentAddress (P), Bits.Bytesize (P.all.Size));
       end Packet_Dump;
    begin
       CPU.Intcontext_Get (Intcontext);
       CPU.Irq_Disable;
       BAR := D.BAR;
+      Length := Unsigned_16 (P.all.Total_Size);
       -- Page 0 NODMA
       Out8 (PA (BAR, CR), To_U8 (CR_PAGE0));
+      -- the transmit buffer is busy until the previous frame is out; if
+      -- the transmitter is stuck, drop this frame
+      for Count in 1 .. TX_TIMEOUT loop
+         Busy := To_CR (In8 (PA (BAR, CR))).TXP;
+         exit when not Busy;
+      end loop;
+      if Busy then
+         D.TX_Errors := @ + 1;
+         CPU.Intcontext_Set (Intcontext);
+         return;
+      end if;
       Out8 (PA (BAR, RSAR0), 16#00#);                  -- RSAR0: set remote start address LO
-      Out8 (PA (BAR, RSAR1), 16#42#);                  -- RSAR1: set remote start address HI
-      Out8 (PA (BAR, RBCR0), Unsigned_8 (P.all.Size)); -- RBCR0: set remote byte count LO
-      Out8 (PA (BAR, RBCR1), 16#00#);                  -- RBCR1: set remote byte count HI
+      Out8 (PA (BAR, RSAR1), TX_PAGE);                 -- RSAR1: set remote start address HI
+      Out8 (PA (BAR, RBCR0), LByte (Length));          -- RBCR0: set remote byte count LO
+      Out8 (PA (BAR, RBCR1), HByte (Length));          -- RBCR1: set remote byte count HI
       -- Page 0 WR
       Out8 (PA (BAR, CR), To_U8 (CR_WR));
       -- Packet_Dump;
-      -- fill packet data
+      -- fill packet data, gathering the current payloads of the chain
       Byte_Idx := 0;
       Data := 0;
-      for Index in 0 .. P.all.Size - 1 loop
-         Data := Shift_Left (@, 8) or Unsigned_32 (P.all.Payload (Index));
-         Byte_Idx := @ + 1;
-         if Index = P.all.Size - 1 then
-            case Byte_Idx is
-               when 3      => Data := Shift_Left (@, 8);
-               when 2      => Data := Shift_Left (@, 16);
-               when 1      => Data := Shift_Left (@, 24);
-               when others => null;
-            end case;
-            Byte_Idx := 4;
-         end if;
-         if Byte_Idx = 4 then
-            Data := Byte_Swap (@);
-            Out32 (BAR + 16#10#, Data);
-            Byte_Idx := 0;
-            Data := 0;
-         end if;
+      Q := P;
+      while Q /= null loop
+         for Index in Q.all.Offset .. Q.all.Offset + Q.all.Size - 1 loop
+            Data := Shift_Left (@, 8) or Unsigned_32 (Q.all.Payload (Index));
+            Byte_Idx := @ + 1;
+            if Byte_Idx = 4 then
+               Data := Byte_Swap (@);
+               Out32 (BAR + 16#10#, Data);
+               Byte_Idx := 0;
+               Data := 0;
+            end if;
+         end loop;
+         Q := Q.all.Next;
       end loop;
+      if Byte_Idx /= 0 then
+         Data := Byte_Swap (Shift_Left (@, 8 * (4 - Byte_Idx)));
+         Out32 (BAR + 16#10#, Data);
+      end if;
       -- TX packet
-      Out8 (PA (BAR, TPSRW), 16#42#);                  -- TPSR: set start page address
-      Out8 (PA (BAR, TBCR0), Unsigned_8 (P.all.Size)); -- TBCR0: set byte count LO
-      Out8 (PA (BAR, TBCR1), 16#00#);                  -- TBCR1: set byte count HI
+      Out8 (PA (BAR, TPSRW), TX_PAGE);                 -- TPSR: set start page address
+      Out8 (PA (BAR, TBCR0), LByte (Length));          -- TBCR0: set byte count LO
+      Out8 (PA (BAR, TBCR1), HByte (Length));          -- TBCR1: set byte count HI
       -- Page 0 TX
       Out8 (PA (BAR, CR), To_U8 (CR_TX));
       CPU.Intcontext_Set (Intcontext);
@@ -119,4 +119,35 @@ pragma Style_Checks (On);
          );
    end Init;
 
+   ----------------------------------------------------------------------------
+   -- IDE_Bus_Master_Init
+   ----------------------------------------------------------------------------
+   procedure IDE_Bus_Master_Init
+      (D            : in PCI.Descriptor_Type;
+       Base_Address : in Unsigned_16)
+      is
+      PCICMD1 : constant PCICMD1_Type := (
+         IOSE   => True,
+         BME    => True,
+         others => <>
+         );
+   begin
+      PCI.Cfg_Write (
+         Descriptor      => D,
+         Bus_Number      => PCI.BUS0,
+         Device_Number   => 1,
+         Function_Number => 1,
+         Register_Number => BMIBA,
+         Value           => Unsigned_32 (Base_Address) or BMIBA_RTE
+         );
+      PCI.Cfg_Write (
+         Descriptor      => D,
+         Bus_Number      => PCI.BUS0,
+         Device_Number   => 1,
+         Function_Number => 1,
+         Register_Number => PCI.Command_Offset,
+         Value           => To_U16 (PCICMD1)
+         );
+   end IDE_Bus_Master_Init;
+
 end PIIX;
@@ -0,0 +1,176 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ ramdisk.adb                                                                                               --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with Interfaces;
+with Bits;
+with Memory_Functions;
+
+package body RAMDisk
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use Interfaces;
+
+   function Is_Inside
+      (D     : Descriptor_Type;
+       S     : Sector_Type;
+       Count : Natural)
+      return Boolean
+      with Inline => True;
+
+   function Block_Location
+      (D : Descriptor_Type;
+       S : Sector_Type)
+      return Address
+      with Inline => True;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Is_Inside
+   ----------------------------------------------------------------------------
+   -- True if blocks S .. S + Count - 1 lie within the region.
+   ----------------------------------------------------------------------------
+   function Is_Inside
+      (D     : Descriptor_Type;
+       S     : Sector_Type;
+       Count : Natural)
+      return Boolean
+      is
+      Blocks : constant Unsigned_64 := Unsigned_64 (D.Size / RAMDISK_BLOCK_SIZE);
+   begin
+      return Unsigned_64 (S) + Unsigned_64 (Count) <= Blocks;
+   end Is_Inside;
+
+   ----------------------------------------------------------------------------
+   -- Block_Location
+   ----------------------------------------------------------------------------
+   function Block_Location
+      (D : Descriptor_Type;
+       S : Sector_Type)
+      return Address
+      is
+   begin
+      return D.Base_Address + Storage_Offset (S) * RAMDISK_BLOCK_SIZE;
+   end Block_Location;
+
+   ----------------------------------------------------------------------------
+   -- Probe
+   ----------------------------------------------------------------------------
+   function Probe
+      (D : Descriptor_Type)
+      return Boolean
+      is
+   begin
+      if D.Base_Address = Null_Address or else not Is_Inside (D, 0, 1) then
+         return False;
+      end if;
+      declare
+         Block : constant Block_Type (0 .. RAMDISK_BLOCK_SIZE - 1)
+            with Address    => D.Base_Address,
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         return Block (16#01FE# .. 16#01FF#) = [16#55#, 16#AA#];
+      end;
+   end Probe;
+
+   ----------------------------------------------------------------------------
+   -- Read_Blocks
+   ----------------------------------------------------------------------------
+   procedure Read_Blocks
+      (Data_Address : in     Address;
+       S            : in     Sector_Type;
+       B            :    out Block_Type;
+       Success      :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      if B'Length mod RAMDISK_BLOCK_SIZE /= 0 or else not Is_Inside (D, S, B'Length / RAMDISK_BLOCK_SIZE) then
+         Success := False;
+         return;
+      end if;
+      Memory_Functions.Cpymem (Block_Location (D, S), B'Address, Bits.Bytesize (B'Length));
+      Success := True;
+   end Read_Blocks;
+
+   ----------------------------------------------------------------------------
+   -- Write_Blocks
+   ----------------------------------------------------------------------------
+   procedure Write_Blocks
+      (Data_Address : in     Address;
+       S            : in     Sector_Type;
+       B            : in     Block_Type;
+       Success      :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      if D.Read_Only or else
+         B'Length mod RAMDISK_BLOCK_SIZE /= 0 or else
+         not Is_Inside (D, S, B'Length / RAMDISK_BLOCK_SIZE)
+      then
+         Success := False;
+         return;
+      end if;
+      Memory_Functions.Cpymem (B'Address, Block_Location (D, S), Bits.Bytesize (B'Length));
+      Success := True;
+   end Write_Blocks;
+
+   ----------------------------------------------------------------------------
+   -- Map_Blocks
+   ----------------------------------------------------------------------------
+   procedure Map_Blocks
+      (Data_Address  : in     Address;
+       S             : in     Sector_Type;
+       Count         : in     Positive;
+       Block_Address :    out Address;
+       Success       :    out Boolean)
+      is
+      D : Descriptor_Type
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      if not Is_Inside (D, S, Count) then
+         Block_Address := Null_Address;
+         Success := False;
+         return;
+      end if;
+      Block_Address := Block_Location (D, S);
+      Success := True;
+   end Map_Blocks;
+
+end RAMDisk;
@@ -0,0 +1,446 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ memtest.adb                                                                                               --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System;
+with System.Storage_Elements;
+with Interfaces;
+with Interfaces.C;
+with Ada.Real_Time;
+with Ada.Text_IO;
+with Ada.Command_Line;
+with Memory_Functions;
+
+----------------------------------------------------------------------------
+-- Host-side test of the core memory functions.
+--
+-- Memory_Functions is linked into the program, so that its memcmp,
+-- memcpy, memmove and memset exports take the place of the host C library
+-- ones.
+-- Every routine is checked against a bytewise reference over a matrix of
+-- source/destination offsets and lengths, including 0, odd lengths and
+-- lengths that are not a multiple of the unroll factor; the bytes around
+-- the destination area are checked as well, to catch overruns. A short
+-- throughput report follows. The exit status is nonzero on failure.
+----------------------------------------------------------------------------
+
+procedure MEMtest
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System;
+   use System.Storage_Elements;
+   use Interfaces;
+   use Interfaces.C;
+   use Ada.Real_Time;
+
+   pragma Warnings (Off, Memory_Functions);
+
+   MAX_OFFSET  : constant := 2 * Word_Size / Storage_Unit - 1;
+   MAX_LENGTH  : constant := 4_099;
+   GUARD       : constant := 16;
+   BUFFER_SIZE : constant := MAX_OFFSET + MAX_LENGTH + GUARD;
+   CANARY      : constant Unsigned_8 := 16#A5#;
+   MAX_ERRORS  : constant := 16;
+
+   -- every length up to a few unrolled word blocks, then some larger ones
+   SHORT_LENGTH : constant := 160;
+   LONG_LENGTHS : constant array (Positive range <>) of Natural :=
+      [255, 256, 257, 1_023, 1_024, 1_025, 4_093, 4_096, MAX_LENGTH];
+
+   type Buffer_Type is array (0 .. BUFFER_SIZE - 1) of Unsigned_8
+      with Alignment => 64;
+
+   Source    : Buffer_Type;
+   Target    : Buffer_Type;
+   Reference : Buffer_Type;
+
+   Errors : Natural := 0;
+   Checks : Natural := 0;
+
+   function Memcmp
+      (S1 : Address;
+       S2 : Address;
+       N  : size_t)
+      return int
+      with Import        => True,
+           Convention    => C,
+           External_Name => "memcmp";
+
+   function Memcpy
+      (S1 : Address;
+       S2 : Address;
+       N  : size_t)
+      return Address
+      with Import        => True,
+           Convention    => C,
+           External_Name => "memcpy";
+
+   function Memmove
+      (S1 : Address;
+       S2 : Address;
+       N  : size_t)
+      return Address
+      with Import        => True,
+           Convention    => C,
+           External_Name => "memmove";
+
+   function Memset
+      (S : Address;
+       C : int;
+       N : size_t)
+      return Address
+      with Import        => True,
+           Convention    => C,
+           External_Name => "memset";
+
+   procedure Fill
+      (B    : out Buffer_Type;
+       Seed : in  Unsigned_8);
+   procedure Check
+      (Name   : in String;
+       Offset : in Natural;
+       Length : in Natural;
+       Result : in Address;
+       Wanted : in Address);
+   procedure Test_Memcmp
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural);
+   procedure Test_Memcpy
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural);
+   procedure Test_Memmove
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural);
+   procedure Test_Memset
+      (Offset : in Natural;
+       Length : in Natural;
+       Value  : in int);
+   procedure Test_Length
+      (Length : in Natural);
+   procedure Throughput;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local subprograms                            --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Fill
+   ----------------------------------------------------------------------------
+   -- Fill a buffer with a pattern which never repeats within a word.
+   ----------------------------------------------------------------------------
+   procedure Fill
+      (B    : out Buffer_Type;
+       Seed : in  Unsigned_8)
+      is
+   begin
+      for Index in B'Range loop
+         B (Index) := Unsigned_8 ((Index * 7 + Natural (Seed)) mod 251);
+      end loop;
+   end Fill;
+
+   ----------------------------------------------------------------------------
+   -- Check
+   ----------------------------------------------------------------------------
+   -- Compare Target with Reference, together with the returned address.
+   ----------------------------------------------------------------------------
+   procedure Check
+      (Name   : in String;
+       Offset : in Natural;
+       Length : in Natural;
+       Result : in Address;
+       Wanted : in Address)
+      is
+   begin
+      Checks := @ + 1;
+      if Result /= Wanted then
+         Errors := @ + 1;
+         if Errors <= MAX_ERRORS then
+            Ada.Text_IO.Put_Line (Name & ": wrong return value");
+         end if;
+         return;
+      end if;
+      for Index in 0 .. Offset + Length + GUARD - 1 loop
+         if Target (Index) /= Reference (Index) then
+            Errors := @ + 1;
+            if Errors <= MAX_ERRORS then
+               Ada.Text_IO.Put_Line (
+                  Name                                 &
+                  ": mismatch at byte" & Index'Image   &
+                  ", offset"           & Offset'Image  &
+                  ", length"           & Length'Image
+                  );
+            end if;
+            return;
+         end if;
+      end loop;
+   end Check;
+
+   ----------------------------------------------------------------------------
+   -- Test_Memcmp
+   ----------------------------------------------------------------------------
+   -- Compare equal areas, then areas differing in the first, middle or last
+   -- byte, in both directions; only the sign of the result is checked.
+   ----------------------------------------------------------------------------
+   procedure Test_Memcmp
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural)
+      is
+      Original : Unsigned_8;
+      procedure Verify
+         (Position : in Integer;
+          Wanted   : in int);
+      procedure Verify
+         (Position : in Integer;
+          Wanted   : in int)
+         is
+         Result : int;
+      begin
+         Checks := @ + 1;
+         Result := Memcmp (
+                      Target (Target_Offset)'Address,
+                      Source (Source_Offset)'Address,
+                      size_t (Length)
+                      );
+         if int'Min (int'Max (Result, -1), 1) /= Wanted then
+            Errors := @ + 1;
+            if Errors <= MAX_ERRORS then
+               Ada.Text_IO.Put_Line (
+                  "memcmp: wrong result" & Result'Image        &
+                  ", position"           & Position'Image      &
+                  ", source offset"      & Source_Offset'Image &
+                  ", target offset"      & Target_Offset'Image &
+                  ", length"             & Length'Image
+                  );
+            end if;
+         end if;
+      end Verify;
+   begin
+      Target := [others => CANARY];
+      for Index in 0 .. Length - 1 loop
+         Target (Target_Offset + Index) := Source (Source_Offset + Index);
+      end loop;
+      Verify (-1, 0);
+      if Length > 0 then
+         declare
+            Positions : constant array (1 .. 3) of Natural := [0, Length / 2, Length - 1];
+         begin
+            for Position of Positions loop
+               Original := Target (Target_Offset + Position);
+               Target (Target_Offset + Position) := Original + 1;
+               Verify (Position, (if Original = Unsigned_8'Last then -1 else 1));
+               Target (Target_Offset + Position) := Original - 1;
+               Verify (Position, (if Original = Unsigned_8'First then 1 else -1));
+               Target (Target_Offset + Position) := Original;
+            end loop;
+         end;
+      end if;
+   end Test_Memcmp;
+
+   ----------------------------------------------------------------------------
+   -- Test_Memcpy
+   ----------------------------------------------------------------------------
+   procedure Test_Memcpy
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural)
+      is
+      Result : Address;
+   begin
+      Target    := [others => CANARY];
+      Reference := [others => CANARY];
+      for Index in 0 .. Length - 1 loop
+         Reference (Target_Offset + Index) := Source (Source_Offset + Index);
+      end loop;
+      Result := Memcpy (
+                   Target (Target_Offset)'Address,
+                   Source (Source_Offset)'Address,
+                   size_t (Length)
+                   );
+      Check (
+         "memcpy (source offset" & Source_Offset'Image & ")",
+         Target_Offset,
+         Length,
+         Result,
+         Target (Target_Offset)'Address
+         );
+   end Test_Memcpy;
+
+   ----------------------------------------------------------------------------
+   -- Test_Memmove
+   ----------------------------------------------------------------------------
+   -- Source and target areas lie in the same buffer and overlap, in both
+   -- directions, whenever Length exceeds the offset displacement.
+   ----------------------------------------------------------------------------
+   procedure Test_Memmove
+      (Source_Offset : in Natural;
+       Target_Offset : in Natural;
+       Length        : in Natural)
+      is
+      Result : Address;
+   begin
+      Fill (Target, 16#3C#);
+      Reference := Target;
+      if Target_Offset > Source_Offset then
+         for Index in reverse 0 .. Length - 1 loop
+            Reference (Target_Offset + Index) := Reference (Source_Offset + Index);
+         end loop;
+      else
+         for Index in 0 .. Length - 1 loop
+            Reference (Target_Offset + Index) := Reference (Source_Offset + Index);
+         end loop;
+      end if;
+      Result := Memmove (
+                   Target (Target_Offset)'Address,
+                   Target (Source_Offset)'Address,
+                   size_t (Length)
+                   );
+      Check (
+         "memmove (source offset" & Source_Offset'Image & ")",
+         Target_Offset,
+         Length,
+         Result,
+         Target (Target_Offset)'Address
+         );
+   end Test_Memmove;
+
+   ----------------------------------------------------------------------------
+   -- Test_Memset
+   ----------------------------------------------------------------------------
+   procedure Test_Memset
+      (Offset : in Natural;
+       Length : in Natural;
+       Value  : in int)
+      is
+      Result : Address;
+   begin
+      Target    := [others => CANARY];
+      Reference := [others => CANARY];
+      for Index in 0 .. Length - 1 loop
+         Reference (Offset + Index) := Unsigned_8 (Value mod 256);
+      end loop;
+      Result := Memset (Target (Offset)'Address, Value, size_t (Length));
+      Check (
+         "memset (value" & Value'Image & ")",
+         Offset,
+         Length,
+         Result,
+         Target (Offset)'Address
+         );
+   end Test_Memset;
+
+   ----------------------------------------------------------------------------
+   -- Test_Length
+   ----------------------------------------------------------------------------
+   -- Run every routine over all the offset combinations for one length.
+   ----------------------------------------------------------------------------
+   procedure Test_Length
+      (Length : in Natural)
+      is
+   begin
+      for Source_Offset in 0 .. MAX_OFFSET loop
+         for Target_Offset in 0 .. MAX_OFFSET loop
+            Test_Memcmp (Source_Offset, Target_Offset, Length);
+            Test_Memcpy (Source_Offset, Target_Offset, Length);
+            Test_Memmove (Source_Offset, Target_Offset, Length);
+         end loop;
+      end loop;
+      for Offset in 0 .. MAX_OFFSET loop
+         Test_Memset (Offset, Length, 16#5A#);
+         -- only the low-order byte of the value is stored
+         Test_Memset (Offset, Length, 16#1FF#);
+      end loop;
+   end Test_Length;
+
+   ----------------------------------------------------------------------------
+   -- Throughput
+   ----------------------------------------------------------------------------
+   -- Report MB/s for large aligned and misaligned transfers.
+   ----------------------------------------------------------------------------
+   procedure Throughput
+      is
+      ITERATIONS : constant := 20_000;
+      LENGTH     : constant := 4_096;
+      OFFSETS    : constant array (Positive range <>) of Natural := [0, 1, 3];
+      procedure Report
+         (Name    : in String;
+          Elapsed : in Time_Span);
+      procedure Report
+         (Name    : in String;
+          Elapsed : in Time_Span)
+         is
+         Seconds : constant Duration := To_Duration (Elapsed);
+      begin
+         if Seconds > 0.0 then
+            Ada.Text_IO.Put_Line (
+               Name & ":" &
+               Natural (Float (ITERATIONS) * Float (LENGTH) / Float (Seconds) / 1.0E6)'Image &
+               " MB/s"
+               );
+         end if;
+      end Report;
+      Start  : Time;
+      Result : Address with Volatile => True;
+   begin
+      for Offset of OFFSETS loop
+         Start := Clock;
+         for Iteration in 1 .. ITERATIONS loop
+            Result := Memcpy (Target (Offset)'Address, Source (Offset)'Address, LENGTH);
+         end loop;
+         Report ("memcpy  offset" & Offset'Image, Clock - Start);
+         Start := Clock;
+         for Iteration in 1 .. ITERATIONS loop
+            Result := Memmove (Target (Offset + 1)'Address, Target (Offset)'Address, LENGTH);
+         end loop;
+         Report ("memmove offset" & Offset'Image, Clock - Start);
+         Start := Clock;
+         for Iteration in 1 .. ITERATIONS loop
+            Result := Memset (Target (Offset)'Address, 0, LENGTH);
+         end loop;
+         Report ("memset  offset" & Offset'Image, Clock - Start);
+      end loop;
+   end Throughput;
+
+begin
+   Fill (Source, 16#11#);
+   for Length in 0 .. SHORT_LENGTH loop
+      Test_Length (Length);
+   end loop;
+   for Length of LONG_LENGTHS loop
+      Test_Length (Length);
+   end loop;
+   Ada.Text_IO.Put_Line ("checks:" & Checks'Image & ", errors:" & Errors'Image);
+   if Errors /= 0 then
+      Ada.Command_Line.Set_Exit_Status (Ada.Command_Line.Failure);
+      return;
+   end if;
+   Throughput;
+end MEMtest;
@@ -15,8 +15,10 @@
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
 
+with Ada.Characters.Latin_1;
+with MBR;
 with FATFS.Directory;
-with FATFS.Textfile;
+with FATFS.Rawfile;
 with Console;
 
 package body FATFS.Applications
@@ -30,8 +32,13 @@ package body FATFS.Applications
    --                                                                        --
    --========================================================================--
 
+   package ISO88591 renames Ada.Characters.Latin_1;
+
    procedure Print_File_Name
       (F : Directory_Entry_Type);
+   procedure Print_Text
+      (Text_Address : in Address;
+       Length       : in Unsigned_32);
 
    --========================================================================--
    --                                                                        --
@@ -73,6 +80,29 @@ package body FATFS.Applications
       Console.Print_NewLine;
    end Print_File_Name;
 
+   ----------------------------------------------------------------------------
+   -- Print_Text
+   ----------------------------------------------------------------------------
+   -- Print Length bytes of text at Text_Address, CR/LF line endings.
+   ----------------------------------------------------------------------------
+   procedure Print_Text
+      (Text_Address : in Address;
+       Length       : in Unsigned_32)
+      is
+      Text : String (1 .. Natural (Length))
+         with Address    => Text_Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      for C of Text loop
+         case C is
+            when ISO88591.CR => null;
+            when ISO88591.LF => Console.Print_NewLine;
+            when others      => Console.Print (C);
+         end case;
+      end loop;
+   end Print_Text;
+
    ----------------------------------------------------------------------------
    -- Test
    ----------------------------------------------------------------------------
@@ -117,25 +147,27 @@ package body FATFS.Applications
          exit when not Success;
          if DE.File_Name = "AUTOEXEC" and then DE.Extension = "BAT" then
             declare
-               F    : TFCB_Type;
-               L    : Natural;
-               Line : String (1 .. 80);
+               File         : FCB_Type;
+               B            : Block_Type (0 .. 2_047);
+               Text_Address : Address;
+               Count        : Unsigned_32;
             begin
                Console.Print ("Loading AUTOEXEC.BAT ...", NL => True);
-               Textfile.Open (D, F, DE, Success);
+               Rawfile.Open (D, File, DE, Success);
                if Success then
-                  Line := [others => ' '];
-                  Textfile.Read_Line (D, F, Line, L, Success);
-                  Console.Print (Line);
-                  Console.Print_NewLine;
-                  Line := [others => ' '];
-                  Textfile.Read_Line (D, F, Line, L, Success);
-                  Console.Print (Line);
-                  Console.Print_NewLine;
-                  Line := [others => ' '];
-                  Textfile.Read_Line (D, F, Line, L, Success);
-                  Console.Print (Line);
-                  Console.Print_NewLine;
+                  -- a cluster per request: in place in the image of a
+                  -- memory-backed device, otherwise as much of it as fits
+                  -- in B
+                  loop
+                     Rawfile.Map (D, File, Text_Address, Count, Success);
+                     if not Success then
+                        Rawfile.Read_Cluster (D, File, B, Count, Success);
+                        Text_Address := B'Address;
+                     end if;
+                     exit when not Success;
+                     Print_Text (Text_Address, Count);
+                  end loop;
+                  Rawfile.Close (D, File);
                end if;
             end;
             return;
@@ -147,4 +179,29 @@ package body FATFS.Applications
       -- Directory.Close (DCB);
    end Load_AUTOEXECBAT;
 
+   ----------------------------------------------------------------------------
+   -- Mount
+   ----------------------------------------------------------------------------
+   procedure Mount
+      (D       : in out Descriptor_Type;
+       Device  : in     BlockDevices.Descriptor_Ptr;
+       Success :    out Boolean)
+      is
+      Partition       : MBR.Partition_Entry_Type;
+      Partition_Start : Sector_Type;
+   begin
+      MBR.Read (Device, MBR.PARTITION1, Partition, Success);
+      if Success and then
+         Partition.Partition in MBR.Partition_FAT12     | MBR.Partition_FAT16     |
+                                MBR.Partition_FAT16B    | MBR.Partition_FAT32_CHS |
+                                MBR.Partition_FAT32_LBA
+      then
+         Partition_Start := Sector_Type (Partition.LBA_Start);
+      else
+         Partition_Start := 0;
+      end if;
+      D.Device := Device;
+      Open (D, Partition_Start, Success);
+   end Mount;
+
 end FATFS.Applications;
@@ -0,0 +1,406 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ fatfs-cache.adb                                                                                           --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with Memory_Functions;
+
+package body FATFS.Cache
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   pragma Compile_Time_Error (
+      (CACHE_NBUCKETS and (CACHE_NBUCKETS - 1)) /= 0,
+      "CACHE_NBUCKETS must be a power of two"
+      );
+
+   type Slot_Link_Type is new Natural range 0 .. CACHE_NSLOTS;
+
+   NO_SLOT : constant Slot_Link_Type := 0;
+
+   subtype Slot_Index_Type is Slot_Link_Type range 1 .. CACHE_NSLOTS;
+
+   type Slot_Type is record
+      Device : BlockDevices.Descriptor_Ptr := null;
+      Sector : Sector_Type                 := 0;
+      Valid  : Boolean                     := False;
+      Dirty  : Boolean                     := False;
+      Stamp  : Unsigned_32                 := 0;       -- last use, for LRU
+      Next   : Slot_Link_Type              := NO_SLOT; -- hash chain
+   end record;
+
+   subtype Buffer_Type is Block_Type (0 .. CACHE_SECTOR_SIZE - 1);
+
+   Slots   : array (Slot_Index_Type) of Slot_Type;
+   Buffers : array (Slot_Index_Type) of aliased Buffer_Type;
+   Buckets : array (0 .. CACHE_NBUCKETS - 1) of Slot_Link_Type := [others => NO_SLOT];
+   Clock   : Unsigned_32 := 0;
+   Stats   : Statistics_Type := (Hits => 0, Misses => 0, Writebacks => 0);
+
+   function Bucket
+      (S : Sector_Type)
+      return Natural
+      with Inline => True;
+   function Lookup
+      (Device : BlockDevices.Descriptor_Ptr;
+       S      : Sector_Type)
+      return Slot_Link_Type;
+   procedure Touch
+      (Slot : in Slot_Index_Type)
+      with Inline => True;
+   procedure Unlink
+      (Slot : in Slot_Index_Type);
+   procedure Writeback
+      (Slot    : in     Slot_Index_Type;
+       Success :    out Boolean);
+   procedure Allocate
+      (Device  : in     BlockDevices.Descriptor_Ptr;
+       S       : in     Sector_Type;
+       Slot    :    out Slot_Index_Type;
+       Success :    out Boolean);
+   procedure Drop
+      (Device  : in     BlockDevices.Descriptor_Ptr;
+       S       : in     Sector_Type;
+       Count   : in     Natural;
+       Success :    out Boolean);
+   function Is_Cacheable
+      (D : Descriptor_Type;
+       B : Block_Type)
+      return Boolean
+      with Inline => True;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Bucket
+   ----------------------------------------------------------------------------
+   function Bucket
+      (S : Sector_Type)
+      return Natural
+      is
+   begin
+      return Natural (S and (CACHE_NBUCKETS - 1));
+   end Bucket;
+
+   ----------------------------------------------------------------------------
+   -- Lookup
+   ----------------------------------------------------------------------------
+   -- Return the slot holding sector S of Device, NO_SLOT if not cached.
+   ----------------------------------------------------------------------------
+   function Lookup
+      (Device : BlockDevices.Descriptor_Ptr;
+       S      : Sector_Type)
+      return Slot_Link_Type
+      is
+      Slot : Slot_Link_Type;
+   begin
+      Slot := Buckets (Bucket (S));
+      while Slot /= NO_SLOT loop
+         exit when Slots (Slot).Sector = S and then Slots (Slot).Device = Device;
+         Slot := Slots (Slot).Next;
+      end loop;
+      return Slot;
+   end Lookup;
+
+   ----------------------------------------------------------------------------
+   -- Touch
+   ----------------------------------------------------------------------------
+   procedure Touch
+      (Slot : in Slot_Index_Type)
+      is
+   begin
+      Clock := @ + 1;
+      Slots (Slot).Stamp := Clock;
+   end Touch;
+
+   ----------------------------------------------------------------------------
+   -- Unlink
+   ----------------------------------------------------------------------------
+   -- Remove a valid slot from its hash chain and invalidate it.
+   ----------------------------------------------------------------------------
+   procedure Unlink
+      (Slot : in Slot_Index_Type)
+      is
+      Index    : constant Natural := Bucket (Slots (Slot).Sector);
+      Previous : Slot_Link_Type;
+   begin
+      if Buckets (Index) = Slot then
+         Buckets (Index) := Slots (Slot).Next;
+      else
+         Previous := Buckets (Index);
+         while Previous /= NO_SLOT and then Slots (Previous).Next /= Slot loop
+            Previous := Slots (Previous).Next;
+         end loop;
+         if Previous /= NO_SLOT then
+            Slots (Previous).Next := Slots (Slot).Next;
+         end if;
+      end if;
+      Slots (Slot).Next  := NO_SLOT;
+      Slots (Slot).Valid := False;
+      Slots (Slot).Dirty := False;
+   end Unlink;
+
+   ----------------------------------------------------------------------------
+   -- Writeback
+   ----------------------------------------------------------------------------
+   procedure Writeback
+      (Slot    : in     Slot_Index_Type;
+       Success :    out Boolean)
+      is
+   begin
+      BlockDevices.Write (Slots (Slot).Device.all, Slots (Slot).Sector, Buffers (Slot), Success);
+      if Success then
+         Slots (Slot).Dirty := False;
+         Stats.Writebacks := @ + 1;
+      end if;
+   end Writeback;
+
+   ----------------------------------------------------------------------------
+   -- Allocate
+   ----------------------------------------------------------------------------
+   -- Take a free slot or, failing that, the least recently used one, and
+   -- bind it to sector S of Device; the buffer contents are undefined.
+   ----------------------------------------------------------------------------
+   procedure Allocate
+      (Device  : in     BlockDevices.Descriptor_Ptr;
+       S       : in     Sector_Type;
+       Slot    :    out Slot_Index_Type;
+       Success :    out Boolean)
+      is
+      Index : Natural;
+   begin
+      Slot := Slot_Index_Type'First;
+      for Candidate in Slot_Index_Type loop
+         if not Slots (Candidate).Valid then
+            Slot := Candidate;
+            exit;
+         end if;
+         if Clock - Slots (Candidate).Stamp > Clock - Slots (Slot).Stamp then
+            Slot := Candidate;
+         end if;
+      end loop;
+      if Slots (Slot).Valid then
+         if Slots (Slot).Dirty then
+            Writeback (Slot, Success);
+            if not Success then
+               return;
+            end if;
+         end if;
+         Unlink (Slot);
+      end if;
+      Index := Bucket (S);
+      Slots (Slot) := (
+         Device => Device,
+         Sector => S,
+         Valid  => True,
+         Dirty  => False,
+         Stamp  => 0,
+         Next   => Buckets (Index)
+         );
+      Buckets (Index) := Slot;
+      Touch (Slot);
+      Success := True;
+   end Allocate;
+
+   ----------------------------------------------------------------------------
+   -- Drop
+   ----------------------------------------------------------------------------
+   -- Write back and discard the cached copies of sectors S .. S + Count - 1,
+   -- if any; used before transfers that bypass the cache.
+   ----------------------------------------------------------------------------
+   procedure Drop
+      (Device  : in     BlockDevices.Descriptor_Ptr;
+       S       : in     Sector_Type;
+       Count   : in     Natural;
+       Success :    out Boolean)
+      is
+      Slot : Slot_Link_Type;
+   begin
+      Success := True;
+      for Index in 0 .. Count - 1 loop
+         Slot := Lookup (Device, S + Sector_Type (Index));
+         if Slot /= NO_SLOT then
+            if Slots (Slot).Dirty then
+               Writeback (Slot, Success);
+               exit when not Success;
+            end if;
+            Unlink (Slot);
+         end if;
+      end loop;
+   end Drop;
+
+   ----------------------------------------------------------------------------
+   -- Is_Cacheable
+   ----------------------------------------------------------------------------
+   -- Only single-sector transfers on devices with CACHE_SECTOR_SIZE blocks
+   -- go through the slots, everything else goes straight to the device;
+   -- memory-backed (mappable) devices are never cached.
+   ----------------------------------------------------------------------------
+   function Is_Cacheable
+      (D : Descriptor_Type;
+       B : Block_Type)
+      return Boolean
+      is
+   begin
+      return D.Device.all.Map_Blocks = null             and then
+             D.Device.all.Block_Size = CACHE_SECTOR_SIZE and then
+             B'Length = CACHE_SECTOR_SIZE;
+   end Is_Cacheable;
+
+   ----------------------------------------------------------------------------
+   -- Read
+   ----------------------------------------------------------------------------
+   procedure Read
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       B       :    out Block_Type;
+       Success :    out Boolean)
+      is
+      Slot          : Slot_Link_Type;
+      Block_Address : Address;
+   begin
+      if D.Device.all.Map_Blocks /= null then
+         -- memory-backed device, never cached: copy straight from the
+         -- mapped blocks
+         BlockDevices.Map (
+            D.Device.all,
+            S,
+            (B'Length + D.Device.all.Block_Size - 1) / D.Device.all.Block_Size,
+            Block_Address,
+            Success
+            );
+         if Success then
+            Memory_Functions.Cpymem (Block_Address, B'Address, Bytesize (B'Length));
+         end if;
+         return;
+      end if;
+      if not Is_Cacheable (D, B) then
+         Drop (D.Device, S, (B'Length + CACHE_SECTOR_SIZE - 1) / CACHE_SECTOR_SIZE, Success);
+         if Success then
+            BlockDevices.Read (D.Device.all, S, B, Success);
+         end if;
+         return;
+      end if;
+      Slot := Lookup (D.Device, S);
+      if Slot /= NO_SLOT then
+         Stats.Hits := @ + 1;
+         Touch (Slot);
+      else
+         Stats.Misses := @ + 1;
+         Allocate (D.Device, S, Slot, Success);
+         if not Success then
+            return;
+         end if;
+         BlockDevices.Read (D.Device.all, S, Buffers (Slot), Success);
+         if not Success then
+            Unlink (Slot);
+            return;
+         end if;
+      end if;
+      B := Buffers (Slot);
+      Success := True;
+   end Read;
+
+   ----------------------------------------------------------------------------
+   -- Write
+   ----------------------------------------------------------------------------
+   procedure Write
+      (D       : in     Descriptor_Type;
+       S       : in     Sector_Type;
+       B       : in     Block_Type;
+       Success :    out Boolean)
+      is
+      Slot : Slot_Link_Type;
+   begin
+      if not Is_Cacheable (D, B) then
+         Drop (D.Device, S, (B'Length + CACHE_SECTOR_SIZE - 1) / CACHE_SECTOR_SIZE, Success);
+         if Success then
+            BlockDevices.Write (D.Device.all, S, B, Success);
+         end if;
+         return;
+      end if;
+      Slot := Lookup (D.Device, S);
+      if Slot /= NO_SLOT then
+         Touch (Slot);
+      else
+         Allocate (D.Device, S, Slot, Success);
+         if not Success then
+            return;
+         end if;
+      end if;
+      Buffers (Slot) := B;
+      Slots (Slot).Dirty := True;
+      Success := True;
+   end Write;
+
+   ----------------------------------------------------------------------------
+   -- Flush
+   ----------------------------------------------------------------------------
+   procedure Flush
+      (D       : in     Descriptor_Type;
+       Success :    out Boolean)
+      is
+      Result : Boolean;
+   begin
+      Success := True;
+      for Slot in Slot_Index_Type loop
+         if Slots (Slot).Valid and then Slots (Slot).Dirty and then Slots (Slot).Device = D.Device then
+            Writeback (Slot, Result);
+            Success := Success and then Result;
+         end if;
+      end loop;
+      if Success then
+         BlockDevices.Flush (D.Device.all, Success);
+      end if;
+   end Flush;
+
+   ----------------------------------------------------------------------------
+   -- Invalidate
+   ----------------------------------------------------------------------------
+   procedure Invalidate
+      (D : in Descriptor_Type)
+      is
+   begin
+      for Slot in Slot_Index_Type loop
+         if Slots (Slot).Valid and then Slots (Slot).Device = D.Device then
+            Unlink (Slot);
+         end if;
+      end loop;
+   end Invalidate;
+
+   ----------------------------------------------------------------------------
+   -- Statistics
+   ----------------------------------------------------------------------------
+   function Statistics
+      return Statistics_Type
+      is
+   begin
+      return Stats;
+   end Statistics;
+
+end FATFS.Cache;
@@ -15,6 +15,8 @@
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
 
+with FATFS.Cache;
+
 package body FATFS.Cluster
    is
 
@@ -78,6 +80,19 @@ package body FATFS.Cluster
        B       :    out Block_Type;
        Success :    out Boolean);
 
+   ----------------------------------------------------------------------------
+   -- Run_Start
+   ----------------------------------------------------------------------------
+   -- Move to the next cluster if at the end of the current one, and return
+   -- in Count the number of sectors left in it, at most Max.
+   ----------------------------------------------------------------------------
+   procedure Run_Start
+      (D       : in     Descriptor_Type;
+       CCB     : in out CCB_Type;
+       Max     : in     Natural;
+       Count   :    out Unsigned_16;
+       Success :    out Boolean);
+
    --========================================================================--
    --                                                                        --
    --                                                                        --
@@ -132,7 +147,7 @@ package body FATFS.Cluster
       end if;
       -- locate FAT sector for this cluster number
       Sector := To_Table_Sector (D, C);
-      IDE.Read (D.Device.all, Physical_Sector (D, Sector), B, Success);
+      Cache.Read (D, Physical_Sector (D, Sector), B, Success);
       if not Success then
          return;
       end if;
@@ -173,7 +188,7 @@ package body FATFS.Cluster
             then
                First := False;
                -- read in FAT sector
-               IDE.Read (D.Device.all, Physical_Sector (D, Sector), B, Success);
+               Cache.Read (D, Physical_Sector (D, Sector), B, Success);
                exit when not Success;
             end if;
             if Entry_Get (D, B, D.Search_Cluster) = 0 then
@@ -337,7 +352,7 @@ package body FATFS.Cluster
          Success := True;
       end if;
       if Success then
-         IDE.Read (D.Device.all, Physical_Sector (D, CCB.Current_Sector), B, Success);
+         Cache.Read (D, Physical_Sector (D, CCB.Current_Sector), B, Success);
       end if;
    end Peek;
 
@@ -423,7 +438,7 @@ package body FATFS.Cluster
          D.Next_Writable_Cluster := 0;
       end if;
       -- read in the FAT cluster
-      IDE.Read (D.Device.all, Physical_Sector (D, Sector), B, Success);
+      Cache.Read (D, Physical_Sector (D, Sector), B, Success);
       if Success then
          -- mark as in use (as EOF)
          Entry_Update (D, B, C, Chain);
@@ -450,6 +465,106 @@ package body FATFS.Cluster
       end if;
    end Read;
 
+   ----------------------------------------------------------------------------
+   -- Run_Start
+   ----------------------------------------------------------------------------
+   procedure Run_Start
+      (D       : in     Descriptor_Type;
+       CCB     : in out CCB_Type;
+       Max     : in     Natural;
+       Count   :    out Unsigned_16;
+       Success :    out Boolean)
+      is
+      FAT_Block : Block_Type (0 .. Natural (D.Sector_Size) - 1);
+   begin
+      Count := 0;
+      if not Is_Valid (CCB) then
+         Success := False;
+         return;
+      end if;
+      if Is_End (CCB) then
+         Get_Next (D, CCB, FAT_Block, Success);
+         if not Success then
+            return;
+         end if;
+      end if;
+      Count := CCB.Sector_Count - Unsigned_16 (CCB.Current_Sector - CCB.Start_Sector);
+      Count := Unsigned_16 (Natural'Min (Natural (@), Max));
+      Success := Count /= 0;
+   end Run_Start;
+
+   ----------------------------------------------------------------------------
+   -- Read_Cluster
+   ----------------------------------------------------------------------------
+   procedure Read_Cluster
+      (D       : in     Descriptor_Type;
+       CCB     : in out CCB_Type;
+       B       :    out Block_Type;
+       Count   :    out Unsigned_16;
+       Success :    out Boolean)
+      is
+      Length : Natural;
+   begin
+      Run_Start (D, CCB, B'Length / Natural (D.Sector_Size), Count, Success);
+      if not Success then
+         Count := 0;
+         return;
+      end if;
+      Length := Natural (Count) * Natural (D.Sector_Size);
+      -- Cache sends a run of several sectors straight to the device, and
+      -- keeps a single one in a slot
+      Cache.Read (D, Physical_Sector (D, CCB.Current_Sector), B (B'First .. B'First + Length - 1), Success);
+      if Success then
+         CCB.Previous_Sector := CCB.Current_Sector + Sector_Type (Count) - 1;
+         CCB.Current_Sector  := @ + Sector_Type (Count);
+         CCB.IO_Bytes        := @ + Unsigned_32 (Length);
+      else
+         Count := 0;
+      end if;
+   end Read_Cluster;
+
+   ----------------------------------------------------------------------------
+   -- Map_Cluster
+   ----------------------------------------------------------------------------
+   procedure Map_Cluster
+      (D             : in     Descriptor_Type;
+       CCB           : in out CCB_Type;
+       Block_Address :    out Address;
+       Count         :    out Unsigned_16;
+       Success       :    out Boolean)
+      is
+      Length : Natural;
+   begin
+      Block_Address := Null_Address;
+      Count := 0;
+      if D.Device.all.Map_Blocks = null then
+         Success := False;
+         return;
+      end if;
+      Run_Start (D, CCB, Natural (Unsigned_16'Last), Count, Success);
+      if not Success then
+         Count := 0;
+         return;
+      end if;
+      Length := Natural (Count) * Natural (D.Sector_Size);
+      -- writes to a mappable device bypass the cache, so the blocks are
+      -- never stale
+      BlockDevices.Map (
+         D.Device.all,
+         Physical_Sector (D, CCB.Current_Sector),
+         (Length + D.Device.all.Block_Size - 1) / D.Device.all.Block_Size,
+         Block_Address,
+         Success
+         );
+      if Success then
+         CCB.Previous_Sector := CCB.Current_Sector + Sector_Type (Count) - 1;
+         CCB.Current_Sector  := @ + Sector_Type (Count);
+         CCB.IO_Bytes        := @ + Unsigned_32 (Length);
+      else
+         Count := 0;
+      end if;
+   end Map_Cluster;
+
    ----------------------------------------------------------------------------
    -- Reread
    ----------------------------------------------------------------------------
@@ -464,7 +579,7 @@ package body FATFS.Cluster
          Success := False;
          return;
       end if;
-      IDE.Read (D.Device.all, Physical_Sector (D, CCB.Previous_Sector), B, Success);
+      Cache.Read (D, Physical_Sector (D, CCB.Previous_Sector), B, Success);
    end Reread;
 
    ----------------------------------------------------------------------------
@@ -485,7 +600,7 @@ package body FATFS.Cluster
          exit when not Is_Valid (C, D.FAT_Style);
          -- read FAT Sector for current cluster
          Sector := To_Table_Sector (D, C);
-         IDE.Read (D.Device.all, Physical_Sector (D, Sector), B, Success);
+         Cache.Read (D, Physical_Sector (D, Sector), B, Success);
          exit when not Success;
          -- update the FAT Sector entry
          C_Next := Entry_Get (D, B, C);
@@ -527,7 +642,7 @@ package body FATFS.Cluster
          end if;
          -- save write data to the new cluster
          New_Cluster := D.Next_Writable_Cluster;
-         IDE.Write (D.Device.all, Physical_Sector (D, To_Sector (D, New_Cluster)), B, Success);
+         Cache.Write (D, Physical_Sector (D, To_Sector (D, New_Cluster)), B, Success);
          if not Success then
             -- I/O error
             return;
@@ -546,11 +661,11 @@ package body FATFS.Cluster
                        Import     => True,
                        Convention => Ada;
             begin
-               IDE.Read (D.Device.all, Physical_Sector (D, File.Directory_Sector), B, Success);
+               Cache.Read (D, Physical_Sector (D, File.Directory_Sector), B, Success);
                if Success then
                   DI := File.Directory_Index mod 16;
                   Put_First (D, Dir (DI), New_Cluster);
-                  IDE.Write (D.Device.all, Physical_Sector (D, File.Directory_Sector), B, Success);
+                  Cache.Write (D, Physical_Sector (D, File.Directory_Sector), B, Success);
                end if;
             end;
             if Success then
@@ -573,10 +688,10 @@ package body FATFS.Cluster
          -- get next free cluster
          Prelocate (D, B);
          -- restore buffer
-         IDE.Read (D.Device.all, Physical_Sector (D, File.CCB.Current_Sector), B, Success);
+         Cache.Read (D, Physical_Sector (D, File.CCB.Current_Sector), B, Success);
       else
          -- plain write
-         IDE.Write (D.Device.all, Physical_Sector (D, File.CCB.Current_Sector), B, Success);
+         Cache.Write (D, Physical_Sector (D, File.CCB.Current_Sector), B, Success);
          if Success then
             File.CCB.IO_Bytes := File.CCB.IO_Bytes + Unsigned_32 (D.Sector_Size);
          end if;
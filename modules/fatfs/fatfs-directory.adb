@@ -17,6 +17,7 @@
 
 with LLutils;
 with FATFS.Cluster;
+with FATFS.Cache;
 with FATFS.Filename;
 
 package body FATFS.Directory
@@ -230,7 +231,7 @@ package body FATFS.Directory
       Success := True;
       loop
          exit when S > E;
-         IDE.Write (D.Device.all, Physical_Sector (D, S), B, Success);
+         Cache.Write (D, Physical_Sector (D, S), B, Success);
          exit when not Success;
          S := @ + 1;
       end loop;
@@ -585,10 +586,10 @@ package body FATFS.Directory
               Import     => True,
               Convention => Ada;
    begin
-      IDE.Read (D.Device.all, Physical_Sector (D, Sector), B, Success);
+      Cache.Read (D, Physical_Sector (D, Sector), B, Success);
       if Success then
          Dir_Entries (Index mod 16) := DE;
-         IDE.Write (D.Device.all, Physical_Sector (D, Sector), B, Success);
+         Cache.Write (D, Physical_Sector (D, Sector), B, Success);
       end if;
    end Entry_Update;
 
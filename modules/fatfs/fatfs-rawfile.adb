@@ -16,6 +16,7 @@
 -----------------------------------------------------------------------------------------------------------------------
 
 with FATFS.Cluster;
+with FATFS.Cache;
 with FATFS.Directory;
 
 package body FATFS.Rawfile
@@ -170,6 +171,59 @@ package body FATFS.Rawfile
       end if;
    end Read;
 
+   ----------------------------------------------------------------------------
+   -- Read_Cluster
+   ----------------------------------------------------------------------------
+   procedure Read_Cluster
+      (D       : in     Descriptor_Type;
+       File    : in out FCB_Type;
+       B       :    out Block_Type;
+       Count   :    out Unsigned_32;
+       Success :    out Boolean)
+      is
+      Sectors : Unsigned_16;
+   begin
+      Count := 0;
+      if not Is_Valid (File) or else File.CCB.IO_Bytes >= File.Size then
+         Success := False;
+         return;
+      end if;
+      Cluster.Read_Cluster (D, File.CCB, B, Sectors, Success);
+      if Success then
+         Count := Unsigned_32 (Sectors) * Unsigned_32 (D.Sector_Size);
+         if File.CCB.IO_Bytes > File.Size then
+            Count := @ - (File.CCB.IO_Bytes - File.Size);
+         end if;
+      end if;
+   end Read_Cluster;
+
+   ----------------------------------------------------------------------------
+   -- Map
+   ----------------------------------------------------------------------------
+   procedure Map
+      (D            : in     Descriptor_Type;
+       File         : in out FCB_Type;
+       Data_Address :    out Address;
+       Count        :    out Unsigned_32;
+       Success      :    out Boolean)
+      is
+      Sectors : Unsigned_16;
+   begin
+      Data_Address := Null_Address;
+      Count := 0;
+      if not Is_Valid (File) or else File.CCB.IO_Bytes >= File.Size then
+         Success := False;
+         return;
+      end if;
+      Cluster.Map_Cluster (D, File.CCB, Data_Address, Sectors, Success);
+      if Success then
+         Count := Unsigned_32 (Sectors) * Unsigned_32 (D.Sector_Size);
+         if File.CCB.IO_Bytes > File.Size then
+            Count := @ - (File.CCB.IO_Bytes - File.Size);
+         end if;
+      end if;
+   end Map;
+
    ----------------------------------------------------------------------------
    -- Reread
    ----------------------------------------------------------------------------
@@ -322,7 +376,7 @@ package body FATFS.Rawfile
          Success := False;
          return;
       end if;
-      IDE.Write (D.Device.all, Physical_Sector (D, File.CCB.Previous_Sector), B, Success);
+      Cache.Write (D, Physical_Sector (D, File.CCB.Previous_Sector), B, Success);
       if Success then
          File.Last_Sector := Count;
       end if;
@@ -347,7 +401,7 @@ package body FATFS.Rawfile
    ----------------------------------------------------------------------------
    -- Sync
    ----------------------------------------------------------------------------
-   -- Flush all data and close the file.
+   -- Update the directory entry and write back all the cached sectors.
    ----------------------------------------------------------------------------
    procedure Sync
       (D       : in     Descriptor_Type;
@@ -366,7 +420,7 @@ package body FATFS.Rawfile
          return;
       end if;
       -- update file size in directory entry
-      IDE.Read (D.Device.all, Physical_Sector (D, File.Directory_Sector), B, Success);
+      Cache.Read (D, Physical_Sector (D, File.Directory_Sector), B, Success);
       if Success then
          Index := File.Directory_Index mod 16;
          -- __FIX__ endian
@@ -384,7 +438,10 @@ package body FATFS.Rawfile
          else
             DE (Index).Size := File.CCB.IO_Bytes;
          end if;
-         IDE.Write (D.Device.all, Physical_Sector (D, File.Directory_Sector), B, Success);
+         Cache.Write (D, Physical_Sector (D, File.Directory_Sector), B, Success);
+      end if;
+      if Success then
+         Cache.Flush (D, Success);
       end if;
    end Sync;
 
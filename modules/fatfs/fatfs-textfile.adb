@@ -17,6 +17,7 @@
 
 with Definitions;
 with FATFS.Rawfile;
+with FATFS.Cache;
 
 package body FATFS.Textfile
    is
@@ -86,7 +87,7 @@ package body FATFS.Textfile
       Success := Rawfile.Is_Valid (File.WCB);
       if Success then
          if File.Byte_Offset > 0 then
-            IDE.Read (D.Device.all, Physical_Sector (D, File.WCB.CCB.Previous_Sector), B, Success);
+            Cache.Read (D, Physical_Sector (D, File.WCB.CCB.Previous_Sector), B, Success);
          else
             B := [others => 0];
          end if;
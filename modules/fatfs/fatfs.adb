@@ -17,6 +17,7 @@
 
 with LLutils;
 with FATFS.Cluster;
+with FATFS.Cache;
 with Console; -- __FIX__ debug
 
 package body FATFS
@@ -226,7 +227,7 @@ package body FATFS
       Success := False;
       for Index in D.FAT_Start'Range loop
          if D.FAT_Start (Index) /= 0 then
-            IDE.Write (D.Device.all, Physical_Sector (D, D.FAT_Start (Index)) + Offset, B, Success);
+            Cache.Write (D, Physical_Sector (D, D.FAT_Start (Index)) + Offset, B, Success);
             exit when not Success;
          end if;
       end loop;
@@ -326,13 +327,15 @@ package body FATFS
       -------------------------------------------------------------------------
       -- Read FAT bootrecord.
       -------------------------------------------------------------------------
+      -- the medium may have changed since the last Open
+      Cache.Invalidate (D);
       declare
          B : aliased Block_Type (0 .. 511)
             with Address    => Bootrecord'Address,
                  Import     => True,
                  Convention => Ada;
       begin
-         IDE.Read (D.Device.all, Partition_Start, B, Success); -- logical sector #0 in FAT partition
+         Cache.Read (D, Partition_Start, B, Success); -- logical sector #0 in FAT partition
          if BigEndian then
             Swap_Data (B);
          end if;
@@ -439,9 +442,15 @@ package body FATFS
    -- Close
    ----------------------------------------------------------------------------
    procedure Close
-      (D : in out Descriptor_Type)
+      (D       : in out Descriptor_Type;
+       Success :    out Boolean)
       is
    begin
+      Cache.Flush (D, Success);
+      if not Success then
+         return;
+      end if;
+      Cache.Invalidate (D);
       D.FAT_Style := FATNONE;
       D.FAT_Is_Open := False;
    end Close;
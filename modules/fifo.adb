@@ -15,8 +15,6 @@
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
 
-with CPU;
-
 package body FIFO
    is
 
@@ -36,19 +34,8 @@ package body FIFO
        Data    : in     Interfaces.Unsigned_8;
        Success :    out Boolean)
       is
-      Intcontext : CPU.Intcontext_Type;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
-      if Q.all.Count >= QUEUE_SIZE then
-         Success := False;
-      else
-         Q.all.Queue (Natural (Q.all.Head)) := Data;
-         Q.all.Head := @ + 1;
-         Q.all.Count := @ + 1;
-         Success := True;
-      end if;
-      CPU.Intcontext_Set (Intcontext);
+      Byte_Rings.Put (Q, Data, Success);
    end Put;
 
    ----------------------------------------------------------------------------
@@ -59,20 +46,11 @@ package body FIFO
        Data    : out    Interfaces.Unsigned_8;
        Success : out    Boolean)
       is
-      Intcontext : CPU.Intcontext_Type;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
-      if Q.all.Count = 0 then
+      Byte_Rings.Get (Q, Data, Success);
+      if not Success then
          Data := 0;
-         Success := False;
-      else
-         Data := Q.all.Queue (Natural (Q.all.Tail));
-         Q.all.Tail := @ + 1;
-         Q.all.Count := @ - 1;
-         Success := True;
       end if;
-      CPU.Intcontext_Set (Intcontext);
    end Get;
 
 end FIFO;
@@ -45,7 +45,7 @@ package body MBR
    -- Read
    ----------------------------------------------------------------------------
    procedure Read
-      (Device           : in     IDE_Descriptor_Ptr;
+      (Device           : in     Descriptor_Ptr;
        Partition_Number : in     Partition_Number_Type;
        Partition        :    out Partition_Entry_Type;
        Success          :    out Boolean)
@@ -53,7 +53,7 @@ package body MBR
       Block  : aliased Block_Type (0 .. 16#01FF#);
       Offset : Storage_Offset;
    begin
-      IDE.Read (Device.all, 0, Block, Success);
+      BlockDevices.Read (Device.all, 0, Block, Success);
       if Success then
          if Block (16#01FE# .. 16#01FF#) = [16#55#, 16#AA#] then
             case Partition_Number is
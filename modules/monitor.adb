@@ -18,11 +18,13 @@
 with Ada.Characters.Latin_1;
 with System.Storage_Elements;
 with Bits;
+with Malloc;
 with Console;
 with CPU;
 with BSP;
 with Linker;
 with Srecord;
+with Trace;
 
 package body Monitor
    is
@@ -45,6 +47,7 @@ package body Monitor
    Buffer_Idx  : Positive;
 
    procedure Getline;
+   procedure Heap_Dump;
    procedure Help;
    procedure Parameters_Dump;
 
@@ -113,16 +116,51 @@ package body Monitor
       Console.Print (Prefix => "SBss:                  ", Value => Linker.SBss, NL => True);
    end Parameters_Dump;
 
+   ----------------------------------------------------------------------------
+   -- Heap_Dump
+   ----------------------------------------------------------------------------
+   procedure Heap_Dump
+      is
+      Statistics : Malloc.Statistics_Type;
+      Histogram  : Malloc.Histogram_Type;
+      Valid      : Boolean;
+   begin
+      Statistics := Malloc.Statistics;
+      Console.Print (Prefix => "Heap size:          ", Value => Statistics.Heap_Size,          NL => True);
+      Console.Print (Prefix => "Allocations:        ", Value => Statistics.Allocations,        NL => True);
+      Console.Print (Prefix => "Frees:              ", Value => Statistics.Frees,              NL => True);
+      Console.Print (Prefix => "Failures:           ", Value => Statistics.Failures,           NL => True);
+      Console.Print (Prefix => "Bytes in use:       ", Value => Statistics.Bytes_In_Use,       NL => True);
+      Console.Print (Prefix => "Peak bytes in use:  ", Value => Statistics.Peak_Bytes_In_Use,  NL => True);
+      Console.Print (Prefix => "Free blocks:        ", Value => Statistics.Free_Blocks,        NL => True);
+      Console.Print (Prefix => "Largest free block: ", Value => Statistics.Largest_Free_Block, NL => True);
+      Malloc.Heap_Walk (Histogram, Valid);
+      Console.Print ("Free block sizes:", NL => True);
+      for Index in Histogram'Range loop
+         if Histogram (Index) /= 0 then
+            Console.Print (Prefix => "  2**", Value => Index);
+            Console.Print (Prefix => ": ", Value => Histogram (Index), NL => True);
+         end if;
+      end loop;
+      if Valid then
+         Console.Print ("Heap chain:         valid", NL => True);
+      else
+         Console.Print ("Heap chain:         *** CORRUPTED ***", NL => True);
+      end if;
+   end Heap_Dump;
+
    ----------------------------------------------------------------------------
    -- Help
    ----------------------------------------------------------------------------
    procedure Help
       is
    begin
+      Console.Print ("heap    - heap statistics",   NL => True);
       Console.Print ("help    - this help",         NL => True);
       Console.Print ("parms   - parameters dump",   NL => True);
       Console.Print ("srecord - S-record download", NL => True);
       Console.Print ("ticks   - print Tick_Count",  NL => True);
+      Console.Print ("trace   - trace buffer dump", NL => True);
    end Help;
 
    ----------------------------------------------------------------------------
@@ -138,7 +176,10 @@ package body Monitor
          Getline;
          if Buffer_Idx > 1 then
             -----------------------------------
-            if    Buffer (1 .. 4) = "help" then
+            if    Buffer (1 .. 4) = "heap" then
+               Heap_Dump;
+            -----------------------------------
+            elsif Buffer (1 .. 4) = "help" then
                Help;
             --------------------------------------
             elsif Buffer (1 .. 5) = "parms" then
@@ -154,6 +195,9 @@ package body Monitor
             ------------------------------------
             elsif Buffer (1 .. 5) = "ticks" then
                Console.Print (BSP.Tick_Count, NL => True);
+            ------------------------------------
+            elsif Buffer (1 .. 5) = "trace" then
+               Trace.Dump;
             ----
             else
                Console.Print ("*** Error: unrecognized command.", NL => True);
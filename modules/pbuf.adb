@@ -15,6 +15,11 @@
 -- Please consult the LICENSE.txt file located in the top-level directory.                                           --
 -----------------------------------------------------------------------------------------------------------------------
 
+with System.Storage_Elements;
+with Interfaces;
+with GCC.Defines;
+with LLutils;
+with Memory_Functions;
 with CPU;
 
 package body PBUF
@@ -28,15 +33,41 @@ package body PBUF
    --                                                                        --
    --========================================================================--
 
+   use System.Storage_Elements;
+   use Interfaces;
+
+   pragma Compile_Time_Error (PBUF_NUMS >= 2**16, "PBUF_NUMS too large");
+
+   -- The free pbufs form a stack linked through their Next field. The
+   -- stack head is a single word holding the index + 1 of the top pbuf in
+   -- the low half and a generation tag in the high half; every push/pop
+   -- increments the tag, so that a compare-and-exchange cannot succeed
+   -- on a stale head (ABA), and no interrupt masking is needed. CPUs
+   -- without a native 32-bit compare-and-exchange (e.g. M68010) fall back
+   -- to masking interrupts around the head update.
+   HEAD_INDEX_MASK : constant := 16#0000_FFFF#;
+   HEAD_TAG_UNIT   : constant := 16#0001_0000#;
+
    Pool_Memory : array (0 .. PBUF_NUMS - 1) of aliased Pbuf_Type;
 
-   Pool_Pointer : Pbuf_Ptr
+   Pool_Head : aliased Unsigned_32 := 0
       with Volatile => True;
 
    procedure Reset
       (Item : in out Pbuf_Type)
       with Inline => True;
 
+   function Head_Index
+      (P : Pbuf_Ptr)
+      return Unsigned_32
+      with Inline => True;
+
+   function Pop
+      return Pbuf_Ptr;
+
+   procedure Push
+      (P : in Pbuf_Ptr);
+
    function Allocate_Simple
       return Pbuf_Ptr;
 
@@ -61,6 +92,97 @@ package body PBUF
       Item.Offset_Previous := 0;                 -- saved payload starting offset
    end Reset;
 
+   ----------------------------------------------------------------------------
+   -- Head_Index
+   ----------------------------------------------------------------------------
+   -- Encode a pbuf as a stack head index, 0 = empty.
+   ----------------------------------------------------------------------------
+   function Head_Index
+      (P : Pbuf_Ptr)
+      return Unsigned_32
+      is
+   begin
+      if P = null then
+         return 0;
+      else
+         return Unsigned_32 (P.all.Index) + 1;
+      end if;
+   end Head_Index;
+
+   ----------------------------------------------------------------------------
+   -- Pop
+   ----------------------------------------------------------------------------
+   function Pop
+      return Pbuf_Ptr
+      is
+      Old_Head   : Unsigned_32;
+      New_Head   : Unsigned_32;
+      Index      : Unsigned_32;
+      P          : Pbuf_Ptr;
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+         CPU.Intcontext_Get (Intcontext);
+         CPU.Irq_Disable;
+      end if;
+      loop
+         Old_Head := LLutils.Atomic_Load_32 (Pool_Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+         Index := Old_Head and HEAD_INDEX_MASK;
+         if Index = 0 then
+            P := null;
+            exit;
+         end if;
+         P := Pool_Memory (Natural (Index) - 1)'Access;
+         New_Head := ((Old_Head and not HEAD_INDEX_MASK) + HEAD_TAG_UNIT) or Head_Index (P.all.Next);
+         exit when LLutils.Atomic_Compare_Exchange_32 (
+                      Pool_Head'Address,
+                      Old_Head,
+                      New_Head,
+                      GCC.Defines.ATOMIC_ACQ_REL
+                      );
+      end loop;
+      if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+         CPU.Intcontext_Set (Intcontext);
+      end if;
+      return P;
+   end Pop;
+
+   ----------------------------------------------------------------------------
+   -- Push
+   ----------------------------------------------------------------------------
+   procedure Push
+      (P : in Pbuf_Ptr)
+      is
+      Old_Head   : Unsigned_32;
+      New_Head   : Unsigned_32;
+      Index      : Unsigned_32;
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+         CPU.Intcontext_Get (Intcontext);
+         CPU.Irq_Disable;
+      end if;
+      loop
+         Old_Head := LLutils.Atomic_Load_32 (Pool_Head'Address, GCC.Defines.ATOMIC_ACQUIRE);
+         Index := Old_Head and HEAD_INDEX_MASK;
+         if Index = 0 then
+            P.all.Next := null;
+         else
+            P.all.Next := Pool_Memory (Natural (Index) - 1)'Access;
+         end if;
+         New_Head := ((Old_Head and not HEAD_INDEX_MASK) + HEAD_TAG_UNIT) or Head_Index (P);
+         exit when LLutils.Atomic_Compare_Exchange_32 (
+                      Pool_Head'Address,
+                      Old_Head,
+                      New_Head,
+                      GCC.Defines.ATOMIC_ACQ_REL
+                      );
+      end loop;
+      if not GCC.Defines.HAVE_SYNC_COMPARE_AND_SWAP_4 then
+         CPU.Intcontext_Set (Intcontext);
+      end if;
+   end Push;
+
    ----------------------------------------------------------------------------
    -- Init
    ----------------------------------------------------------------------------
@@ -85,7 +207,11 @@ package body PBUF
             end if;
          end;
       end loop;
-      Pool_Pointer := Pool_Memory (Pool_Memory'First)'Access;
+      LLutils.Atomic_Store_32 (
+         Pool_Head'Address,
+         Head_Index (Pool_Memory (Pool_Memory'First)'Access),
+         GCC.Defines.ATOMIC_RELEASE
+         );
    end Init;
 
    ----------------------------------------------------------------------------
@@ -94,22 +220,13 @@ package body PBUF
    function Allocate_Simple
       return Pbuf_Ptr
       is
-      Intcontext : CPU.Intcontext_Type;
-      Result     : Pbuf_Ptr;
+      Result : Pbuf_Ptr;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
-      if Pool_Pointer /= null then
-         declare
-            T_Result : constant not null Pbuf_Ptr := Pool_Pointer;
-         begin
-            Result := T_Result;
-            Pool_Pointer := T_Result.all.Next;          -- update the global pointer
-            T_Result.all.Next := null;                  -- invalidate Next pointer
-            T_Result.all.Nref := T_Result.all.Nref + 1; -- increment reference count
-         end;
+      Result := Pop;
+      if Result /= null then
+         Result.all.Next := null; -- invalidate Next pointer
+         Result.all.Nref := 1;    -- first reference
       end if;
-      CPU.Intcontext_Set (Intcontext);
       return Result;
    end Allocate_Simple;
 
@@ -168,36 +285,129 @@ package body PBUF
    ----------------------------------------------------------------------------
    -- Free
    ----------------------------------------------------------------------------
+   -- Drop a reference to a pbuf chain; every pbuf no more referenced is
+   -- given back to the pool, walking the chain until a pbuf still in use.
+   -- __REF__ src/core/pbuf.c:pbuf_free()
+   ----------------------------------------------------------------------------
    procedure Free
       (Item : in Pbuf_Ptr)
       is
       Intcontext : CPU.Intcontext_Type;
       P          : Pbuf_Ptr;
       Q          : Pbuf_Ptr;
+      Nref       : Natural;
    begin
-      CPU.Intcontext_Get (Intcontext);
-      CPU.Irq_Disable;
       P := Item;
       while P /= null loop
+         CPU.Intcontext_Get (Intcontext);
+         CPU.Irq_Disable;
          P.all.Nref := P.all.Nref - 1;
-         if P.all.Nref = 0 then
-            if P.all.Size = P.all.Total_Size then
-               Q := null;               -- end of pbuf chain
-            else
-               Q := P.all.Next;         -- remember next pbuf in chain
-            end if;
-            Reset (P.all);
-            P.all.Next := Pool_Pointer; -- head-insert
-            Pool_Pointer := P;          -- update global pointer
-            P := Q;                     -- examine next pbuf
+         Nref := P.all.Nref;
+         CPU.Intcontext_Set (Intcontext);
+         -- this pbuf (and so every remaining pbuf in chain) is still
+         -- referenced, stop walking
+         exit when Nref /= 0;
+         Q := P.all.Next; -- remember next pbuf in chain
+         Reset (P.all);
+         Push (P);
+         P := Q;          -- examine next pbuf
+      end loop;
+   end Free;
+
+   ----------------------------------------------------------------------------
+   -- Reference
+   ----------------------------------------------------------------------------
+   -- Add a reference to a pbuf chain, which is then kept alive by Free.
+   -- __REF__ src/core/pbuf.c:pbuf_ref()
+   ----------------------------------------------------------------------------
+   procedure Reference
+      (P : in Pbuf_Ptr)
+      is
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      P.all.Nref := P.all.Nref + 1;
+      CPU.Intcontext_Set (Intcontext);
+   end Reference;
+
+   ----------------------------------------------------------------------------
+   -- Take
+   ----------------------------------------------------------------------------
+   -- Scatter Length bytes from memory into the payloads of a pbuf chain,
+   -- starting at Offset in the packet.
+   -- __REF__ src/core/pbuf.c:pbuf_take_at()
+   ----------------------------------------------------------------------------
+   procedure Take
+      (P              : in Pbuf_Ptr;
+       Source_Address : in System.Address;
+       Length         : in Natural;
+       Offset         : in Natural := 0)
+      is
+      Q         : Pbuf_Ptr;
+      Skip      : Natural;
+      Remaining : Natural;
+      Chunk     : Natural;
+   begin
+      Q := P;
+      Skip := Offset;
+      Remaining := Length;
+      while Q /= null and then Remaining > 0 loop
+         if Skip >= Q.all.Size then
+            -- the whole pbuf lies before Offset
+            Skip := @ - Q.all.Size;
          else
-            -- this pbuf (and so every remaining pbuf in chain) is still
-            -- referenced, stop walking
-            P := null;
+            Chunk := Natural'Min (Remaining, Q.all.Size - Skip);
+            Memory_Functions.Cpymem (
+               Source_Address + Storage_Offset (Length - Remaining),
+               Payload_Address (Q, Q.all.Offset + Skip),
+               Bits.Bytesize (Chunk)
+               );
+            Remaining := @ - Chunk;
+            Skip := 0;
          end if;
+         Q := Q.all.Next;
       end loop;
-      CPU.Intcontext_Set (Intcontext);
-   end Free;
+   end Take;
+
+   ----------------------------------------------------------------------------
+   -- Copy_Partial
+   ----------------------------------------------------------------------------
+   -- Gather Length bytes, starting at Offset in the packet, from the
+   -- payloads of a pbuf chain into memory.
+   -- __REF__ src/core/pbuf.c:pbuf_copy_partial()
+   ----------------------------------------------------------------------------
+   procedure Copy_Partial
+      (P                   : in Pbuf_Ptr;
+       Destination_Address : in System.Address;
+       Length              : in Natural;
+       Offset              : in Natural := 0)
+      is
+      Q         : Pbuf_Ptr;
+      Skip      : Natural;
+      Remaining : Natural;
+      Chunk     : Natural;
+   begin
+      Q := P;
+      Skip := Offset;
+      Remaining := Length;
+      while Q /= null and then Remaining > 0 loop
+         if Skip >= Q.all.Size then
+            -- the whole pbuf lies before Offset
+            Skip := @ - Q.all.Size;
+         else
+            Chunk := Natural'Min (Remaining, Q.all.Size - Skip);
+            Memory_Functions.Cpymem (
+               Payload_Address (Q, Q.all.Offset + Skip),
+               Destination_Address + Storage_Offset (Length - Remaining),
+               Bits.Bytesize (Chunk)
+               );
+            Remaining := @ - Chunk;
+            Skip := 0;
+         end if;
+         Q := Q.all.Next;
+      end loop;
+   end Copy_Partial;
 
    ----------------------------------------------------------------------------
    -- Payload_Adjust
@@ -0,0 +1,761 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ dhcp_client.adb                                                                                           --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System;
+with Bits;
+with PBUF;
+with Timers;
+with Trace;
+with UDP_Sockets;
+
+package body DHCP_Client
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System;
+   use Bits;
+   use PBUF;
+   use Ethernet;
+
+   DHCP_BOOTREQUEST : constant := 1;
+   DHCP_BOOTREPLY   : constant := 2;
+   DHCP_HTYPE_ETH   : constant := 1;
+
+   DHCP_HDR_SIZE : constant := 236;
+   type DHCP_Header_Type is record
+      Op     : Unsigned_8;
+      Htype  : Unsigned_8;
+      Hlen   : Unsigned_8;
+      Hops   : Unsigned_8;
+      Xid    : Unsigned_32;
+      Secs   : Unsigned_16;
+      Flags  : Unsigned_16;
+      Ciaddr : IPv4_Address_Type;    -- client address, RENEWING/REBINDING only
+      Yiaddr : IPv4_Address_Type;    -- "your" address
+      Siaddr : IPv4_Address_Type;
+      Giaddr : IPv4_Address_Type;
+      Chaddr : Byte_Array (0 .. 15); -- client hardware address
+      Sname  : Byte_Array (0 .. 63);
+      File   : Byte_Array (0 .. 127);
+   end record
+      with Alignment => 4,
+           Size      => DHCP_HDR_SIZE * Storage_Unit;
+   for DHCP_Header_Type use record
+      Op     at   0 range 0 ..    7;
+      Htype  at   1 range 0 ..    7;
+      Hlen   at   2 range 0 ..    7;
+      Hops   at   3 range 0 ..    7;
+      Xid    at   4 range 0 ..   31;
+      Secs   at   8 range 0 ..   15;
+      Flags  at  10 range 0 ..   15;
+      Ciaddr at  12 range 0 ..   31;
+      Yiaddr at  16 range 0 ..   31;
+      Siaddr at  20 range 0 ..   31;
+      Giaddr at  24 range 0 ..   31;
+      Chaddr at  28 range 0 ..  127;
+      Sname  at  44 range 0 ..  511;
+      File   at 108 range 0 .. 1023;
+   end record;
+
+   DHCP_MAGIC_COOKIE : constant Byte_Array (0 .. 3) := [99, 130, 83, 99];
+   DHCP_OPTIONS      : constant := DHCP_HDR_SIZE + DHCP_MAGIC_COOKIE'Length;
+
+   DHCP_MSG_SIZE : constant := 300; -- sent, BOOTP minimum
+   DHCP_RX_SIZE  : constant := 576; -- received, RFC 2131 minimum
+
+   -- RFC 2132 9.6 message types
+   DHCPDISCOVER : constant := 1;
+   DHCPOFFER    : constant := 2;
+   DHCPREQUEST  : constant := 3;
+   DHCPACK      : constant := 5;
+   DHCPNAK      : constant := 6;
+
+   -- RFC 2132 options
+   OPTION_PAD            : constant := 0;
+   OPTION_SUBNET_MASK    : constant := 1;
+   OPTION_ROUTER         : constant := 3;
+   OPTION_REQUESTED_ADDR : constant := 50;
+   OPTION_LEASE_TIME     : constant := 51;
+   OPTION_MESSAGE_TYPE   : constant := 53;
+   OPTION_SERVER_ID      : constant := 54;
+   OPTION_PARAMETER_LIST : constant := 55;
+   OPTION_RENEWAL_TIME   : constant := 58;
+   OPTION_REBINDING_TIME : constant := 59;
+   OPTION_END            : constant := 255;
+
+   DHCP_RTX_MIN         : constant := 4;  -- s, first retransmission
+   DHCP_RTX_MAX         : constant := 64; -- s
+   DHCP_REQUEST_RETRIES : constant := 4;  -- REQUESTING/REBOOTING attempts
+   DHCP_RENEW_MIN       : constant := 60; -- s, RENEWING/REBINDING retransmission
+
+   BROADCAST_ADDRESS : constant IPv4_Address_Type := [255, 255, 255, 255];
+   ZERO_ADDRESS      : constant IPv4_Address_Type := [0, 0, 0, 0];
+
+   type Reply_Type is record
+      Message_Type : Unsigned_8;
+      Yiaddr       : IPv4_Address_Type;
+      Netmask      : IPv4_Address_Type;
+      Gateway      : IPv4_Address_Type;
+      Server       : IPv4_Address_Type;
+      Lease_Time   : Unsigned_32;
+      T1           : Unsigned_32;       -- 0 = not given
+      T2           : Unsigned_32;       -- 0 = not given
+   end record;
+
+   Client_State  : State_Type := STOPPED;
+   Interface_Id  : Interface_Id_Type := NO_INTERFACE;
+   Socket        : UDP_Sockets.Socket_Type := UDP_Sockets.NO_SOCKET;
+   Lease_Save    : Lease_Save_Ptr := null;
+   Current_Lease : Lease_Type := LEASE_INVALID;           -- address in use
+   Offered       : IPv4_Address_Type := ZERO_ADDRESS;     -- REQUESTING
+   Offer_Server  : IPv4_Address_Type := ZERO_ADDRESS;     -- REQUESTING
+   Xid           : Unsigned_32 := 0;
+   Random_State  : Unsigned_32 := 1;
+   Retries       : Natural := 0;
+   Rtx_Timeout   : Unsigned_32 := DHCP_RTX_MIN;
+   Rtx_Deadline  : Unsigned_32 := 0;
+   T1_Deadline   : Unsigned_32 := 0;
+   T2_Deadline   : Unsigned_32 := 0;
+   Lease_End     : Unsigned_32 := 0;
+   Infinite      : Boolean := False;
+
+   TX_Buffer : aliased Byte_Array (0 .. DHCP_MSG_SIZE - 1)
+      with Alignment => 4;
+   RX_Buffer : aliased Byte_Array (0 .. DHCP_RX_SIZE - 1)
+      with Alignment => 4;
+
+   DHCP_Clock : aliased Timers.Periodic_Type;
+
+   function Random
+      return Unsigned_32;
+   function To_U32
+      (B     : Byte_Array;
+       Index : Natural)
+      return Unsigned_32
+      with Inline => True;
+   function To_U32
+      (A : IPv4_Address_Type)
+      return Unsigned_32
+      with Inline => True;
+   procedure Rtx_Arm
+      (First : in Boolean);
+   procedure Renew_Arm
+      (Deadline : in Unsigned_32);
+   procedure Message_Send
+      (Message_Type : in Unsigned_8;
+       Dst_Address  : in IPv4_Address_Type);
+   procedure Reply_Parse
+      (Length  : in     Natural;
+       Reply   :    out Reply_Type;
+       Success :    out Boolean);
+   procedure Configure
+      (Lease : in Lease_Type);
+   procedure Unconfigure;
+   procedure Deadlines_Set
+      (Lease_Time : in Unsigned_32;
+       T1         : in Unsigned_32;
+       T2         : in Unsigned_32);
+   procedure Discover_Start;
+   procedure Bind
+      (Reply : in Reply_Type);
+   procedure Lease_Drop;
+   procedure Reply_Process
+      (Reply : in Reply_Type);
+   procedure Timeout_Process;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Random
+   ----------------------------------------------------------------------------
+   -- Numerical Recipes LCG, good enough for xids and backoff jitter.
+   ----------------------------------------------------------------------------
+   function Random
+      return Unsigned_32
+      is
+   begin
+      Random_State := Random_State * 1_664_525 + 1_013_904_223;
+      return Random_State;
+   end Random;
+
+   ----------------------------------------------------------------------------
+   -- To_U32
+   ----------------------------------------------------------------------------
+   function To_U32
+      (B     : Byte_Array;
+       Index : Natural)
+      return Unsigned_32
+      is
+   begin
+      return Shift_Left (Unsigned_32 (B (Index + 0)), 24) or
+             Shift_Left (Unsigned_32 (B (Index + 1)), 16) or
+             Shift_Left (Unsigned_32 (B (Index + 2)),  8) or
+             Unsigned_32 (B (Index + 3));
+   end To_U32;
+
+   function To_U32
+      (A : IPv4_Address_Type)
+      return Unsigned_32
+      is
+   begin
+      return To_U32 (A, A'First);
+   end To_U32;
+
+   ----------------------------------------------------------------------------
+   -- Rtx_Arm
+   ----------------------------------------------------------------------------
+   -- RFC 2131 4.1: exponential backoff from 4 s up to 64 s, randomized by
+   -- +/- 1 s.
+   ----------------------------------------------------------------------------
+   procedure Rtx_Arm
+      (First : in Boolean)
+      is
+   begin
+      if First then
+         Rtx_Timeout := DHCP_RTX_MIN;
+      else
+         Rtx_Timeout := Unsigned_32'Min (Rtx_Timeout * 2, DHCP_RTX_MAX);
+      end if;
+      Rtx_Deadline := DHCP_Clock.Count + Rtx_Timeout - 1 + Random mod 3;
+   end Rtx_Arm;
+
+   ----------------------------------------------------------------------------
+   -- Renew_Arm
+   ----------------------------------------------------------------------------
+   -- RFC 2131 4.4.5: in RENEWING and REBINDING, wait one half of the time
+   -- left until Deadline, at least DHCP_RENEW_MIN seconds.
+   ----------------------------------------------------------------------------
+   procedure Renew_Arm
+      (Deadline : in Unsigned_32)
+      is
+      Clock : constant Unsigned_32 := DHCP_Clock.Count;
+   begin
+      if Timers.Expired (Deadline, Clock) then
+         Rtx_Deadline := Clock + DHCP_RENEW_MIN;
+      else
+         Rtx_Deadline := Clock + Unsigned_32'Max ((Deadline - Clock) / 2, DHCP_RENEW_MIN);
+      end if;
+   end Renew_Arm;
+
+   ----------------------------------------------------------------------------
+   -- Message_Send
+   ----------------------------------------------------------------------------
+   -- Build a DHCPDISCOVER or DHCPREQUEST suitable for the current state and
+   -- send it to Dst_Address.
+   ----------------------------------------------------------------------------
+   procedure Message_Send
+      (Message_Type : in Unsigned_8;
+       Dst_Address  : in IPv4_Address_Type)
+      is
+      DHCP_Header : aliased DHCP_Header_Type
+         with Address    => TX_Buffer'Address,
+              Import     => True,
+              Convention => Ada;
+      Index       : Natural := DHCP_OPTIONS;
+      Success     : Boolean;
+      procedure Option_Put
+         (Code  : in Unsigned_8;
+          Value : in Byte_Array);
+      procedure Option_Put
+         (Code  : in Unsigned_8;
+          Value : in Byte_Array)
+         is
+      begin
+         TX_Buffer (Index)     := Code;
+         TX_Buffer (Index + 1) := Value'Length;
+         TX_Buffer (Index + 2 .. Index + 1 + Value'Length) := Value;
+         Index := @ + 2 + Value'Length;
+      end Option_Put;
+   begin
+      TX_Buffer := [others => 0];
+      DHCP_Header.Op    := DHCP_BOOTREQUEST;
+      DHCP_Header.Htype := DHCP_HTYPE_ETH;
+      DHCP_Header.Hlen  := MAC_Address_Type'Length;
+      DHCP_Header.Xid   := HToN (Xid);
+      if Client_State = RENEWING or else Client_State = REBINDING then
+         DHCP_Header.Ciaddr := Current_Lease.Address;
+      end if;
+      DHCP_Header.Chaddr (0 .. 5) := Byte_Array (Descriptor_Get (Interface_Id).Haddress);
+      TX_Buffer (DHCP_HDR_SIZE .. DHCP_OPTIONS - 1) := DHCP_MAGIC_COOKIE;
+      Option_Put (OPTION_MESSAGE_TYPE, [Message_Type]);
+      case Client_State is
+         when REQUESTING =>
+            Option_Put (OPTION_REQUESTED_ADDR, Offered);
+            Option_Put (OPTION_SERVER_ID, Offer_Server);
+         when REBOOTING =>
+            Option_Put (OPTION_REQUESTED_ADDR, Current_Lease.Address);
+         when others =>
+            null;
+      end case;
+      Option_Put (
+         OPTION_PARAMETER_LIST,
+         [OPTION_SUBNET_MASK, OPTION_ROUTER, OPTION_LEASE_TIME, OPTION_SERVER_ID, OPTION_RENEWAL_TIME, OPTION_REBINDING_TIME]
+         );
+      TX_Buffer (Index) := OPTION_END;
+      Trace.Event (Trace.LEVEL_DEBUG, Trace.DHCP_SEND, Unsigned_32 (Message_Type), Xid);
+      UDP_Sockets.Send_To (Socket, Dst_Address, DHCP_SERVER_PORT, TX_Buffer'Address, DHCP_MSG_SIZE, Success);
+   end Message_Send;
+
+   ----------------------------------------------------------------------------
+   -- Reply_Parse
+   ----------------------------------------------------------------------------
+   -- Validate the BOOTREPLY of Length bytes in RX_Buffer and extract the
+   -- options the client uses.
+   ----------------------------------------------------------------------------
+   procedure Reply_Parse
+      (Length  : in     Natural;
+       Reply   :    out Reply_Type;
+       Success :    out Boolean)
+      is
+      DHCP_Header : aliased DHCP_Header_Type
+         with Address    => RX_Buffer'Address,
+              Import     => True,
+              Convention => Ada;
+      Index       : Natural;
+      Code        : Unsigned_8;
+      Option_Size : Natural;
+   begin
+      Reply := (
+         Message_Type => 0,
+         Yiaddr       => ZERO_ADDRESS,
+         Netmask      => ZERO_ADDRESS,
+         Gateway      => ZERO_ADDRESS,
+         Server       => ZERO_ADDRESS,
+         Lease_Time   => 0,
+         T1           => 0,
+         T2           => 0
+         );
+      Success := False;
+      if Length < DHCP_OPTIONS                                                              or else
+         DHCP_Header.Op /= DHCP_BOOTREPLY                                                   or else
+         NToH (DHCP_Header.Xid) /= Xid                                                      or else
+         DHCP_Header.Chaddr (0 .. 5) /= Byte_Array (Descriptor_Get (Interface_Id).Haddress) or else
+         RX_Buffer (DHCP_HDR_SIZE .. DHCP_OPTIONS - 1) /= DHCP_MAGIC_COOKIE
+      then
+         return;
+      end if;
+      Reply.Yiaddr := DHCP_Header.Yiaddr;
+      Index := DHCP_OPTIONS;
+      while Index < Length loop
+         Code := RX_Buffer (Index);
+         exit when Code = OPTION_END;
+         if Code = OPTION_PAD then
+            Index := @ + 1;
+         else
+            exit when Index + 1 >= Length;
+            Option_Size := Natural (RX_Buffer (Index + 1));
+            exit when Index + 2 + Option_Size > Length;
+            case Code is
+               when OPTION_MESSAGE_TYPE =>
+                  if Option_Size >= 1 then
+                     Reply.Message_Type := RX_Buffer (Index + 2);
+                  end if;
+               when OPTION_SUBNET_MASK =>
+                  if Option_Size >= 4 then
+                     Reply.Netmask := RX_Buffer (Index + 2 .. Index + 5);
+                  end if;
+               when OPTION_ROUTER =>
+                  -- a list, the first router is preferred
+                  if Option_Size >= 4 then
+                     Reply.Gateway := RX_Buffer (Index + 2 .. Index + 5);
+                  end if;
+               when OPTION_SERVER_ID =>
+                  if Option_Size >= 4 then
+                     Reply.Server := RX_Buffer (Index + 2 .. Index + 5);
+                  end if;
+               when OPTION_LEASE_TIME =>
+                  if Option_Size >= 4 then
+                     Reply.Lease_Time := To_U32 (RX_Buffer, Index + 2);
+                  end if;
+               when OPTION_RENEWAL_TIME =>
+                  if Option_Size >= 4 then
+                     Reply.T1 := To_U32 (RX_Buffer, Index + 2);
+                  end if;
+               when OPTION_REBINDING_TIME =>
+                  if Option_Size >= 4 then
+                     Reply.T2 := To_U32 (RX_Buffer, Index + 2);
+                  end if;
+               when others =>
+                  null;
+            end case;
+            Index := @ + 2 + Option_Size;
+         end if;
+      end loop;
+      if Reply.Netmask = ZERO_ADDRESS then
+         -- RFC 1122 3.3.1.1: fall back to the mask of the address class
+         if Reply.Yiaddr (0) < 128 then
+            Reply.Netmask := [255, 0, 0, 0];
+         elsif Reply.Yiaddr (0) < 192 then
+            Reply.Netmask := [255, 255, 0, 0];
+         else
+            Reply.Netmask := [255, 255, 255, 0];
+         end if;
+      end if;
+      Trace.Event (Trace.LEVEL_DEBUG, Trace.DHCP_RECEIVE, Unsigned_32 (Reply.Message_Type), Xid);
+      -- an ACK without lease time is useless
+      Success := Reply.Message_Type /= 0 and then
+                 (Reply.Message_Type /= DHCPACK or else Reply.Lease_Time /= 0);
+   end Reply_Parse;
+
+   ----------------------------------------------------------------------------
+   -- Configure
+   ----------------------------------------------------------------------------
+   -- Put the address of Lease in use on the interface, with its default
+   -- route.
+   ----------------------------------------------------------------------------
+   procedure Configure
+      (Lease : in Lease_Type)
+      is
+      Success : Boolean;
+   begin
+      Address_Set (Interface_Id, Lease.Address, Lease.Netmask);
+      Route_Delete (ZERO_ADDRESS, ZERO_ADDRESS, Interface_Id);
+      if Lease.Gateway /= ZERO_ADDRESS then
+         Route_Add (ZERO_ADDRESS, ZERO_ADDRESS, Lease.Gateway, Interface_Id, Success);
+      end if;
+   end Configure;
+
+   ----------------------------------------------------------------------------
+   -- Unconfigure
+   ----------------------------------------------------------------------------
+   procedure Unconfigure
+      is
+   begin
+      Route_Delete (ZERO_ADDRESS, ZERO_ADDRESS, Interface_Id);
+      Address_Set (Interface_Id, ZERO_ADDRESS, ZERO_ADDRESS);
+   end Unconfigure;
+
+   ----------------------------------------------------------------------------
+   -- Deadlines_Set
+   ----------------------------------------------------------------------------
+   -- RFC 2131 4.4.5: T1 defaults to 0.5 and T2 to 0.875 times the lease.
+   ----------------------------------------------------------------------------
+   procedure Deadlines_Set
+      (Lease_Time : in Unsigned_32;
+       T1         : in Unsigned_32;
+       T2         : in Unsigned_32)
+      is
+      Clock : constant Unsigned_32 := DHCP_Clock.Count;
+   begin
+      Infinite := Lease_Time = LEASE_INFINITE;
+      if Infinite then
+         return;
+      end if;
+      Lease_End   := Clock + Lease_Time;
+      T1_Deadline := Clock + (if T1 /= 0 and then T1 < Lease_Time then T1 else Lease_Time / 2);
+      T2_Deadline := Clock + (if T2 /= 0 and then T2 < Lease_Time then T2 else Lease_Time - Lease_Time / 8);
+   end Deadlines_Set;
+
+   ----------------------------------------------------------------------------
+   -- Discover_Start
+   ----------------------------------------------------------------------------
+   procedure Discover_Start
+      is
+   begin
+      Xid := Random;
+      Client_State := SELECTING;
+      Message_Send (DHCPDISCOVER, BROADCAST_ADDRESS);
+      Rtx_Arm (First => True);
+   end Discover_Start;
+
+   ----------------------------------------------------------------------------
+   -- Bind
+   ----------------------------------------------------------------------------
+   -- DHCPACK received: put the lease in use and save it if it changed.
+   ----------------------------------------------------------------------------
+   procedure Bind
+      (Reply : in Reply_Type)
+      is
+      Lease : Lease_Type;
+   begin
+      Lease := (
+         Magic      => LEASE_MAGIC,
+         Haddress   => Descriptor_Get (Interface_Id).Haddress,
+         Address    => Reply.Yiaddr,
+         Netmask    => Reply.Netmask,
+         Gateway    => Reply.Gateway,
+         Server     => Reply.Server,
+         Lease_Time => Reply.Lease_Time
+         );
+      if Lease.Server = ZERO_ADDRESS then
+         Lease.Server := (if Client_State = REQUESTING then Offer_Server else Current_Lease.Server);
+      end if;
+      if Lease.Address /= Current_Lease.Address or else
+         Lease.Netmask /= Current_Lease.Netmask or else
+         Lease.Gateway /= Current_Lease.Gateway
+      then
+         Configure (Lease);
+      end if;
+      if Lease /= Current_Lease then
+         Current_Lease := Lease;
+         if Lease_Save /= null then
+            Lease_Save.all (Current_Lease);
+         end if;
+      end if;
+      Deadlines_Set (Reply.Lease_Time, Reply.T1, Reply.T2);
+      Client_State := BOUND;
+      Trace.Event (Trace.LEVEL_INFO, Trace.DHCP_BOUND, To_U32 (Lease.Address), Lease.Lease_Time);
+   end Bind;
+
+   ----------------------------------------------------------------------------
+   -- Lease_Drop
+   ----------------------------------------------------------------------------
+   -- DHCPNAK received or lease expired: stop using the address and start
+   -- over.
+   ----------------------------------------------------------------------------
+   procedure Lease_Drop
+      is
+   begin
+      if Current_Lease.Magic = LEASE_MAGIC then
+         Trace.Event (Trace.LEVEL_INFO, Trace.DHCP_EXPIRED, To_U32 (Current_Lease.Address));
+         Unconfigure;
+         Current_Lease := LEASE_INVALID;
+         if Lease_Save /= null then
+            Lease_Save.all (Current_Lease);
+         end if;
+      end if;
+      Discover_Start;
+   end Lease_Drop;
+
+   ----------------------------------------------------------------------------
+   -- Reply_Process
+   ----------------------------------------------------------------------------
+   procedure Reply_Process
+      (Reply : in Reply_Type)
+      is
+   begin
+      case Client_State is
+         when SELECTING =>
+            -- take the first offer
+            if Reply.Message_Type = DHCPOFFER and then Reply.Server /= ZERO_ADDRESS then
+               Offered      := Reply.Yiaddr;
+               Offer_Server := Reply.Server;
+               Client_State := REQUESTING;
+               Retries      := 0;
+               Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+               Rtx_Arm (First => True);
+            end if;
+         when REQUESTING | REBOOTING | RENEWING | REBINDING =>
+            if Reply.Message_Type = DHCPACK then
+               Bind (Reply);
+            elsif Reply.Message_Type = DHCPNAK then
+               Lease_Drop;
+            end if;
+         when others =>
+            null;
+      end case;
+   end Reply_Process;
+
+   ----------------------------------------------------------------------------
+   -- Timeout_Process
+   ----------------------------------------------------------------------------
+   procedure Timeout_Process
+      is
+      Clock : constant Unsigned_32 := DHCP_Clock.Count;
+   begin
+      case Client_State is
+         when SELECTING =>
+            if Timers.Expired (Rtx_Deadline, Clock) then
+               Message_Send (DHCPDISCOVER, BROADCAST_ADDRESS);
+               Rtx_Arm (First => False);
+            end if;
+         when REQUESTING =>
+            if Timers.Expired (Rtx_Deadline, Clock) then
+               Retries := @ + 1;
+               if Retries = DHCP_REQUEST_RETRIES then
+                  Discover_Start;
+               else
+                  Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+                  Rtx_Arm (First => False);
+               end if;
+            end if;
+         when REBOOTING =>
+            if Timers.Expired (Rtx_Deadline, Clock) then
+               Retries := @ + 1;
+               if Retries = DHCP_REQUEST_RETRIES then
+                  -- no server around: keep the cached lease, as if it had
+                  -- been granted now, and try to renew it at T1
+                  Deadlines_Set (Current_Lease.Lease_Time, 0, 0);
+                  Client_State := BOUND;
+               else
+                  Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+                  Rtx_Arm (First => False);
+               end if;
+            end if;
+         when BOUND =>
+            if not Infinite and then Timers.Expired (T1_Deadline, Clock) then
+               Xid := Random;
+               Client_State := RENEWING;
+               Message_Send (DHCPREQUEST, Current_Lease.Server);
+               Renew_Arm (T2_Deadline);
+            end if;
+         when RENEWING =>
+            if Timers.Expired (T2_Deadline, Clock) then
+               Client_State := REBINDING;
+               Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+               Renew_Arm (Lease_End);
+            elsif Timers.Expired (Rtx_Deadline, Clock) then
+               Message_Send (DHCPREQUEST, Current_Lease.Server);
+               Renew_Arm (T2_Deadline);
+            end if;
+         when REBINDING =>
+            if Timers.Expired (Lease_End, Clock) then
+               Lease_Drop;
+            elsif Timers.Expired (Rtx_Deadline, Clock) then
+               Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+               Renew_Arm (Lease_End);
+            end if;
+         when others =>
+            null;
+      end case;
+   end Timeout_Process;
+
+   ----------------------------------------------------------------------------
+   -- Timer_Start
+   ----------------------------------------------------------------------------
+   procedure Timer_Start
+      (Period : in Unsigned_32)
+      is
+   begin
+      Timers.Periodic_Start (DHCP_Clock'Access, Period);
+   end Timer_Start;
+
+   ----------------------------------------------------------------------------
+   -- Start
+   ----------------------------------------------------------------------------
+   procedure Start
+      (Id      : in     Valid_Interface_Id_Type;
+       Lease   : in     Lease_Type;
+       Save    : in     Lease_Save_Ptr;
+       Success :    out Boolean)
+      is
+      Haddress : constant MAC_Address_Type := Descriptor_Get (Id).Haddress;
+   begin
+      if Client_State /= STOPPED then
+         Stop;
+      end if;
+      UDP_Sockets.Bind (DHCP_CLIENT_PORT, Socket);
+      if Socket = UDP_Sockets.NO_SOCKET then
+         Success := False;
+         return;
+      end if;
+      Interface_Id := Id;
+      Lease_Save   := Save;
+      -- different NICs must not draw the same xids
+      for Value of Haddress loop
+         Random_State := @ * 31 + Unsigned_32 (Value);
+      end loop;
+      Random_State := @ + DHCP_Clock.Count;
+      -- the broadcasts of the client leave through this interface
+      Route_Add (BROADCAST_ADDRESS, BROADCAST_ADDRESS, ZERO_ADDRESS, Id, Success);
+      if Lease.Magic = LEASE_MAGIC and then Lease.Haddress = Haddress then
+         -- fast path: use the cached lease at once, confirm it meanwhile
+         Current_Lease := Lease;
+         Configure (Current_Lease);
+         Xid          := Random;
+         Client_State := REBOOTING;
+         Retries      := 0;
+         Message_Send (DHCPREQUEST, BROADCAST_ADDRESS);
+         Rtx_Arm (First => True);
+      else
+         Current_Lease := LEASE_INVALID;
+         Unconfigure;
+         Discover_Start;
+      end if;
+      Success := True;
+   end Start;
+
+   ----------------------------------------------------------------------------
+   -- Stop
+   ----------------------------------------------------------------------------
+   procedure Stop
+      is
+   begin
+      if Client_State = STOPPED then
+         return;
+      end if;
+      Route_Delete (BROADCAST_ADDRESS, BROADCAST_ADDRESS, Interface_Id);
+      UDP_Sockets.Close (Socket);
+      Socket       := UDP_Sockets.NO_SOCKET;
+      Client_State := STOPPED;
+   end Stop;
+
+   ----------------------------------------------------------------------------
+   -- State
+   ----------------------------------------------------------------------------
+   function State
+      return State_Type
+      is
+   begin
+      return Client_State;
+   end State;
+
+   ----------------------------------------------------------------------------
+   -- Is_Configured
+   ----------------------------------------------------------------------------
+   function Is_Configured
+      return Boolean
+      is
+   begin
+      return Current_Lease.Magic = LEASE_MAGIC;
+   end Is_Configured;
+
+   ----------------------------------------------------------------------------
+   -- Service
+   ----------------------------------------------------------------------------
+   procedure Service
+      is
+      P       : Pbuf_Ptr;
+      Length  : Natural;
+      Address : IPv4_Address_Type;
+      Port    : Unsigned_16;
+      Success : Boolean;
+      Reply   : Reply_Type;
+   begin
+      if Client_State = STOPPED then
+         return;
+      end if;
+      loop
+         UDP_Sockets.Receive_From (Socket, P, Length, Address, Port, Success);
+         exit when not Success;
+         Length := Natural'Min (Length, RX_Buffer'Length);
+         Copy_Partial (P, RX_Buffer'Address, Length);
+         Free (P);
+         if Port = DHCP_SERVER_PORT then
+            Reply_Parse (Length, Reply, Success);
+            if Success then
+               Reply_Process (Reply);
+            end if;
+         end if;
+      end loop;
+      Timeout_Process;
+   end Service;
+
+end DHCP_Client;
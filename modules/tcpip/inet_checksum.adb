@@ -0,0 +1,211 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ inet_checksum.adb                                                                                         --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Storage_Elements;
+with Bits;
+
+package body INET_Checksum
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System.Storage_Elements;
+
+   function Byte_Word
+      (Data_Address : Address)
+      return Unsigned_16
+      with Inline => True;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Byte_Word
+   ----------------------------------------------------------------------------
+   -- The byte at Data_Address as the first byte of a zero-padded word.
+   ----------------------------------------------------------------------------
+   function Byte_Word
+      (Data_Address : Address)
+      return Unsigned_16
+      is
+      Data   : Unsigned_8
+         with Address    => Data_Address,
+              Import     => True,
+              Convention => Ada;
+      Word   : aliased Bits.Byte_A2Array (0 .. 1) := [Data, 0];
+      Result : Unsigned_16
+         with Address    => Word'Address,
+              Import     => True,
+              Convention => Ada;
+   begin
+      return Result;
+   end Byte_Word;
+
+   ----------------------------------------------------------------------------
+   -- Sum
+   ----------------------------------------------------------------------------
+   function Sum
+      (Data_Address : Address;
+       Length       : Natural;
+       Initial      : Sum_Type := 0)
+      return Sum_Type
+      is
+      Result : Sum_Type := Initial;
+      Index  : Address  := Data_Address;
+      Count  : Natural  := Length;
+   begin
+      if Count = 0 then
+         return Result;
+      end if;
+      if To_Integer (Index) mod 2 /= 0 then
+         -- odd start: the rest of the data is summed one byte off, and its
+         -- folded sum swapped back into place
+         return Result +
+                Sum_Type (Byte_Word (Index)) +
+                Sum_Type (Bits.Byte_Swap_16 (Fold (Sum (Index + 1, Count - 1))));
+      end if;
+      if To_Integer (Index) mod 4 /= 0 and then Count >= 2 then
+         declare
+            Data : Unsigned_16
+               with Address    => Index,
+                    Import     => True,
+                    Convention => Ada;
+         begin
+            Result := @ + Sum_Type (Data);
+         end;
+         Index := @ + 2;
+         Count := @ - 2;
+      end if;
+      -- main loop, 8 bytes per step, carries accumulate in the upper half
+      while Count >= 8 loop
+         declare
+            Data : Bits.U32_Array (0 .. 1)
+               with Address    => Index,
+                    Import     => True,
+                    Convention => Ada;
+         begin
+            Result := @ + Sum_Type (Data (0)) + Sum_Type (Data (1));
+         end;
+         Index := @ + 8;
+         Count := @ - 8;
+      end loop;
+      while Count >= 2 loop
+         declare
+            Data : Unsigned_16
+               with Address    => Index,
+                    Import     => True,
+                    Convention => Ada;
+         begin
+            Result := @ + Sum_Type (Data);
+         end;
+         Index := @ + 2;
+         Count := @ - 2;
+      end loop;
+      if Count /= 0 then
+         Result := @ + Sum_Type (Byte_Word (Index));
+      end if;
+      return Result;
+   end Sum;
+
+   ----------------------------------------------------------------------------
+   -- Sum
+   ----------------------------------------------------------------------------
+   function Sum
+      (P       : Pbuf_Ptr;
+       Length  : Natural;
+       Initial : Sum_Type := 0)
+      return Sum_Type
+      is
+      Result : Sum_Type := Initial;
+      Q      : Pbuf_Ptr := P;
+      Count  : Natural  := Length;
+      Chunk  : Natural;
+      Block  : Unsigned_16;
+      Odd    : Boolean  := False;
+   begin
+      while Q /= null and then Count /= 0 loop
+         Chunk := Natural'Min (Count, Q.all.Size);
+         Block := Fold (Sum (Payload_CurrentAddress (Q), Chunk));
+         if Odd then
+            -- this pbuf starts in the middle of a 16-bit word
+            Block := Bits.Byte_Swap_16 (Block);
+         end if;
+         Result := @ + Sum_Type (Block);
+         Odd := Odd xor (Chunk mod 2 /= 0);
+         Count := @ - Chunk;
+         Q := Q.all.Next;
+      end loop;
+      return Result;
+   end Sum;
+
+   ----------------------------------------------------------------------------
+   -- Fold
+   ----------------------------------------------------------------------------
+   function Fold
+      (Value : Sum_Type)
+      return Unsigned_16
+      is
+      Result : Sum_Type := Value;
+   begin
+      while Shift_Right (Result, 16) /= 0 loop
+         Result := (Result and 16#FFFF#) + Shift_Right (Result, 16);
+      end loop;
+      return Unsigned_16 (Result);
+   end Fold;
+
+   ----------------------------------------------------------------------------
+   -- Finalize
+   ----------------------------------------------------------------------------
+   function Finalize
+      (Value : Sum_Type)
+      return Unsigned_16
+      is
+   begin
+      return not Fold (Value);
+   end Finalize;
+
+   ----------------------------------------------------------------------------
+   -- Update
+   ----------------------------------------------------------------------------
+   -- HC' = ~(~HC + ~m + m')
+   ----------------------------------------------------------------------------
+   function Update
+      (Checksum : Unsigned_16;
+       Old_Sum  : Sum_Type;
+       New_Sum  : Sum_Type)
+      return Unsigned_16
+      is
+   begin
+      return Finalize (
+                Sum_Type (not Checksum)       +
+                Sum_Type (not Fold (Old_Sum)) +
+                Sum_Type (Fold (New_Sum))
+                );
+   end Update;
+
+end INET_Checksum;
@@ -0,0 +1,446 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ ipv4_fragments.adb                                                                                        --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System;
+with System.Storage_Elements;
+with Bits;
+with CPU;
+with Pools;
+with Timers;
+with Trace;
+with INET_Checksum;
+with Ethernet;
+
+package body IPv4_Fragments
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System;
+   use System.Storage_Elements;
+   use Bits;
+   use INET_Checksum;
+
+   type Fragment_Type is record
+      P      : Pbuf_Ptr := null; -- chain trimmed to the fragment
+      Offset : Natural  := 0;    -- data offset in the datagram
+      Length : Natural  := 0;    -- data length
+   end record;
+
+   subtype Fragment_Index_Type is Positive range 1 .. IPv4_REASM_NFRAGMENTS;
+
+   type Fragment_Array is array (Fragment_Index_Type) of Fragment_Type;
+
+   type Datagram_Type;
+
+   type Datagram_Ptr is access all Datagram_Type;
+
+   type Datagram_Type is record
+      Next           : Datagram_Ptr      := null;   -- in-flight list
+      Src_Address    : IPv4_Address_Type := [others => 0];
+      Dst_Address    : IPv4_Address_Type := [others => 0];
+      Protocol       : Unsigned_8        := 0;
+      Identification : Unsigned_16       := 0;
+      TTL            : Natural           := 0;      -- aging periods left
+      Total          : Natural           := 0;      -- data length, 0 until the last fragment
+      Received       : Natural           := 0;      -- data bytes held
+      Count          : Natural           := 0;      -- fragments held, sorted by offset
+      Fragments      : Fragment_Array;
+   end record;
+
+   -- descriptors come from a fixed pool and, while in flight, are linked
+   -- in a list, most recent first
+   package Datagram_Pools is new Pools (Datagram_Type, Datagram_Ptr, IPv4_REASM_NDATAGRAMS);
+
+   Datagrams : Datagram_Ptr := null;
+
+   Reassembly_Timer : aliased Timers.Periodic_Type;
+
+   procedure Release
+      (D : in Datagram_Ptr);
+   procedure Discard
+      (D : in Datagram_Ptr);
+   procedure Trim
+      (P      : in Pbuf_Ptr;
+       Length : in Natural);
+   function Link
+      (D : in Datagram_Ptr)
+      return Pbuf_Ptr;
+   procedure Reassembly_Age
+      (Data : in Address);
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Release
+   ----------------------------------------------------------------------------
+   -- Unlink D from the in-flight list and give it back to the pool; called
+   -- with interrupts disabled.
+   ----------------------------------------------------------------------------
+   procedure Release
+      (D : in Datagram_Ptr)
+      is
+      Previous : Datagram_Ptr;
+      Object   : Datagram_Ptr;
+   begin
+      if Datagrams = D then
+         Datagrams := D.all.Next;
+      else
+         Previous := Datagrams;
+         while Previous.all.Next /= D loop
+            Previous := Previous.all.Next;
+         end loop;
+         Previous.all.Next := D.all.Next;
+      end if;
+      Object := D;
+      Datagram_Pools.Free (Object);
+   end Release;
+
+   ----------------------------------------------------------------------------
+   -- Discard
+   ----------------------------------------------------------------------------
+   -- Drop an incomplete datagram; called with interrupts disabled.
+   ----------------------------------------------------------------------------
+   procedure Discard
+      (D : in Datagram_Ptr)
+      is
+   begin
+      for Index in 1 .. D.all.Count loop
+         Free (D.all.Fragments (Index).P);
+      end loop;
+      Release (D);
+   end Discard;
+
+   ----------------------------------------------------------------------------
+   -- Trim
+   ----------------------------------------------------------------------------
+   -- Cut the chain P to Length bytes from its current payload, giving back
+   -- to the pool the pbufs which hold only link-level padding.
+   ----------------------------------------------------------------------------
+   procedure Trim
+      (P      : in Pbuf_Ptr;
+       Length : in Natural)
+      is
+      Q         : Pbuf_Ptr;
+      Tail      : Pbuf_Ptr;
+      Remaining : Natural;
+   begin
+      Q := P;
+      Remaining := Length;
+      loop
+         Q.all.Total_Size := Remaining;
+         exit when Remaining <= Q.all.Size or else Q.all.Next = null;
+         Remaining := @ - Q.all.Size;
+         Q := Q.all.Next;
+      end loop;
+      Q.all.Size := Remaining;
+      Tail := Q.all.Next;
+      Q.all.Next := null;
+      if Tail /= null then
+         Free (Tail);
+      end if;
+   end Trim;
+
+   ----------------------------------------------------------------------------
+   -- Link
+   ----------------------------------------------------------------------------
+   -- Chain the fragments of a complete datagram behind the first one, which
+   -- still carries the IPv4 header, and turn that header into the header of
+   -- the whole datagram. The references held on the fragments are handed
+   -- over to the resulting chain, and D goes back to the pool.
+   ----------------------------------------------------------------------------
+   function Link
+      (D : in Datagram_Ptr)
+      return Pbuf_Ptr
+      is
+      Q         : Pbuf_Ptr;
+      Following : Natural;
+      Size      : Natural;
+   begin
+      -- back to front, so that every pbuf learns the size of what follows
+      Following := 0;
+      for Index in reverse 1 .. D.all.Count loop
+         Q := D.all.Fragments (Index).P;
+         Size := Q.all.Total_Size;
+         loop
+            Q.all.Total_Size := @ + Following;
+            exit when Q.all.Next = null;
+            Q := Q.all.Next;
+         end loop;
+         if Index < D.all.Count then
+            Q.all.Next := D.all.Fragments (Index + 1).P;
+         end if;
+         Following := @ + Size;
+      end loop;
+      Q := D.all.Fragments (1).P;
+      declare
+         IPv4_Header : aliased IPv4_Header_Type
+            with Address    => Payload_CurrentAddress (Q),
+                 Import     => True,
+                 Convention => Ada;
+         Header_Size : constant Natural := Natural (IPv4_Header.IHL) * 4;
+      begin
+         IPv4_Header.Total_Length         := HToN (Unsigned_16 (Header_Size + D.all.Total));
+         IPv4_Header.Flags                := 0;
+         IPv4_Header.Fragmentation_Offset := 0;
+         IPv4_Header.Header_Checksum      := 0;
+         IPv4_Header.Header_Checksum      := Finalize (Sum (IPv4_Header'Address, Header_Size));
+      end;
+      Release (D);
+      return Q;
+   end Link;
+
+   ----------------------------------------------------------------------------
+   -- Reassembly_Age
+   ----------------------------------------------------------------------------
+   -- Timer procedure, runs once per aging period from Timers.Process.
+   ----------------------------------------------------------------------------
+   procedure Reassembly_Age
+      (Data : in Address)
+      is
+      pragma Unreferenced (Data);
+      D          : Datagram_Ptr;
+      Next       : Datagram_Ptr;
+      Intcontext : CPU.Intcontext_Type;
+   begin
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      D := Datagrams;
+      while D /= null loop
+         Next := D.all.Next;
+         if D.all.TTL /= 0 then
+            D.all.TTL := @ - 1;
+         end if;
+         if D.all.TTL = 0 then
+            Trace.Event (Trace.LEVEL_INFO, Trace.IPV4_REASM_TIMEOUT, Unsigned_32 (NToH (D.all.Identification)));
+            Discard (D);
+         end if;
+         D := Next;
+      end loop;
+      CPU.Intcontext_Set (Intcontext);
+   end Reassembly_Age;
+
+   ----------------------------------------------------------------------------
+   -- Timer_Start
+   ----------------------------------------------------------------------------
+   procedure Timer_Start
+      (Period : in Unsigned_32)
+      is
+   begin
+      Timers.Periodic_Start (Reassembly_Timer'Access, Period, Reassembly_Age'Access);
+   end Timer_Start;
+
+   ----------------------------------------------------------------------------
+   -- Reassemble
+   ----------------------------------------------------------------------------
+   procedure Reassemble
+      (P        : in     Pbuf_Ptr;
+       Datagram :    out Pbuf_Ptr)
+      is
+      IPv4_Header : aliased IPv4_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Header_Size : Natural;
+      Offset      : Natural;
+      Length      : Natural;
+      More        : Boolean;
+      D           : Datagram_Ptr;
+      Index       : Positive;
+      Intcontext  : CPU.Intcontext_Type;
+   begin
+      Datagram := null;
+      Header_Size := Natural (IPv4_Header.IHL) * 4;
+      Offset := Natural (IPv4_Header.Fragmentation_Offset) * 8;
+      More := (IPv4_Header.Flags and IPv4_FLAG_MF) /= 0;
+      if Natural (NToH (IPv4_Header.Total_Length)) <= Header_Size or else
+         Natural (NToH (IPv4_Header.Total_Length)) > P.all.Total_Size
+      then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.IPV4_FRAGMENT_ERROR, Unsigned_32 (NToH (IPv4_Header.Total_Length)));
+         return;
+      end if;
+      Length := Natural (NToH (IPv4_Header.Total_Length)) - Header_Size;
+      -- all fragments but the last carry a multiple of 8 bytes
+      if (More and then Length mod 8 /= 0) or else Offset + Length > IPv4_REASM_MAX_SIZE then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.IPV4_FRAGMENT_ERROR, Unsigned_32 (Length), Unsigned_32 (Offset));
+         return;
+      end if;
+      CPU.Intcontext_Get (Intcontext);
+      CPU.Irq_Disable;
+      -- look up the datagram, or start a new one
+      D := Datagrams;
+      while D /= null loop
+         exit when D.all.Identification = IPv4_Header.Identification and then
+                   D.all.Protocol = IPv4_Header.Protocol             and then
+                   D.all.Src_Address = IPv4_Header.Src_Address       and then
+                   D.all.Dst_Address = IPv4_Header.Dst_Address;
+         D := D.all.Next;
+      end loop;
+      if D = null then
+         D := Datagram_Pools.Allocate;
+         if D = null then
+            CPU.Intcontext_Set (Intcontext);
+            Trace.Event (Trace.LEVEL_INFO, Trace.IPV4_REASM_DROP, Unsigned_32 (NToH (IPv4_Header.Identification)));
+            return;
+         end if;
+         -- pool objects are uninitialized
+         D.all := (
+            Next           => Datagrams,
+            Src_Address    => IPv4_Header.Src_Address,
+            Dst_Address    => IPv4_Header.Dst_Address,
+            Protocol       => IPv4_Header.Protocol,
+            Identification => IPv4_Header.Identification,
+            TTL            => IPv4_REASM_TTL,
+            Total          => 0,
+            Received       => 0,
+            Count          => 0,
+            Fragments      => <>
+            );
+         Datagrams := D;
+      end if;
+      -- find the insertion point, keeping the fragments sorted by offset
+      Index := 1;
+      while Index <= D.all.Count and then D.all.Fragments (Index).Offset < Offset loop
+         Index := @ + 1;
+      end loop;
+      if Index <= D.all.Count                    and then
+         D.all.Fragments (Index).Offset = Offset and then
+         D.all.Fragments (Index).Length = Length
+      then
+         -- duplicate
+         CPU.Intcontext_Set (Intcontext);
+         return;
+      end if;
+      if D.all.Count = IPv4_REASM_NFRAGMENTS                                                             or else
+         -- a second last fragment, or data past the end of the datagram
+         (not More and then D.all.Total /= 0)                                                            or else
+         (D.all.Total /= 0 and then Offset + Length > D.all.Total)                                       or else
+         (not More and then D.all.Count /= 0 and then
+          D.all.Fragments (D.all.Count).Offset + D.all.Fragments (D.all.Count).Length > Offset + Length) or else
+         -- overlap with the neighbours
+         (Index > 1 and then
+          D.all.Fragments (Index - 1).Offset + D.all.Fragments (Index - 1).Length > Offset)              or else
+         (Index <= D.all.Count and then Offset + Length > D.all.Fragments (Index).Offset)
+      then
+         -- inconsistent or overlapping fragment, or no room for it
+         Discard (D);
+         CPU.Intcontext_Set (Intcontext);
+         Trace.Event (Trace.LEVEL_INFO, Trace.IPV4_REASM_DROP, Unsigned_32 (NToH (IPv4_Header.Identification)));
+         return;
+      end if;
+      if not More then
+         D.all.Total := Offset + Length;
+      end if;
+      -- hold the fragment: the first one keeps the IPv4 header, which
+      -- becomes the header of the datagram
+      Reference (P);
+      if Offset = 0 then
+         Trim (P, Header_Size + Length);
+      else
+         Payload_Adjust (P, -Header_Size);
+         Trim (P, Length);
+      end if;
+      D.all.Fragments (Index + 1 .. D.all.Count + 1) := D.all.Fragments (Index .. D.all.Count);
+      D.all.Fragments (Index) := (P => P, Offset => Offset, Length => Length);
+      D.all.Count    := @ + 1;
+      D.all.Received := @ + Length;
+      -- fragments do not overlap, so a full count means no holes left
+      if D.all.Total /= 0 and then D.all.Received = D.all.Total then
+         Datagram := Link (D);
+      end if;
+      CPU.Intcontext_Set (Intcontext);
+   end Reassemble;
+
+   ----------------------------------------------------------------------------
+   -- Output
+   ----------------------------------------------------------------------------
+   procedure Output
+      (P           : in Pbuf_Ptr;
+       Dst_Address : in IPv4_Address_Type;
+       MTU         : in Positive)
+      is
+      IPv4_Header : aliased IPv4_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Header_Size : Natural;
+      Data_Size   : Natural;
+      Chunk       : Natural;
+      Offset      : Natural;
+      Length      : Natural;
+      Source      : Natural;
+      Position    : Natural;
+      Q           : Pbuf_Ptr;
+      R           : Pbuf_Ptr;
+   begin
+      Header_Size := Natural (IPv4_Header.IHL) * 4;
+      Data_Size := Natural (NToH (IPv4_Header.Total_Length)) - Header_Size;
+      Chunk := ((MTU - Header_Size) / 8) * 8;
+      Offset := 0;
+      while Offset < Data_Size loop
+         Length := Natural'Min (Chunk, Data_Size - Offset);
+         Q := Allocate (Ethernet.ETH_HDR_SIZE + Header_Size + Length);
+         exit when Q = null;
+         Payload_Adjust (Q, -Ethernet.ETH_HDR_SIZE);
+         -- the header fits in the first pbuf, then gather the data slice
+         -- pbuf by pbuf
+         Copy_Partial (P, Payload_CurrentAddress (Q), Header_Size);
+         Source := Header_Size + Offset;
+         Position := Header_Size;
+         R := Q;
+         while R /= null loop
+            Copy_Partial (
+               P,
+               Payload_CurrentAddress (R) + Storage_Offset (Position),
+               R.all.Size - Position,
+               Source
+               );
+            Source := @ + R.all.Size - Position;
+            Position := 0;
+            R := R.all.Next;
+         end loop;
+         declare
+            Fragment_Header : aliased IPv4_Header_Type
+               with Address    => Payload_CurrentAddress (Q),
+                    Import     => True,
+                    Convention => Ada;
+         begin
+            Fragment_Header.Total_Length         := HToN (Unsigned_16 (Header_Size + Length));
+            Fragment_Header.Flags                := (if Offset + Length < Data_Size then IPv4_FLAG_MF else 0);
+            Fragment_Header.Fragmentation_Offset := Bits_13 (Offset / 8);
+            Fragment_Header.Header_Checksum      := 0;
+            Fragment_Header.Header_Checksum      := Finalize (Sum (Fragment_Header'Address, Header_Size));
+         end;
+         Ethernet.Output (Q, Dst_Address);
+         Free (Q);
+         Offset := @ + Length;
+      end loop;
+   end Output;
+
+end IPv4_Fragments;
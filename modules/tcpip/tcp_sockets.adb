@@ -0,0 +1,1304 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ tcp_sockets.adb                                                                                           --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with System.Storage_Elements;
+with Bits;
+with Timers;
+with INET_Checksum;
+with Ethernet;
+
+package body TCP_Sockets
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use System.Storage_Elements;
+   use Bits;
+   use INET_Checksum;
+
+   pragma Compile_Time_Error (TCP_RCV_BUFFER > 16#FFFF#, "TCP_RCV_BUFFER exceeds an unscaled window");
+
+   -- header flags
+   TH_FIN : constant := 16#01#;
+   TH_SYN : constant := 16#02#;
+   TH_RST : constant := 16#04#;
+   TH_PSH : constant := 16#08#;
+   TH_ACK : constant := 16#10#;
+
+   TCP_OPTION_MSS_SIZE : constant := 4;
+   TCP_MSS_DEFAULT     : constant := 536;    -- RFC 1122 4.2.2.6
+   TCP_MSS_MIN         : constant := 64;     -- smallest peer MSS honoured
+   TCP_PORT_EPHEMERAL  : constant := 49_152;
+
+   -- times in TCP ticks
+   TCP_RTO_INITIAL : constant := 1_000 / TCP_TICK_MS;
+   TCP_RTO_MIN     : constant := 200 / TCP_TICK_MS;
+   TCP_RTO_MAX     : constant := 60_000 / TCP_TICK_MS;
+   TCP_DELACK      : constant := 200 / TCP_TICK_MS;
+   TCP_TIME_WAIT   : constant := 2_000 / TCP_TICK_MS;  -- 2 * MSL, with a short MSL
+   TCP_FIN_WAIT_2  : constant := 60_000 / TCP_TICK_MS; -- orphaned connections only
+   TCP_RETRIES     : constant := 8;
+
+   HEADROOM : constant := Ethernet.ETH_HDR_SIZE + IPv4_HDR_SIZE + TCP_HDR_SIZE + TCP_OPTION_MSS_SIZE;
+
+   type Send_Record_Type is record
+      Data_Address : Address;
+      Length       : Natural;
+   end record;
+
+   type Send_Queue_Type is array (0 .. TCP_SND_QUEUE - 1) of Send_Record_Type;
+
+   type Receive_Record_Type is record
+      P        : Pbuf_Ptr; -- current payload at the TCP header
+      Offset   : Natural;  -- data offset from the current payload
+      Length   : Natural;
+      Consumed : Natural;
+   end record;
+
+   type Receive_Queue_Type is array (0 .. TCP_RCV_QUEUE - 1) of Receive_Record_Type;
+
+   -- Transmission Control Block
+   type TCB_Type is record
+      In_Use          : Boolean := False;
+      Owned           : Boolean := False;     -- held by the application
+      Listener        : Socket_Type := NO_SOCKET; -- not accepted yet
+      State           : State_Type := CLOSED;
+      Local_Port      : Unsigned_16 := 0;
+      Remote_Port     : Unsigned_16 := 0;
+      Remote_Address  : IPv4_Address_Type := [others => 0];
+      MSS             : Natural := TCP_MSS_DEFAULT;
+      -- send sequence space
+      ISS             : Unsigned_32 := 0;
+      Snd_Una         : Unsigned_32 := 0;
+      Snd_Nxt         : Unsigned_32 := 0;
+      Snd_Max         : Unsigned_32 := 0;
+      Snd_Wnd         : Unsigned_32 := 0;
+      Snd_Wl1         : Unsigned_32 := 0;
+      Snd_Wl2         : Unsigned_32 := 0;
+      Cwnd            : Unsigned_32 := 0;
+      Ssthresh        : Unsigned_32 := 0;
+      Dupacks         : Natural := 0;
+      Fin_Pending     : Boolean := False; -- FIN follows the queued data
+      Fin_Sent        : Boolean := False;
+      Fin_Seq         : Unsigned_32 := 0;
+      -- application buffers, from Snd_Una on
+      Snd_Queue       : Send_Queue_Type;
+      Snd_Head        : Natural := 0;
+      Snd_Count       : Natural := 0;
+      Snd_Head_Offset : Natural := 0;     -- bytes of the head buffer acknowledged
+      Snd_Bytes       : Natural := 0;
+      -- receive sequence space
+      IRS             : Unsigned_32 := 0;
+      Rcv_Nxt         : Unsigned_32 := 0;
+      Rcv_Adv         : Unsigned_32 := 0; -- right edge of the advertised window
+      Rcv_Queue       : Receive_Queue_Type;
+      Rcv_Head        : Natural := 0;
+      Rcv_Count       : Natural := 0;
+      Rcv_Bytes       : Natural := 0;
+      Ack_Now         : Boolean := False;
+      Ack_Pending     : Natural := 0;     -- segments not acknowledged yet
+      -- timers, in TCP ticks
+      Rtx_Armed       : Boolean := False;
+      Rtx_Deadline    : Unsigned_32 := 0;
+      Rtx_Count       : Natural := 0;
+      RTO             : Unsigned_32 := TCP_RTO_INITIAL;
+      SRTT8           : Natural := 0;     -- smoothed RTT * 8
+      RTTVAR4         : Natural := 0;     -- RTT variation * 4
+      Rtt_Timing      : Boolean := False;
+      Rtt_Seq         : Unsigned_32 := 0;
+      Rtt_Start       : Unsigned_32 := 0;
+      Delack_Armed    : Boolean := False;
+      Delack_Deadline : Unsigned_32 := 0;
+   end record;
+
+   TCBs : array (Socket_Type range 1 .. Socket_Type'Last) of TCB_Type;
+
+   TCP_Clock : aliased Timers.Periodic_Type;
+   ISS_Next  : Unsigned_32 := 0;
+   Port_Next  : Unsigned_16 := TCP_PORT_EPHEMERAL;
+
+   function Seq_LT
+      (A : Unsigned_32;
+       B : Unsigned_32)
+      return Boolean
+      with Inline => True;
+   function Seq_LE
+      (A : Unsigned_32;
+       B : Unsigned_32)
+      return Boolean
+      with Inline => True;
+   function Socket_Allocate
+      return Socket_Type;
+   procedure Release
+      (S : in Socket_Type);
+   function Fin_Acked
+      (S : Socket_Type)
+      return Boolean;
+   function Window_Available
+      (S : Socket_Type)
+      return Natural;
+   function MSS_Option
+      (P             : Pbuf_Ptr;
+       Header_Length : Natural)
+      return Natural;
+   procedure Header_Output
+      (P              : in Pbuf_Ptr;
+       Remote_Address : in IPv4_Address_Type;
+       Local_Port     : in Unsigned_16;
+       Remote_Port    : in Unsigned_16;
+       Seq_Num        : in Unsigned_32;
+       Ack_Num        : in Unsigned_32;
+       Flags          : in Unsigned_8;
+       Window         : in Unsigned_16;
+       MSS            : in Natural);
+   procedure Reset_Send
+      (Remote_Address : in IPv4_Address_Type;
+       Local_Port     : in Unsigned_16;
+       Remote_Port    : in Unsigned_16;
+       Seq_Num        : in Unsigned_32;
+       Ack_Num        : in Unsigned_32;
+       Flags          : in Unsigned_8);
+   procedure Segment_Send
+      (S       : in     Socket_Type;
+       Seq_Num : in     Unsigned_32;
+       Length  : in     Natural;
+       Flags   : in     Unsigned_8;
+       Success :    out Boolean);
+   procedure Ack_Send
+      (S : in Socket_Type);
+   procedure Rtx_Arm
+      (S : in Socket_Type);
+   procedure RTT_Sample
+      (S : in Socket_Type);
+   procedure Output
+      (S     : in Socket_Type;
+       Probe : in Boolean := False);
+   procedure Timeout
+      (S : in Socket_Type);
+   procedure Ack_Process
+      (S       : in Socket_Type;
+       Seq_Num : in Unsigned_32;
+       Ack_Num : in Unsigned_32;
+       Window  : in Unsigned_32;
+       Length  : in Natural);
+   procedure Data_Process
+      (S       : in Socket_Type;
+       P       : in Pbuf_Ptr;
+       Seq_Num : in Unsigned_32;
+       Offset  : in Natural;
+       Length  : in Natural;
+       FIN     : in Boolean);
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Seq_LT/Seq_LE
+   ----------------------------------------------------------------------------
+   -- Sequence number comparisons, modulo 2**32.
+   ----------------------------------------------------------------------------
+   function Seq_LT
+      (A : Unsigned_32;
+       B : Unsigned_32)
+      return Boolean
+      is
+   begin
+      return (A - B) >= 16#8000_0000#;
+   end Seq_LT;
+
+   function Seq_LE
+      (A : Unsigned_32;
+       B : Unsigned_32)
+      return Boolean
+      is
+   begin
+      return A = B or else Seq_LT (A, B);
+   end Seq_LE;
+
+   ----------------------------------------------------------------------------
+   -- Socket_Allocate
+   ----------------------------------------------------------------------------
+   function Socket_Allocate
+      return Socket_Type
+      is
+   begin
+      for S in TCBs'Range loop
+         if not TCBs (S).In_Use then
+            TCBs (S) := (others => <>);
+            TCBs (S).In_Use := True;
+            ISS_Next := @ + 64_000 + TCP_Clock.Count * 250;
+            TCBs (S).ISS := ISS_Next;
+            return S;
+         end if;
+      end loop;
+      return NO_SOCKET;
+   end Socket_Allocate;
+
+   ----------------------------------------------------------------------------
+   -- Release
+   ----------------------------------------------------------------------------
+   -- Drop all the state of a connection; the socket is freed too, unless
+   -- the application still holds it.
+   ----------------------------------------------------------------------------
+   procedure Release
+      (S : in Socket_Type)
+      is
+      T : TCB_Type renames TCBs (S);
+   begin
+      while T.Rcv_Count > 0 loop
+         Free (T.Rcv_Queue (T.Rcv_Head).P);
+         T.Rcv_Head := (@ + 1) mod TCP_RCV_QUEUE;
+         T.Rcv_Count := @ - 1;
+      end loop;
+      T.Rcv_Bytes    := 0;
+      T.Snd_Count    := 0;
+      T.Snd_Bytes    := 0;
+      T.Rtx_Armed    := False;
+      T.Delack_Armed := False;
+      T.State        := CLOSED;
+      if not T.Owned then
+         T.In_Use := False;
+      end if;
+   end Release;
+
+   ----------------------------------------------------------------------------
+   -- Fin_Acked
+   ----------------------------------------------------------------------------
+   function Fin_Acked
+      (S : Socket_Type)
+      return Boolean
+      is
+      T : TCB_Type renames TCBs (S);
+   begin
+      return T.Fin_Sent and then Seq_LT (T.Fin_Seq, T.Snd_Una);
+   end Fin_Acked;
+
+   ----------------------------------------------------------------------------
+   -- Window_Available
+   ----------------------------------------------------------------------------
+   function Window_Available
+      (S : Socket_Type)
+      return Natural
+      is
+      T : TCB_Type renames TCBs (S);
+   begin
+      if T.Rcv_Count = TCP_RCV_QUEUE then
+         return 0;
+      end if;
+      return TCP_RCV_BUFFER - T.Rcv_Bytes;
+   end Window_Available;
+
+   ----------------------------------------------------------------------------
+   -- MSS_Option
+   ----------------------------------------------------------------------------
+   -- Peer MSS from the options of the SYN at the current payload of P,
+   -- TCP_MSS_DEFAULT if absent; clamped to TCP_MSS_MIN below and to what
+   -- fits in the MTU of the receiving interface above.
+   ----------------------------------------------------------------------------
+   function MSS_Option
+      (P             : Pbuf_Ptr;
+       Header_Length : Natural)
+      return Natural
+      is
+      Options : aliased Byte_Array (0 .. Header_Length - TCP_HDR_SIZE - 1)
+         with Address    => Payload_CurrentAddress (P) + TCP_HDR_SIZE,
+              Import     => True,
+              Convention => Ada;
+      Id      : constant Ethernet.Interface_Id_Type := Ethernet.Current_Interface;
+      MTU     : Natural;
+      Limit   : Natural := TCP_MSS;
+      Index   : Natural := 0;
+   begin
+      if Id /= Ethernet.NO_INTERFACE then
+         MTU := Ethernet.Descriptor_Get (Id).MTU;
+         if MTU > IPv4_HDR_SIZE + TCP_HDR_SIZE + TCP_MSS_MIN then
+            Limit := Natural'Min (@, MTU - IPv4_HDR_SIZE - TCP_HDR_SIZE);
+         end if;
+      end if;
+      while Index < Options'Length loop
+         case Options (Index) is
+            when 0      => exit;                 -- end of option list
+            when 1      => Index := @ + 1;       -- no-operation
+            when others =>
+               exit when Index + 1 >= Options'Length or else Options (Index + 1) < 2;
+               if Options (Index) = 2 and then Options (Index + 1) = 4 and then Index + 3 < Options'Length then
+                  return Natural'Min (
+                     Natural'Max (
+                        Natural (Options (Index + 2)) * 2**8 + Natural (Options (Index + 3)),
+                        TCP_MSS_MIN
+                        ),
+                     Limit
+                     );
+               end if;
+               Index := @ + Natural (Options (Index + 1));
+         end case;
+      end loop;
+      return Natural'Min (TCP_MSS_DEFAULT, Limit);
+   end MSS_Option;
+
+   ----------------------------------------------------------------------------
+   -- Header_Output
+   ----------------------------------------------------------------------------
+   -- Prepend a TCP header (with an MSS option if MSS /= 0) to the data at
+   -- the current payload of P and send it.
+   ----------------------------------------------------------------------------
+   procedure Header_Output
+      (P              : in Pbuf_Ptr;
+       Remote_Address : in IPv4_Address_Type;
+       Local_Port     : in Unsigned_16;
+       Remote_Port    : in Unsigned_16;
+       Seq_Num        : in Unsigned_32;
+       Ack_Num        : in Unsigned_32;
+       Flags          : in Unsigned_8;
+       Window         : in Unsigned_16;
+       MSS            : in Natural)
+      is
+      Header_Length : constant Natural := (if MSS /= 0 then TCP_HDR_SIZE + TCP_OPTION_MSS_SIZE else TCP_HDR_SIZE);
+      Length        : Natural;
+      Pseudo_Header : aliased TCP_IPv4_PseudoHeader_Type;
+   begin
+      Payload_Adjust (P, +Header_Length);
+      Length := P.all.Total_Size;
+      declare
+         TCP_Header : aliased TCP_Header_Type
+            with Address    => Payload_CurrentAddress (P),
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         TCP_Header := (
+            Src_Port       => HToN (Local_Port),
+            Dst_Port       => HToN (Remote_Port),
+            Seq_Num        => HToN (Seq_Num),
+            Ack_Num        => HToN (Ack_Num),
+            HLen           => Bits_4 (Header_Length / 4),
+            Reserved       => 0,
+            Urg            => 0,
+            Ack            => To_B1 ((Flags and TH_ACK) /= 0),
+            Psh            => To_B1 ((Flags and TH_PSH) /= 0),
+            Rst            => To_B1 ((Flags and TH_RST) /= 0),
+            Syn            => To_B1 ((Flags and TH_SYN) /= 0),
+            Fin            => To_B1 ((Flags and TH_FIN) /= 0),
+            Window_Size    => HToN (Window),
+            Checksum       => 0,
+            Urgent_Pointer => 0
+            );
+         if MSS /= 0 then
+            declare
+               Option : aliased Byte_Array (0 .. TCP_OPTION_MSS_SIZE - 1)
+                  with Address    => Payload_CurrentAddress (P) + TCP_HDR_SIZE,
+                       Import     => True,
+                       Convention => Ada;
+            begin
+               Option := [2, TCP_OPTION_MSS_SIZE, Unsigned_8 (MSS / 2**8), Unsigned_8 (MSS mod 2**8)];
+            end;
+         end if;
+         Pseudo_Header := (
+            Src_Address => Ethernet.Source_Address (Remote_Address),
+            Dst_Address => Remote_Address,
+            Zeroes      => 0,
+            Protocol    => TCP,
+            Length      => HToN (Unsigned_16 (Length))
+            );
+         TCP_Header.Checksum := Finalize (
+            Sum (P, Length, Sum (Pseudo_Header'Address, TCP_IPv4_PseudoHeader_SIZE))
+            );
+      end;
+      IPv4_Output (P, TCP, Remote_Address);
+   end Header_Output;
+
+   ----------------------------------------------------------------------------
+   -- Reset_Send
+   ----------------------------------------------------------------------------
+   procedure Reset_Send
+      (Remote_Address : in IPv4_Address_Type;
+       Local_Port     : in Unsigned_16;
+       Remote_Port    : in Unsigned_16;
+       Seq_Num        : in Unsigned_32;
+       Ack_Num        : in Unsigned_32;
+       Flags          : in Unsigned_8)
+      is
+      P : Pbuf_Ptr;
+   begin
+      P := Allocate (HEADROOM);
+      if P /= null then
+         Payload_Adjust (P, -HEADROOM);
+         Header_Output (P, Remote_Address, Local_Port, Remote_Port, Seq_Num, Ack_Num, Flags, 0, 0);
+         Free (P);
+      end if;
+   end Reset_Send;
+
+   ----------------------------------------------------------------------------
+   -- Segment_Send
+   ----------------------------------------------------------------------------
+   -- Send Length bytes of the stream starting at Seq_Num, copied straight
+   -- from the application buffers into the frame.
+   ----------------------------------------------------------------------------
+   procedure Segment_Send
+      (S       : in     Socket_Type;
+       Seq_Num : in     Unsigned_32;
+       Length  : in     Natural;
+       Flags   : in     Unsigned_8;
+       Success :    out Boolean)
+      is
+      T      : TCB_Type renames TCBs (S);
+      P      : Pbuf_Ptr;
+      Window : Natural;
+      Index  : Natural;
+      Skip   : Natural;
+      Done   : Natural;
+      Chunk  : Natural;
+   begin
+      P := Allocate (HEADROOM + Length);
+      Success := P /= null;
+      if not Success then
+         return;
+      end if;
+      Payload_Adjust (P, -HEADROOM);
+      -- gather the data from the application buffers
+      Index := T.Snd_Head;
+      Skip := T.Snd_Head_Offset + Natural (Seq_Num - T.Snd_Una);
+      Done := 0;
+      while Done < Length loop
+         if Skip >= T.Snd_Queue (Index).Length then
+            Skip := @ - T.Snd_Queue (Index).Length;
+         else
+            Chunk := Natural'Min (T.Snd_Queue (Index).Length - Skip, Length - Done);
+            Take (P, T.Snd_Queue (Index).Data_Address + Storage_Offset (Skip), Chunk, Done);
+            Done := @ + Chunk;
+            Skip := 0;
+         end if;
+         Index := (@ + 1) mod TCP_SND_QUEUE;
+      end loop;
+      Window := Window_Available (S);
+      Header_Output (
+         P,
+         T.Remote_Address,
+         T.Local_Port,
+         T.Remote_Port,
+         Seq_Num,
+         (if (Flags and TH_ACK) /= 0 then T.Rcv_Nxt else 0),
+         Flags,
+         Unsigned_16 (Window),
+         (if (Flags and TH_SYN) /= 0 then TCP_MSS else 0)
+         );
+      Free (P);
+      if (Flags and TH_ACK) /= 0 then
+         T.Rcv_Adv      := T.Rcv_Nxt + Unsigned_32 (Window);
+         T.Ack_Now      := False;
+         T.Ack_Pending  := 0;
+         T.Delack_Armed := False;
+      end if;
+   end Segment_Send;
+
+   ----------------------------------------------------------------------------
+   -- Ack_Send
+   ----------------------------------------------------------------------------
+   procedure Ack_Send
+      (S : in Socket_Type)
+      is
+      Success : Boolean;
+   begin
+      Segment_Send (S, TCBs (S).Snd_Nxt, 0, TH_ACK, Success);
+   end Ack_Send;
+
+   ----------------------------------------------------------------------------
+   -- Rtx_Arm
+   ----------------------------------------------------------------------------
+   procedure Rtx_Arm
+      (S : in Socket_Type)
+      is
+   begin
+      TCBs (S).Rtx_Armed := True;
+      TCBs (S).Rtx_Deadline := TCP_Clock.Count + TCBs (S).RTO;
+   end Rtx_Arm;
+
+   ----------------------------------------------------------------------------
+   -- RTT_Sample
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 6298 2.2, 2.3
+   ----------------------------------------------------------------------------
+   procedure RTT_Sample
+      (S : in Socket_Type)
+      is
+      T     : TCB_Type renames TCBs (S);
+      M     : constant Natural := Natural (TCP_Clock.Count - T.Rtt_Start);
+      Error : Integer;
+   begin
+      if T.SRTT8 = 0 then
+         T.SRTT8   := M * 8;
+         T.RTTVAR4 := M * 2;
+      else
+         Error     := M - T.SRTT8 / 8;
+         T.SRTT8   := T.SRTT8 + Error;
+         T.RTTVAR4 := T.RTTVAR4 + abs Error - T.RTTVAR4 / 4;
+      end if;
+      T.RTO := Unsigned_32 (Natural'Max (
+         TCP_RTO_MIN,
+         Natural'Min (T.SRTT8 / 8 + Natural'Max (T.RTTVAR4, 1), TCP_RTO_MAX)
+         ));
+      T.Rtt_Timing := False;
+   end RTT_Sample;
+
+   ----------------------------------------------------------------------------
+   -- Output
+   ----------------------------------------------------------------------------
+   -- Send as much queued data as the peer and congestion windows allow,
+   -- then the FIN; Probe forces a 1-byte window probe into a zero window.
+   ----------------------------------------------------------------------------
+   procedure Output
+      (S     : in Socket_Type;
+       Probe : in Boolean := False)
+      is
+      T       : TCB_Type renames TCBs (S);
+      Snd_End : Unsigned_32;
+      Flight  : Unsigned_32;
+      Window  : Unsigned_32;
+      Length  : Unsigned_32;
+      Flags   : Unsigned_8;
+      Success : Boolean;
+   begin
+      if T.State not in ESTABLISHED | CLOSE_WAIT | FIN_WAIT_1 | CLOSING | LAST_ACK then
+         return;
+      end if;
+      Snd_End := T.Snd_Una + Unsigned_32 (T.Snd_Bytes);
+      Window := Unsigned_32'Min (T.Snd_Wnd, T.Cwnd);
+      if Probe and then Window = 0 then
+         Window := 1;
+      end if;
+      while Seq_LT (T.Snd_Nxt, Snd_End) loop
+         Flight := T.Snd_Nxt - T.Snd_Una;
+         exit when Flight >= Window;
+         Length := Unsigned_32'Min (Unsigned_32'Min (Snd_End - T.Snd_Nxt, Unsigned_32 (T.MSS)), Window - Flight);
+         -- sender silly window avoidance: wait for the window to open
+         exit when Length < Unsigned_32 (T.MSS) and then Length < Snd_End - T.Snd_Nxt and then Flight /= 0;
+         Flags := (if T.Snd_Nxt + Length = Snd_End then TH_ACK or TH_PSH else TH_ACK);
+         Segment_Send (S, T.Snd_Nxt, Natural (Length), Flags, Success);
+         exit when not Success;
+         if not T.Rtt_Timing and then T.Snd_Nxt = T.Snd_Max then
+            -- time new data only (Karn)
+            T.Rtt_Timing := True;
+            T.Rtt_Seq    := T.Snd_Nxt;
+            T.Rtt_Start  := TCP_Clock.Count;
+         end if;
+         T.Snd_Nxt := @ + Length;
+         if Seq_LT (T.Snd_Max, T.Snd_Nxt) then
+            T.Snd_Max := T.Snd_Nxt;
+         end if;
+      end loop;
+      if T.Fin_Pending and then T.Snd_Nxt = Snd_End and then not Fin_Acked (S) then
+         Segment_Send (S, Snd_End, 0, TH_ACK or TH_FIN, Success);
+         if Success then
+            T.Fin_Sent := True;
+            T.Fin_Seq  := Snd_End;
+            T.Snd_Nxt  := Snd_End + 1;
+            if Seq_LT (T.Snd_Max, T.Snd_Nxt) then
+               T.Snd_Max := T.Snd_Nxt;
+            end if;
+         end if;
+      end if;
+      -- the timer covers data in flight as well as unsent data held back
+      -- by a zero window (persist)
+      if not T.Rtx_Armed and then
+         (T.Snd_Max /= T.Snd_Una or else T.Snd_Bytes /= 0 or else (T.Fin_Pending and then not Fin_Acked (S)))
+      then
+         Rtx_Arm (S);
+      end if;
+   end Output;
+
+   ----------------------------------------------------------------------------
+   -- Timeout
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 5681 3.1, RFC 6298 5
+   ----------------------------------------------------------------------------
+   procedure Timeout
+      (S : in Socket_Type)
+      is
+      T       : TCB_Type renames TCBs (S);
+      Flight  : Unsigned_32;
+      Success : Boolean;
+   begin
+      case T.State is
+         when CLOSED | LISTEN =>
+            null;
+         when FIN_WAIT_2 | TIME_WAIT =>
+            Release (S);
+         when others =>
+            if T.Snd_Wnd /= 0 or else T.State in SYN_SENT | SYN_RECEIVED then
+               -- zero window probes go on as long as the peer answers
+               T.Rtx_Count := @ + 1;
+            end if;
+            if T.Rtx_Count > TCP_RETRIES then
+               Reset_Send (T.Remote_Address, T.Local_Port, T.Remote_Port, T.Snd_Nxt, 0, TH_RST);
+               Release (S);
+               return;
+            end if;
+            T.RTO := Unsigned_32'Min (T.RTO * 2, TCP_RTO_MAX);
+            T.Rtt_Timing := False;
+            if T.State = SYN_SENT then
+               Segment_Send (S, T.ISS, 0, TH_SYN, Success);
+               Rtx_Arm (S);
+            elsif T.State = SYN_RECEIVED then
+               Segment_Send (S, T.ISS, 0, TH_SYN or TH_ACK, Success);
+               Rtx_Arm (S);
+            else
+               -- go back to the first unacknowledged byte with one segment
+               Flight := T.Snd_Max - T.Snd_Una;
+               T.Ssthresh := Unsigned_32'Max (Flight / 2, Unsigned_32 (2 * T.MSS));
+               T.Cwnd     := Unsigned_32 (T.MSS);
+               T.Dupacks  := 0;
+               T.Snd_Nxt  := T.Snd_Una;
+               Output (S, Probe => True);
+            end if;
+      end case;
+   end Timeout;
+
+   ----------------------------------------------------------------------------
+   -- Ack_Process
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 793 3.9 (fifth, check the ACK field), RFC 5681 3
+   ----------------------------------------------------------------------------
+   procedure Ack_Process
+      (S       : in Socket_Type;
+       Seq_Num : in Unsigned_32;
+       Ack_Num : in Unsigned_32;
+       Window  : in Unsigned_32;
+       Length  : in Natural)
+      is
+      T         : TCB_Type renames TCBs (S);
+      Acked     : Unsigned_32;
+      Remaining : Natural;
+      Chunk     : Natural;
+      Success   : Boolean;
+   begin
+      if Seq_LT (T.Snd_Una, Ack_Num) and then Seq_LE (Ack_Num, T.Snd_Max) then
+         Acked := Ack_Num - T.Snd_Una;
+         -- release acknowledged buffers, the FIN takes one more number
+         Remaining := Natural'Min (Natural (Acked), T.Snd_Bytes);
+         T.Snd_Bytes := @ - Remaining;
+         while Remaining > 0 loop
+            Chunk := Natural'Min (T.Snd_Queue (T.Snd_Head).Length - T.Snd_Head_Offset, Remaining);
+            T.Snd_Head_Offset := @ + Chunk;
+            Remaining := @ - Chunk;
+            if T.Snd_Head_Offset = T.Snd_Queue (T.Snd_Head).Length then
+               T.Snd_Head_Offset := 0;
+               T.Snd_Head := (@ + 1) mod TCP_SND_QUEUE;
+               T.Snd_Count := @ - 1;
+            end if;
+         end loop;
+         T.Snd_Una := Ack_Num;
+         if Seq_LT (T.Snd_Nxt, T.Snd_Una) then
+            T.Snd_Nxt := T.Snd_Una;
+         end if;
+         if T.Rtt_Timing and then Seq_LT (T.Rtt_Seq, Ack_Num) then
+            RTT_Sample (S);
+         end if;
+         -- slow start, then congestion avoidance
+         if T.Cwnd < T.Ssthresh then
+            T.Cwnd := @ + Unsigned_32'Min (Acked, Unsigned_32 (T.MSS));
+         else
+            T.Cwnd := @ + Unsigned_32'Max (Unsigned_32 (T.MSS * T.MSS) / T.Cwnd, 1);
+         end if;
+         T.Cwnd := Unsigned_32'Min (T.Cwnd, TCP_SND_BUFFER);
+         T.Dupacks := 0;
+         T.Rtx_Count := 0;
+         if T.Snd_Una = T.Snd_Max then
+            T.Rtx_Armed := False;
+         else
+            Rtx_Arm (S);
+         end if;
+      elsif Ack_Num = T.Snd_Una and then Length = 0 and then Window = T.Snd_Wnd and then T.Snd_Max /= T.Snd_Una then
+         T.Dupacks := @ + 1;
+         if T.Dupacks = 3 and then T.Snd_Bytes /= 0 then
+            -- fast retransmit
+            T.Ssthresh := Unsigned_32'Max ((T.Snd_Max - T.Snd_Una) / 2, Unsigned_32 (2 * T.MSS));
+            T.Cwnd := T.Ssthresh;
+            T.Rtt_Timing := False;
+            Segment_Send (S, T.Snd_Una, Natural'Min (T.MSS, T.Snd_Bytes), TH_ACK, Success);
+         end if;
+      end if;
+      -- window update, ignoring segments older than the last one used
+      if Seq_LT (T.Snd_Wl1, Seq_Num) or else (T.Snd_Wl1 = Seq_Num and then Seq_LE (T.Snd_Wl2, Ack_Num)) then
+         T.Snd_Wnd := Window;
+         T.Snd_Wl1 := Seq_Num;
+         T.Snd_Wl2 := Ack_Num;
+      end if;
+   end Ack_Process;
+
+   ----------------------------------------------------------------------------
+   -- Data_Process
+   ----------------------------------------------------------------------------
+   -- Queue in-order data (Length bytes at Offset from the current payload
+   -- of P) and process the FIN; anything out of order is dropped and
+   -- answered with an immediate (duplicate) ACK.
+   ----------------------------------------------------------------------------
+   procedure Data_Process
+      (S       : in Socket_Type;
+       P       : in Pbuf_Ptr;
+       Seq_Num : in Unsigned_32;
+       Offset  : in Natural;
+       Length  : in Natural;
+       FIN     : in Boolean)
+      is
+      T           : TCB_Type renames TCBs (S);
+      Data_Offset : Natural := Offset;
+      Data_Length : Natural := Length;
+      In_Order    : Boolean := True;
+      Duplicate   : Unsigned_32;
+      Index       : Natural;
+   begin
+      if Seq_LT (Seq_Num, T.Rcv_Nxt) then
+         -- trim what was received already
+         Duplicate := T.Rcv_Nxt - Seq_Num;
+         if Duplicate > Unsigned_32 (Length) then
+            In_Order := False;
+         else
+            Data_Offset := @ + Natural (Duplicate);
+            Data_Length := @ - Natural (Duplicate);
+         end if;
+         T.Ack_Now := True;
+      elsif Seq_Num /= T.Rcv_Nxt then
+         In_Order := False;
+      end if;
+      if not In_Order then
+         T.Ack_Now := True;
+         return;
+      end if;
+      if Data_Length > 0 and then T.State in ESTABLISHED | FIN_WAIT_1 | FIN_WAIT_2 then
+         if not T.Owned and then T.Listener = NO_SOCKET then
+            -- orphaned connection: acknowledge and discard
+            T.Rcv_Nxt := @ + Unsigned_32 (Data_Length);
+            T.Ack_Now := True;
+         elsif Data_Length > Window_Available (S) then
+            T.Ack_Now := True;
+            return;
+         else
+            Reference (P);
+            Index := (T.Rcv_Head + T.Rcv_Count) mod TCP_RCV_QUEUE;
+            T.Rcv_Queue (Index) := (P => P, Offset => Data_Offset, Length => Data_Length, Consumed => 0);
+            T.Rcv_Count := @ + 1;
+            T.Rcv_Bytes := @ + Data_Length;
+            T.Rcv_Nxt := @ + Unsigned_32 (Data_Length);
+            -- acknowledge at least every second segment (RFC 1122 4.2.3.2)
+            T.Ack_Pending := @ + 1;
+            if T.Ack_Pending >= 2 then
+               T.Ack_Now := True;
+            elsif not T.Delack_Armed then
+               T.Delack_Armed := True;
+               T.Delack_Deadline := TCP_Clock.Count + TCP_DELACK;
+            end if;
+         end if;
+      end if;
+      if FIN then
+         T.Rcv_Nxt := @ + 1;
+         T.Ack_Now := True;
+         case T.State is
+            when SYN_RECEIVED | ESTABLISHED =>
+               T.State := CLOSE_WAIT;
+            when FIN_WAIT_1 =>
+               T.State := CLOSING;
+            when FIN_WAIT_2 =>
+               T.State := TIME_WAIT;
+               T.Rtx_Armed := True;
+               T.Rtx_Deadline := TCP_Clock.Count + TCP_TIME_WAIT;
+            when TIME_WAIT =>
+               T.Rtx_Deadline := TCP_Clock.Count + TCP_TIME_WAIT;
+            when others =>
+               null;
+         end case;
+      end if;
+   end Data_Process;
+
+   ----------------------------------------------------------------------------
+   -- Timer_Start
+   ----------------------------------------------------------------------------
+   procedure Timer_Start
+      (Period : in Unsigned_32)
+      is
+   begin
+      Timers.Periodic_Start (TCP_Clock'Access, Period);
+   end Timer_Start;
+
+   ----------------------------------------------------------------------------
+   -- Listen
+   ----------------------------------------------------------------------------
+   procedure Listen
+      (Port   : in     Unsigned_16;
+       Socket :    out Socket_Type)
+      is
+   begin
+      Socket := NO_SOCKET;
+      for S in TCBs'Range loop
+         if TCBs (S).In_Use and then TCBs (S).State = LISTEN and then TCBs (S).Local_Port = Port then
+            return;
+         end if;
+      end loop;
+      Socket := Socket_Allocate;
+      if Socket /= NO_SOCKET then
+         TCBs (Socket).Owned      := True;
+         TCBs (Socket).State      := LISTEN;
+         TCBs (Socket).Local_Port := Port;
+      end if;
+   end Listen;
+
+   ----------------------------------------------------------------------------
+   -- Accept_Connection
+   ----------------------------------------------------------------------------
+   procedure Accept_Connection
+      (Listener : in     Socket_Type;
+       Socket   :    out Socket_Type)
+      is
+   begin
+      Socket := NO_SOCKET;
+      if Listener = NO_SOCKET then
+         return;
+      end if;
+      for S in TCBs'Range loop
+         if TCBs (S).In_Use and then TCBs (S).Listener = Listener and then TCBs (S).State /= SYN_RECEIVED then
+            TCBs (S).Owned    := True;
+            TCBs (S).Listener := NO_SOCKET;
+            Socket := S;
+            return;
+         end if;
+      end loop;
+   end Accept_Connection;
+
+   ----------------------------------------------------------------------------
+   -- Connect
+   ----------------------------------------------------------------------------
+   procedure Connect
+      (Address : in     IPv4_Address_Type;
+       Port    : in     Unsigned_16;
+       Socket  :    out Socket_Type)
+      is
+      Success : Boolean;
+   begin
+      Socket := Socket_Allocate;
+      if Socket = NO_SOCKET then
+         return;
+      end if;
+      declare
+         T : TCB_Type renames TCBs (Socket);
+      begin
+         T.Owned          := True;
+         T.State          := SYN_SENT;
+         T.Local_Port     := Port_Next;
+         T.Remote_Port    := Port;
+         T.Remote_Address := Address;
+         T.Snd_Una        := T.ISS;
+         T.Snd_Nxt        := T.ISS + 1;
+         T.Snd_Max        := T.ISS + 1;
+         T.Ssthresh       := 16#FFFF#;
+         Port_Next := (if Port_Next = Unsigned_16'Last then TCP_PORT_EPHEMERAL else Port_Next + 1);
+         Segment_Send (Socket, T.ISS, 0, TH_SYN, Success);
+         Rtx_Arm (Socket);
+      end;
+   end Connect;
+
+   ----------------------------------------------------------------------------
+   -- Send
+   ----------------------------------------------------------------------------
+   procedure Send
+      (Socket       : in     Socket_Type;
+       Data_Address : in     System.Address;
+       Length       : in     Natural;
+       Success      :    out Boolean)
+      is
+   begin
+      Success := False;
+      if Socket = NO_SOCKET or else Length = 0 then
+         return;
+      end if;
+      declare
+         T : TCB_Type renames TCBs (Socket);
+      begin
+         if T.State not in ESTABLISHED | CLOSE_WAIT or else
+            T.Fin_Pending or else
+            T.Snd_Count = TCP_SND_QUEUE or else
+            Length > TCP_SND_BUFFER - T.Snd_Bytes
+         then
+            return;
+         end if;
+         T.Snd_Queue ((T.Snd_Head + T.Snd_Count) mod TCP_SND_QUEUE) := (Data_Address, Length);
+         T.Snd_Count := @ + 1;
+         T.Snd_Bytes := @ + Length;
+      end;
+      Output (Socket);
+      Success := True;
+   end Send;
+
+   ----------------------------------------------------------------------------
+   -- Send_Pending
+   ----------------------------------------------------------------------------
+   function Send_Pending
+      (Socket : Socket_Type)
+      return Natural
+      is
+   begin
+      if Socket = NO_SOCKET then
+         return 0;
+      end if;
+      return TCBs (Socket).Snd_Bytes;
+   end Send_Pending;
+
+   ----------------------------------------------------------------------------
+   -- Receive
+   ----------------------------------------------------------------------------
+   procedure Receive
+      (Socket       : in     Socket_Type;
+       Data_Address : in     System.Address;
+       Size         : in     Natural;
+       Length       :    out Natural)
+      is
+      Chunk : Natural;
+   begin
+      Length := 0;
+      if Socket = NO_SOCKET then
+         return;
+      end if;
+      declare
+         T : TCB_Type renames TCBs (Socket);
+      begin
+         while Length < Size and then T.Rcv_Count > 0 loop
+            declare
+               R : Receive_Record_Type renames T.Rcv_Queue (T.Rcv_Head);
+            begin
+               Chunk := Natural'Min (R.Length - R.Consumed, Size - Length);
+               Copy_Partial (R.P, Data_Address + Storage_Offset (Length), Chunk, R.Offset + R.Consumed);
+               R.Consumed := @ + Chunk;
+               Length := @ + Chunk;
+               T.Rcv_Bytes := @ - Chunk;
+               if R.Consumed = R.Length then
+                  Free (R.P);
+                  T.Rcv_Head := (@ + 1) mod TCP_RCV_QUEUE;
+                  T.Rcv_Count := @ - 1;
+               end if;
+            end;
+         end loop;
+         -- window update, once it has opened enough to be worth a segment;
+         -- data accepted beyond the advertised edge (e.g. a zero-window
+         -- probe) leaves nothing of the old window outstanding
+         if Length > 0 and then
+            T.State in ESTABLISHED | FIN_WAIT_1 | FIN_WAIT_2 and then
+            Window_Available (Socket) -
+               (if Seq_LE (T.Rcv_Adv, T.Rcv_Nxt) then 0 else Natural (T.Rcv_Adv - T.Rcv_Nxt)) >=
+               Natural'Min (2 * T.MSS, TCP_RCV_BUFFER / 2)
+         then
+            Ack_Send (Socket);
+         end if;
+      end;
+   end Receive;
+
+   ----------------------------------------------------------------------------
+   -- Close
+   ----------------------------------------------------------------------------
+   procedure Close
+      (Socket : in Socket_Type)
+      is
+   begin
+      if Socket = NO_SOCKET or else not TCBs (Socket).Owned then
+         return;
+      end if;
+      declare
+         T : TCB_Type renames TCBs (Socket);
+      begin
+         T.Owned := False;
+         case T.State is
+            when LISTEN =>
+               for S in TCBs'Range loop
+                  if TCBs (S).In_Use and then TCBs (S).Listener = Socket then
+                     Reset_Send (
+                        TCBs (S).Remote_Address,
+                        TCBs (S).Local_Port,
+                        TCBs (S).Remote_Port,
+                        TCBs (S).Snd_Nxt,
+                        0,
+                        TH_RST
+                        );
+                     Release (S);
+                  end if;
+               end loop;
+               Release (Socket);
+            when CLOSED | SYN_SENT =>
+               Release (Socket);
+            when ESTABLISHED =>
+               T.Fin_Pending := True;
+               T.State := FIN_WAIT_1;
+               Output (Socket);
+            when CLOSE_WAIT =>
+               T.Fin_Pending := True;
+               T.State := LAST_ACK;
+               Output (Socket);
+            when FIN_WAIT_2 =>
+               T.Rtx_Armed := True;
+               T.Rtx_Deadline := TCP_Clock.Count + TCP_FIN_WAIT_2;
+            when others =>
+               null;
+         end case;
+      end;
+   end Close;
+
+   ----------------------------------------------------------------------------
+   -- State
+   ----------------------------------------------------------------------------
+   function State
+      (Socket : Socket_Type)
+      return State_Type
+      is
+   begin
+      if Socket = NO_SOCKET then
+         return CLOSED;
+      end if;
+      return TCBs (Socket).State;
+   end State;
+
+   ----------------------------------------------------------------------------
+   -- Service
+   ----------------------------------------------------------------------------
+   procedure Service
+      is
+      Clock : constant Unsigned_32 := TCP_Clock.Count;
+   begin
+      for S in TCBs'Range loop
+         if TCBs (S).In_Use then
+            if TCBs (S).Delack_Armed and then Timers.Expired (TCBs (S).Delack_Deadline, Clock) then
+               Ack_Send (S);
+            end if;
+            if TCBs (S).Rtx_Armed and then Timers.Expired (TCBs (S).Rtx_Deadline, Clock) then
+               TCBs (S).Rtx_Armed := False;
+               Timeout (S);
+            end if;
+         end if;
+      end loop;
+   end Service;
+
+   ----------------------------------------------------------------------------
+   -- Input
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 793 3.9 SEGMENT ARRIVES
+   ----------------------------------------------------------------------------
+   procedure Input
+      (P           : in Pbuf_Ptr;
+       Src_Address : in IPv4_Address_Type;
+       Length      : in Natural)
+      is
+      TCP_Header    : aliased TCP_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Src_Port      : constant Unsigned_16 := NToH (TCP_Header.Src_Port);
+      Dst_Port      : constant Unsigned_16 := NToH (TCP_Header.Dst_Port);
+      Seq_Num       : constant Unsigned_32 := NToH (TCP_Header.Seq_Num);
+      Ack_Num       : constant Unsigned_32 := NToH (TCP_Header.Ack_Num);
+      Window        : constant Unsigned_32 := Unsigned_32 (NToH (TCP_Header.Window_Size));
+      Header_Length : constant Natural := Natural (TCP_Header.HLen) * 4;
+      Data_Length   : constant Natural := Length - Header_Length;
+      ACK           : constant Boolean := To_B (TCP_Header.Ack);
+      RST           : constant Boolean := To_B (TCP_Header.Rst);
+      SYN           : constant Boolean := To_B (TCP_Header.Syn);
+      FIN           : constant Boolean := To_B (TCP_Header.Fin);
+      S             : Socket_Type := NO_SOCKET;
+      L             : Socket_Type := NO_SOCKET;
+      Success       : Boolean;
+   begin
+      -- demultiplex: connections first, then listeners
+      for Index in TCBs'Range loop
+         if TCBs (Index).In_Use and then TCBs (Index).Local_Port = Dst_Port then
+            if TCBs (Index).State = LISTEN then
+               L := Index;
+            elsif TCBs (Index).State /= CLOSED and then
+                  TCBs (Index).Remote_Port = Src_Port and then
+                  TCBs (Index).Remote_Address = Src_Address
+            then
+               S := Index;
+               exit;
+            end if;
+         end if;
+      end loop;
+      if S = NO_SOCKET and then L = NO_SOCKET then
+         -- no connection: answer with a reset (RFC 793 3.4)
+         if not RST then
+            if ACK then
+               Reset_Send (Src_Address, Dst_Port, Src_Port, Ack_Num, 0, TH_RST);
+            else
+               Reset_Send (
+                  Src_Address,
+                  Dst_Port,
+                  Src_Port,
+                  0,
+                  Seq_Num + Unsigned_32 (Data_Length) + (if SYN then 1 else 0) + (if FIN then 1 else 0),
+                  TH_RST or TH_ACK
+                  );
+            end if;
+         end if;
+         return;
+      end if;
+      -------------------------------------------------------------------------
+      if S = NO_SOCKET then
+         -- LISTEN
+         if RST then
+            return;
+         elsif ACK then
+            Reset_Send (Src_Address, Dst_Port, Src_Port, Ack_Num, 0, TH_RST);
+            return;
+         elsif not SYN then
+            return;
+         end if;
+         S := Socket_Allocate;
+         if S = NO_SOCKET then
+            -- no room: the peer will retry the SYN
+            return;
+         end if;
+         declare
+            T : TCB_Type renames TCBs (S);
+         begin
+            T.Listener       := L;
+            T.State          := SYN_RECEIVED;
+            T.Local_Port     := Dst_Port;
+            T.Remote_Port    := Src_Port;
+            T.Remote_Address := Src_Address;
+            T.MSS            := MSS_Option (P, Header_Length);
+            T.IRS            := Seq_Num;
+            T.Rcv_Nxt        := Seq_Num + 1;
+            T.Snd_Una        := T.ISS;
+            T.Snd_Nxt        := T.ISS + 1;
+            T.Snd_Max        := T.ISS + 1;
+            T.Snd_Wnd        := Window;
+            T.Snd_Wl1        := Seq_Num;
+            T.Ssthresh       := 16#FFFF#;
+            Segment_Send (S, T.ISS, 0, TH_SYN or TH_ACK, Success);
+            Rtx_Arm (S);
+         end;
+         return;
+      end if;
+      -------------------------------------------------------------------------
+      declare
+         T : TCB_Type renames TCBs (S);
+      begin
+         if T.State = SYN_SENT then
+            if ACK and then (Seq_LE (Ack_Num, T.ISS) or else Seq_LT (T.Snd_Max, Ack_Num)) then
+               if not RST then
+                  Reset_Send (Src_Address, Dst_Port, Src_Port, Ack_Num, 0, TH_RST);
+               end if;
+               return;
+            end if;
+            if RST then
+               if ACK then
+                  -- connection refused
+                  Release (S);
+               end if;
+               return;
+            end if;
+            if SYN then
+               T.MSS     := MSS_Option (P, Header_Length);
+               T.IRS     := Seq_Num;
+               T.Rcv_Nxt := Seq_Num + 1;
+               T.Snd_Wnd := Window;
+               T.Snd_Wl1 := Seq_Num;
+               T.Snd_Wl2 := Ack_Num;
+               T.Cwnd    := Unsigned_32 (Natural'Min (4 * T.MSS, Natural'Max (2 * T.MSS, 4_380)));
+               if ACK then
+                  T.Snd_Una   := Ack_Num;
+                  T.State     := ESTABLISHED;
+                  T.Rtx_Armed := False;
+                  T.Rtx_Count := 0;
+                  Ack_Send (S);
+               else
+                  -- simultaneous open
+                  T.State := SYN_RECEIVED;
+                  Segment_Send (S, T.ISS, 0, TH_SYN or TH_ACK, Success);
+               end if;
+            end if;
+            return;
+         end if;
+         -- synchronized states
+         if RST then
+            if Seq_LE (T.Rcv_Nxt, Seq_Num) and then Seq_LT (Seq_Num, T.Rcv_Adv + 1) then
+               Release (S);
+            end if;
+            return;
+         end if;
+         if SYN then
+            if T.State = SYN_RECEIVED and then Seq_Num = T.IRS then
+               -- our SYN,ACK was lost
+               Segment_Send (S, T.ISS, 0, TH_SYN or TH_ACK, Success);
+            else
+               Reset_Send (Src_Address, Dst_Port, Src_Port, T.Snd_Nxt, 0, TH_RST);
+               Release (S);
+            end if;
+            return;
+         end if;
+         if not ACK then
+            return;
+         end if;
+         if T.State = SYN_RECEIVED then
+            if Seq_LT (T.ISS, Ack_Num) and then Seq_LE (Ack_Num, T.Snd_Max) then
+               T.State     := ESTABLISHED;
+               T.Snd_Una   := T.ISS + 1;
+               T.Snd_Wl1   := Seq_Num - 1; -- accept the window below
+               T.Cwnd      := Unsigned_32 (Natural'Min (4 * T.MSS, Natural'Max (2 * T.MSS, 4_380)));
+               T.Rtx_Armed := False;
+               T.Rtx_Count := 0;
+            else
+               Reset_Send (Src_Address, Dst_Port, Src_Port, Ack_Num, 0, TH_RST);
+               return;
+            end if;
+         end if;
+         if Seq_LT (T.Snd_Max, Ack_Num) then
+            -- acknowledges something not yet sent
+            Ack_Send (S);
+            return;
+         end if;
+         Ack_Process (S, Seq_Num, Ack_Num, Window, Data_Length);
+         if Fin_Acked (S) then
+            case T.State is
+               when FIN_WAIT_1 =>
+                  T.State := FIN_WAIT_2;
+                  if not T.Owned then
+                     T.Rtx_Armed := True;
+                     T.Rtx_Deadline := TCP_Clock.Count + TCP_FIN_WAIT_2;
+                  end if;
+               when CLOSING =>
+                  T.State := TIME_WAIT;
+                  T.Rtx_Armed := True;
+                  T.Rtx_Deadline := TCP_Clock.Count + TCP_TIME_WAIT;
+               when LAST_ACK =>
+                  Release (S);
+                  return;
+               when others =>
+                  null;
+            end case;
+         end if;
+         Data_Process (S, P, Seq_Num, Header_Length, Data_Length, FIN);
+         Output (S);
+         if T.Ack_Now then
+            Ack_Send (S);
+         end if;
+      end;
+   end Input;
+
+end TCP_Sockets;
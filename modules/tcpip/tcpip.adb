@@ -16,7 +16,11 @@
 -----------------------------------------------------------------------------------------------------------------------
 
 with Ethernet;
-with Console;
+with INET_Checksum;
+with UDP_Sockets;
+with TCP_Sockets;
+with IPv4_Fragments;
+with Trace;
 
 package body TCPIP
    is
@@ -29,20 +33,34 @@ package body TCPIP
    --                                                                        --
    --========================================================================--
 
-   function Checksum_Core_U32
-      (Data : Byte_A2Array)
-      return Unsigned_32;
-   function Checksum
-      (Data        : Byte_A2Array;
-       Sum_Initial : Unsigned_32 := 0)
-      return Unsigned_16;
+   use INET_Checksum;
 
+   IPv4_TTL : constant := 64;
+
+   -- ICMP errors are built in the first pbuf of a chain: headers, plus
+   -- the offending IPv4 header with options and 8 bytes of its payload
+   pragma Compile_Time_Error (
+      PBUF_PAYLOAD_SIZE < Ethernet.ETH_HDR_SIZE + IPv4_HDR_SIZE + ICMP_HDR_SIZE + 60 + 8,
+      "PBUF_PAYLOAD_SIZE too small for ICMP errors"
+      );
+
+   IPv4_Identification : Unsigned_16 := 0;
+
+   procedure ICMP_Unreachable_Send
+      (P    : in Pbuf_Ptr;
+       Code : in Unsigned_8);
+   procedure Reply_Addresses
+      (P       : in     Pbuf_Ptr;
+       Old_Sum :    out Sum_Type;
+       New_Sum :    out Sum_Type);
    procedure ICMP_Handler
       (P : in Pbuf_Ptr);
    procedure UDP_Handler
       (P : in Pbuf_Ptr);
    procedure TCP_Handler
       (P : in Pbuf_Ptr);
+   procedure Protocol_Dispatch
+      (P : in Pbuf_Ptr);
 
    --========================================================================--
    --                                                                        --
@@ -53,59 +71,73 @@ package body TCPIP
    --========================================================================--
 
    ----------------------------------------------------------------------------
-   -- Checksum_Core_U32
+   -- Reply_Addresses
    ----------------------------------------------------------------------------
-   -- Basic network-order 16-bit data checksum computation.
-   -- __REF__ RFC 1071
+   -- Turn the IPv4 header at the current payload of P into the header of a
+   -- reply, patching its checksum; Old_Sum and New_Sum are the partial
+   -- sums of the address fields, to patch upper-layer checksums as well.
    ----------------------------------------------------------------------------
-   function Checksum_Core_U32
-      (Data : Byte_A2Array)
-      return Unsigned_32
+   procedure Reply_Addresses
+      (P       : in     Pbuf_Ptr;
+       Old_Sum :    out Sum_Type;
+       New_Sum :    out Sum_Type)
       is
-      Sum    : Unsigned_32 := 0;
-      Length : Natural := Data'Length;
-      Index  : Integer := Data'First;
-      Data16 : U16_Array (Data'First .. Natural'Last)
-         with Address    => Data'Address,
+      IPv4_Header : aliased IPv4_Header_Type
+         with Address    => Payload_CurrentAddress (P),
               Import     => True,
               Convention => Ada;
    begin
-      while Length > 1 loop
-         Sum := @ + Unsigned_32 (Data16 (Index));
-         Index := @ + 1;
-         Length := @ - 2;
-      end loop;
-      if Length /= 0 then
-         Sum := @ + Unsigned_32 (HToN (Unsigned_16 (Data (Data'Last)) * 2**8));
-      end if;
-      return Sum;
-   end Checksum_Core_U32;
+      -- Src_Address and Dst_Address are contiguous
+      Old_Sum := Sum (IPv4_Header.Src_Address'Address, 8);
+      IPv4_Header.Dst_Address := IPv4_Header.Src_Address;
+      -- answer from the interface the request came in
+      IPv4_Header.Src_Address := Ethernet.Descriptor_Get (Ethernet.Current_Interface).Paddress;
+      New_Sum := Sum (IPv4_Header.Src_Address'Address, 8);
+      IPv4_Header.Header_Checksum := Update (IPv4_Header.Header_Checksum, Old_Sum, New_Sum);
+   end Reply_Addresses;
 
    ----------------------------------------------------------------------------
-   -- Checksum
+   -- ICMP_Unreachable_Send
    ----------------------------------------------------------------------------
-   -- Compute 1's-complement 16-bit IP checksum using Checksum_Core_U32.
-   -- __REF__ RFC 1071
+   -- __REF__ RFC 792, RFC 1122 3.2.2.1
+   -- Report the IPv4 packet at the current payload of P as undeliverable
+   -- to its sender.
    ----------------------------------------------------------------------------
-   function Checksum
-      (Data        : Byte_A2Array;
-       Sum_Initial : Unsigned_32 := 0)
-      return Unsigned_16
+   procedure ICMP_Unreachable_Send
+      (P    : in Pbuf_Ptr;
+       Code : in Unsigned_8)
       is
-      Sum  : Unsigned_32;
-      HSum : Unsigned_16;
+      HEADROOM     : constant := Ethernet.ETH_HDR_SIZE + IPv4_HDR_SIZE;
+      IPv4_Header  : aliased IPv4_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Quote_Length : Natural;
+      Q            : Pbuf_Ptr;
    begin
-      Sum := Sum_Initial + Checksum_Core_U32 (Data);
-      loop
-         HSum := HWord (Sum);
-         if HSum /= 0 then
-            Sum := Unsigned_32 (HSum) + Unsigned_32 (LWord (@));
-         else
-            exit;
-         end if;
-      end loop;
-      return not LWord (Sum);
-   end Checksum;
+      Quote_Length := Natural'Min (Natural (IPv4_Header.IHL) * 4 + 8, P.all.Total_Size);
+      Q := Allocate (HEADROOM + ICMP_HDR_SIZE + Quote_Length);
+      if Q = null then
+         return;
+      end if;
+      Payload_Adjust (Q, -(HEADROOM + ICMP_HDR_SIZE));
+      Copy_Partial (P, Payload_CurrentAddress (Q), Quote_Length);
+      Payload_Adjust (Q, +ICMP_HDR_SIZE);
+      declare
+         ICMP_Header : aliased ICMP_Header_Type
+            with Address    => Payload_CurrentAddress (Q),
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         ICMP_Header.Typ          := ICMP_PORT_UNREACHABLE;
+         ICMP_Header.Code         := Code;
+         ICMP_Header.Checksum     := 0;
+         ICMP_Header.Restofheader := 0;
+         ICMP_Header.Checksum     := Finalize (Sum (Q, ICMP_HDR_SIZE + Quote_Length));
+      end;
+      IPv4_Output (Q, ICMP, IPv4_Header.Src_Address);
+      Free (Q);
+   end ICMP_Unreachable_Send;
 
    ----------------------------------------------------------------------------
    -- ICMP_Handler
@@ -119,41 +151,52 @@ package body TCPIP
          with Address    => Payload_CurrentAddress (P),
               Import     => True,
               Convention => Ada;
+      Old_Sum     : Sum_Type;
+      New_Sum     : Sum_Type;
    begin
       case ICMP_Header.Typ is
          when ICMP_ECHO_REQUEST =>
-            if Checksum (P.all.Payload (P.all.Offset .. P.all.Offset + P.all.Total_Size - 1)) /= 0 then
-               Console.Print ("ICMP packet checksum error", NL => True);
+            if Finalize (Sum (P, P.all.Total_Size)) /= 0 then
+               Trace.Event (Trace.LEVEL_ERROR, Trace.ICMP_CHECKSUM_ERROR);
             end if;
-            Console.Print (LWord (NToH (ICMP_Header.Restofheader)), Prefix => "ICMP sequence #", NL => True);
+            Trace.Event (Trace.LEVEL_DEBUG, Trace.ICMP_ECHO_REQUEST, NToH (ICMP_Header.Restofheader));
+            -- exploit received packet: only type and code change, patch
+            -- the checksum instead of summing the whole message again
+            Old_Sum := Sum (ICMP_Header'Address, 2);
             ICMP_Header.Typ      := ICMP_ECHO_REPLY;
             ICMP_Header.Code     := 0;
-            ICMP_Header.Checksum := 0;
-            ICMP_Header.Checksum := Checksum (P.all.Payload (P.all.Offset .. P.all.Offset + P.all.Total_Size - 1));
-            -- __FIX__ exploit received packet: change src/dst IP, compute checksum
+            ICMP_Header.Checksum := Update (ICMP_Header.Checksum, Old_Sum, Sum (ICMP_Header'Address, 2));
             Payload_Rewind (P);
+            Reply_Addresses (P, Old_Sum, New_Sum);
             declare
-               IPv4_Header   : aliased IPv4_Header_Type
+               IPv4_Header : aliased IPv4_Header_Type
                   with Address    => Payload_CurrentAddress (P),
                        Import     => True,
                        Convention => Ada;
-               Header_Length : Natural;
             begin
-               IPv4_Header.Dst_Address     := IPv4_Header.Src_Address;
-               IPv4_Header.Src_Address     := Ethernet.Descriptor_Get.Paddress;
-               IPv4_Header.Header_Checksum := 0;
-               Header_Length := Natural (IPv4_Header.IHL) * 4;
-               IPv4_Header.Header_Checksum := Checksum (P.all.Payload (P.all.Offset .. P.all.Offset + Header_Length - 1));
+               if Natural (NToH (IPv4_Header.Total_Length)) > Ethernet.Descriptor_Get (Ethernet.Current_Interface).MTU then
+                  -- the request was reassembled, fragment the reply too
+                  IPv4_Fragments.Output (
+                     P,
+                     IPv4_Header.Dst_Address,
+                     Ethernet.Descriptor_Get (Ethernet.Current_Interface).MTU
+                     );
+                  return;
+               end if;
             end;
             Payload_Adjust (P, +Ethernet.ETH_HDR_SIZE);
-            P.all.Payload (0 .. 5)  := P.all.Payload (6 .. 11);          -- target MAC is sender MAC
-            P.all.Payload (6 .. 11) := Ethernet.Descriptor_Get.Haddress; -- sender = myself
-            Ethernet.TX (P);
+            P.all.Payload (0 .. 5)  := P.all.Payload (6 .. 11);                                       -- target MAC is sender MAC
+            P.all.Payload (6 .. 11) := Ethernet.Descriptor_Get (Ethernet.Current_Interface).Haddress; -- sender = myself
+            Ethernet.TX (Ethernet.Current_Interface, P);
          when ICMP_PORT_UNREACHABLE =>
-            Console.Print ("ICMP: port unreachable", NL => True);
+            Trace.Event (Trace.LEVEL_INFO, Trace.ICMP_PORT_UNREACHABLE);
          when others =>
-            Console.Print (ICMP_Header.Typ, Prefix => "ICMP: typ:  ", NL => True);
-            Console.Print (ICMP_Header.Code, Prefix => "ICMP: code: ", NL => True);
+            Trace.Event (
+               Trace.LEVEL_INFO,
+               Trace.ICMP_OTHER,
+               Unsigned_32 (ICMP_Header.Typ),
+               Unsigned_32 (ICMP_Header.Code)
+               );
       end case;
    end ICMP_Handler;
 
@@ -169,104 +212,188 @@ package body TCPIP
          with Address    => Payload_CurrentAddress (P),
               Import     => True,
               Convention => Ada;
-      Checksum_Header : Unsigned_32;
+      Checksum_Header : Sum_Type := 0;
       Checksum_Total  : Unsigned_16;
+      Src_Address     : IPv4_Address_Type;
+      Dst_Address     : IPv4_Address_Type;
+      Delivered       : Boolean;
    begin
-      if UDP_Header.Checksum /= 0 then
-         -- checksum was used : build an IPv4 "pseudo" header
-         -- 1) build a "pseudo" header in memory
-         -- 2) compute checksum of the "pseudo" header
-         -- 3) compute a complete checksum
-         Payload_Rewind (P); -- uncover IP header
-         declare
-            IPv4_Header      : aliased IPv4_Header_Type with
-               Address    => Payload_CurrentAddress (P),
-               Import     => True,
-               Convention => Ada;
-            Pseudo_Header    : aliased UDP_IPv4_PseudoHeader_Type;
-            Pseudo_Header_BA : Byte_A2Array (1 .. UDP_IPv4_PseudoHeader_SIZE) with
-               Address => Pseudo_Header'Address;
-         begin
+      if Natural (NToH (UDP_Header.Length)) < UDP_HDR_SIZE or else
+         Natural (NToH (UDP_Header.Length)) > P.all.Total_Size
+      then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.UDP_LENGTH_ERROR, Unsigned_32 (NToH (UDP_Header.Length)));
+         return;
+      end if;
+      Payload_Rewind (P); -- uncover IP header
+      declare
+         IPv4_Header   : aliased IPv4_Header_Type with
+            Address    => Payload_CurrentAddress (P),
+            Import     => True,
+            Convention => Ada;
+         Pseudo_Header : aliased UDP_IPv4_PseudoHeader_Type;
+      begin
+         Src_Address := IPv4_Header.Src_Address;
+         Dst_Address := IPv4_Header.Dst_Address;
+         if UDP_Header.Checksum /= 0 then
+            -- checksum was used : build an IPv4 "pseudo" header
+            -- 1) build a "pseudo" header in memory
+            -- 2) compute checksum of the "pseudo" header
+            -- 3) compute a complete checksum
             Pseudo_Header.Src_Address := IPv4_Header.Src_Address;
             Pseudo_Header.Dst_Address := IPv4_Header.Dst_Address;
             Pseudo_Header.Zeroes      := 0;
             Pseudo_Header.Protocol    := IPv4_Header.Protocol;
             Pseudo_Header.Length      := UDP_Header.Length;
-            Checksum_Header := Checksum_Core_U32 (Pseudo_Header_BA);
-         end;
-         Payload_Rewind (P); -- restore UDP header
-         Checksum_Total := Checksum (
-                              P.all.Payload (P.all.Offset .. P.all.Offset + P.all.Total_Size - 1),
-                              Checksum_Header
-                              );
-         if Checksum_Total = 0 then
-            Console.Print ("UDP checksum OK.", NL => True);
-         else
-            Console.Print (Checksum_Total, Prefix => "*** Error: UDP checksum:", NL => True);
+            Checksum_Header := Sum (Pseudo_Header'Address, UDP_IPv4_PseudoHeader_SIZE);
+         end if;
+      end;
+      Payload_Rewind (P); -- restore UDP header
+      if UDP_Header.Checksum /= 0 then
+         Checksum_Total := Finalize (Sum (P, Natural (NToH (UDP_Header.Length)), Checksum_Header));
+         if Checksum_Total /= 0 then
+            Trace.Event (Trace.LEVEL_ERROR, Trace.UDP_CHECKSUM_ERROR, Unsigned_32 (Checksum_Total));
+            return;
          end if;
       end if;
-      Console.Print (NToH (UDP_Header.Src_Port), Prefix => "SRC PORT: ", NL => True);
-      Console.Print (NToH (UDP_Header.Dst_Port), Prefix => "DST PORT: ", NL => True);
-      -------------------------------------------------------------------------
-      -- TX a response
-      -- __FIX__ exploit received packet: change src/dst IP, compute checksum
-      -- dst port remains the same (we send to the dst of this message)
+      -- demultiplex by destination port
+      UDP_Sockets.Deliver (P, Src_Address, Delivered);
+      if not Delivered and then Ethernet.Is_Local (Dst_Address) then
+         -- no listener, report only datagrams sent to us, not broadcasts
+         Payload_Rewind (P); -- uncover IP header
+         ICMP_Unreachable_Send (P, ICMP_CODE_PORT_UNREACHABLE);
+      end if;
+   end UDP_Handler;
+
+   ----------------------------------------------------------------------------
+   -- TCP_Handler
+   ----------------------------------------------------------------------------
+   -- __REF__ RFC 793
+   ----------------------------------------------------------------------------
+   procedure TCP_Handler
+      (P : in Pbuf_Ptr)
+      is
+      TCP_Header      : aliased TCP_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Checksum_Header : Sum_Type;
+      Segment_Length  : Integer;
+      Src_Address     : IPv4_Address_Type;
+      Dst_Address     : IPv4_Address_Type;
+   begin
       Payload_Rewind (P); -- uncover IP header
       declare
-         IPv4_Header      : aliased IPv4_Header_Type
-            with Address    => Payload_CurrentAddress (P),
-                 Import     => True,
-                 Convention => Ada;
-         IP_Header_Length : Natural;
-         Pseudo_Header    : aliased UDP_IPv4_PseudoHeader_Type;
-         Pseudo_Header_BA : aliased Byte_A2Array (1 .. UDP_IPv4_PseudoHeader_SIZE)
-            with Address    => Pseudo_Header'Address,
-                 Import     => True,
-                 Convention => Ada;
+         IPv4_Header   : aliased IPv4_Header_Type with
+            Address    => Payload_CurrentAddress (P),
+            Import     => True,
+            Convention => Ada;
+         Pseudo_Header : aliased TCP_IPv4_PseudoHeader_Type;
       begin
-         IPv4_Header.Dst_Address     := IPv4_Header.Src_Address;
-         IPv4_Header.Src_Address     := Ethernet.Descriptor_Get.Paddress;
-         IPv4_Header.Header_Checksum := 0;
-         IP_Header_Length := Natural (IPv4_Header.IHL) * 4;
-         IPv4_Header.Header_Checksum := Checksum (P.all.Payload (P.all.Offset .. P.all.Offset + IP_Header_Length - 1));
+         -- the frame may be padded, trust only the IPv4 length
+         Segment_Length := Integer (NToH (IPv4_Header.Total_Length)) - Integer (IPv4_Header.IHL) * 4;
+         Src_Address := IPv4_Header.Src_Address;
+         Dst_Address := IPv4_Header.Dst_Address;
          Pseudo_Header.Src_Address := IPv4_Header.Src_Address;
          Pseudo_Header.Dst_Address := IPv4_Header.Dst_Address;
          Pseudo_Header.Zeroes      := 0;
          Pseudo_Header.Protocol    := IPv4_Header.Protocol;
-         Pseudo_Header.Length      := UDP_Header.Length;
-         Checksum_Header := Checksum_Core_U32 (Pseudo_Header_BA);
+         Pseudo_Header.Length      := HToN (Unsigned_16 (Integer'Max (Segment_Length, 0)));
+         Checksum_Header := Sum (Pseudo_Header'Address, TCP_IPv4_PseudoHeader_SIZE);
       end;
-      Payload_Rewind (P); -- restore UDP header
-      UDP_Header.Checksum := 0;
-      Checksum_Total := Checksum (
-                           P.all.Payload (P.all.Offset .. P.all.Offset + P.all.Total_Size - 1),
-                           Checksum_Header
-                           );
-      UDP_Header.Checksum := Checksum_Total;
-      Payload_Rewind (P);                                          -- uncover IP header
-      Payload_Adjust (P, +Ethernet.ETH_HDR_SIZE);
-      P.all.Payload (0 .. 5)  := P.all.Payload (6 .. 11);          -- target MAC is sender MAC
-      P.all.Payload (6 .. 11) := Ethernet.Descriptor_Get.Haddress; -- sender = myself
-      Ethernet.TX (P);
-   end UDP_Handler;
+      Payload_Rewind (P); -- restore TCP header
+      if Segment_Length < TCP_HDR_SIZE or else
+         Segment_Length > P.all.Total_Size or else
+         Natural (TCP_Header.HLen) * 4 < TCP_HDR_SIZE or else
+         Natural (TCP_Header.HLen) * 4 > Segment_Length
+      then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.TCP_LENGTH_ERROR, Unsigned_32 (Segment_Length));
+         return;
+      end if;
+      if not Ethernet.Is_Local (Dst_Address) then
+         return;
+      end if;
+      if Finalize (Sum (P, Segment_Length, Checksum_Header)) /= 0 then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.TCP_CHECKSUM_ERROR);
+         return;
+      end if;
+      TCP_Sockets.Input (P, Src_Address, Segment_Length);
+   end TCP_Handler;
 
    ----------------------------------------------------------------------------
-   -- TCP_Handler
+   -- IPv4_Output
    ----------------------------------------------------------------------------
-   -- __REF__ RFC 793
+   procedure IPv4_Output
+      (P           : in Pbuf_Ptr;
+       Protocol    : in Unsigned_8;
+       Dst_Address : in IPv4_Address_Type)
+      is
+      Id       : Ethernet.Interface_Id_Type;
+      Next_Hop : IPv4_Address_Type;
+   begin
+      Ethernet.Route_Lookup (Dst_Address, Id, Next_Hop);
+      if Id = Ethernet.NO_INTERFACE then
+         -- no route to host
+         return;
+      end if;
+      Payload_Adjust (P, +IPv4_HDR_SIZE);
+      declare
+         IPv4_Header : aliased IPv4_Header_Type
+            with Address    => Payload_CurrentAddress (P),
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         IPv4_Header := (
+            Version              => 4,
+            IHL                  => IPv4_HDR_SIZE / 4,
+            DSCP                 => 0,
+            ECN                  => 0,
+            Total_Length         => HToN (Unsigned_16 (P.all.Total_Size)),
+            Identification       => HToN (IPv4_Identification),
+            Flags                => 0,
+            Fragmentation_Offset => 0,
+            TTL                  => IPv4_TTL,
+            Protocol             => Protocol,
+            Header_Checksum      => 0,
+            Src_Address          => Ethernet.Descriptor_Get (Id).Paddress,
+            Dst_Address          => Dst_Address
+            );
+         IPv4_Header.Header_Checksum := Finalize (Sum (IPv4_Header'Address, IPv4_HDR_SIZE));
+      end;
+      IPv4_Identification := @ + 1;
+      if P.all.Total_Size > Ethernet.Descriptor_Get (Id).MTU then
+         IPv4_Fragments.Output (P, Dst_Address, Ethernet.Descriptor_Get (Id).MTU);
+      else
+         Ethernet.Output (P, Id, Next_Hop);
+      end if;
+   end IPv4_Output;
+
    ----------------------------------------------------------------------------
-   procedure TCP_Handler
+   -- Protocol_Dispatch
+   ----------------------------------------------------------------------------
+   -- Hand the payload of the verified, whole IPv4 datagram at the current
+   -- payload of P to its transport protocol.
+   ----------------------------------------------------------------------------
+   procedure Protocol_Dispatch
       (P : in Pbuf_Ptr)
       is
-      TCP_Header : aliased TCP_Header_Type
+      IPv4_Header : aliased IPv4_Header_Type
          with Address    => Payload_CurrentAddress (P),
               Import     => True,
               Convention => Ada;
    begin
-      Console.Print (NToH (TCP_Header.Src_Port), Prefix => "SRC PORT: ", NL => True);
-      Console.Print (NToH (TCP_Header.Dst_Port), Prefix => "DST PORT: ", NL => True);
-      Console.Print (NToH (TCP_Header.Seq_Num), Prefix => "SEQ: ", NL => True);
-   end TCP_Handler;
+      Payload_Adjust (P, -(Natural (IPv4_Header.IHL) * 4));
+      Trace.Event (Trace.LEVEL_DEBUG, Trace.IPV4_PROTOCOL, Unsigned_32 (IPv4_Header.Protocol));
+      case IPv4_Header.Protocol is
+         when ICMP =>
+            ICMP_Handler (P);
+         when UDP  =>
+            UDP_Handler (P);
+         when TCP  =>
+            TCP_Handler (P);
+         when others =>
+            null;
+      end case;
+   end Protocol_Dispatch;
 
    ----------------------------------------------------------------------------
    -- IPv4_Handler
@@ -279,32 +406,28 @@ package body TCPIP
               Import     => True,
               Convention => Ada;
       IP_Header_Length : Natural; -- i.e. offset to start of payload
+      Datagram         : Pbuf_Ptr;
    begin
       IP_Header_Length := Natural (IPv4_Header.IHL) * 4;
-      if Checksum (P.all.Payload (P.all.Offset .. P.all.Offset + IP_Header_Length - 1)) /= 0 then
-         Console.Print ("IP packet checksum error", NL => True);
+      if Finalize (Sum (P, IP_Header_Length)) /= 0 then
+         Trace.Event (Trace.LEVEL_ERROR, Trace.IPV4_CHECKSUM_ERROR);
          return;
       end if;
       if IPv4_Header.Version /= 4 then
-         Console.Print ("IP packet version error", NL => True);
+         Trace.Event (Trace.LEVEL_ERROR, Trace.IPV4_VERSION_ERROR, Unsigned_32 (IPv4_Header.Version));
          return;
       end if;
-      Payload_Adjust (P, -IP_Header_Length);
-      case IPv4_Header.Protocol is
-         when ICMP =>
-            Console.Print ("ICMP", NL => True);
-            ICMP_Handler (P);
-         when IGMP =>
-            Console.Print ("IGMP", NL => True);
-         when UDP  =>
-            Console.Print ("UDP", NL => True);
-            UDP_Handler (P);
-         when TCP  =>
-            Console.Print ("TCP", NL => True);
-            TCP_Handler (P);
-         when others =>
-            Console.Print ("UNKNOWN", NL => True);
-      end case;
+      if IPv4_Header.Fragmentation_Offset /= 0 or else
+         (IPv4_Header.Flags and IPv4_Fragments.IPv4_FLAG_MF) /= 0
+      then
+         IPv4_Fragments.Reassemble (P, Datagram);
+         if Datagram /= null then
+            Protocol_Dispatch (Datagram);
+            Free (Datagram);
+         end if;
+         return;
+      end if;
+      Protocol_Dispatch (P);
    end IPv4_Handler;
 
 end TCPIP;
@@ -0,0 +1,320 @@
+-----------------------------------------------------------------------------------------------------------------------
+--                                                     SweetAda                                                      --
+-----------------------------------------------------------------------------------------------------------------------
+-- __HDS__                                                                                                           --
+-- __FLN__ udp_sockets.adb                                                                                           --
+-- __DSC__                                                                                                           --
+-- __HSH__ e69de29bb2d1d6434b8b29ae775ad8c2e48c5391                                                                  --
+-- __HDE__                                                                                                           --
+-----------------------------------------------------------------------------------------------------------------------
+-- Copyright (C) 2020-2026 Gabriele Galeotti                                                                         --
+--                                                                                                                   --
+-- SweetAda web page: http://sweetada.org                                                                            --
+-- contact address: gabriele.galeotti@sweetada.org                                                                   --
+-- This work is licensed under the terms of the MIT License.                                                         --
+-- Please consult the LICENSE.txt file located in the top-level directory.                                           --
+-----------------------------------------------------------------------------------------------------------------------
+
+with Bits;
+with Rings;
+with INET_Checksum;
+with Ethernet;
+
+package body UDP_Sockets
+   is
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Local declarations                           --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   use Bits;
+   use INET_Checksum;
+
+   type Datagram_Type is record
+      P       : Pbuf_Ptr;          -- current payload at the data
+      Length  : Natural;           -- data length, w/o padding
+      Address : IPv4_Address_Type; -- sender
+      Port    : Unsigned_16;       -- sender
+   end record;
+
+   package Datagram_Rings is new Rings (Datagram_Type, UDP_QUEUE_SIZE);
+
+   type Socket_Descriptor_Type is record
+      Port  : Unsigned_16 := 0; -- 0 = free
+      Drops : Unsigned_32 := 0;
+      Queue : aliased Datagram_Rings.Ring_Type;
+   end record;
+
+   Sockets : array (Socket_Type range 1 .. Socket_Type'Last) of Socket_Descriptor_Type;
+
+   -- open-addressing port table, linear probing; at least twice the
+   -- number of sockets, so that a probe sequence always ends on a hole
+   PORT_SLOTS : constant := 16;
+
+   pragma Compile_Time_Error (
+      PORT_SLOTS < 2 * UDP_NSOCKETS or else (Unsigned_16 (PORT_SLOTS) and (Unsigned_16 (PORT_SLOTS) - 1)) /= 0,
+      "PORT_SLOTS must be a power of two, at least twice UDP_NSOCKETS"
+      );
+
+   subtype Port_Slot_Type is Unsigned_16 range 0 .. PORT_SLOTS - 1;
+
+   Port_Table : array (Port_Slot_Type) of Socket_Type := [others => NO_SOCKET];
+
+   function Port_Hash
+      (Port : Unsigned_16)
+      return Port_Slot_Type
+      with Inline => True;
+   procedure Port_Insert
+      (Socket : in Socket_Type);
+   function Port_Lookup
+      (Port : Unsigned_16)
+      return Socket_Type;
+
+   --========================================================================--
+   --                                                                        --
+   --                                                                        --
+   --                           Package subprograms                          --
+   --                                                                        --
+   --                                                                        --
+   --========================================================================--
+
+   ----------------------------------------------------------------------------
+   -- Port_Hash
+   ----------------------------------------------------------------------------
+   function Port_Hash
+      (Port : Unsigned_16)
+      return Port_Slot_Type
+      is
+   begin
+      return (Port xor Shift_Right (Port, 4) xor Shift_Right (Port, 8)) and (PORT_SLOTS - 1);
+   end Port_Hash;
+
+   ----------------------------------------------------------------------------
+   -- Port_Insert
+   ----------------------------------------------------------------------------
+   procedure Port_Insert
+      (Socket : in Socket_Type)
+      is
+      Slot : Port_Slot_Type;
+   begin
+      Slot := Port_Hash (Sockets (Socket).Port);
+      while Port_Table (Slot) /= NO_SOCKET loop
+         Slot := (Slot + 1) and (PORT_SLOTS - 1);
+      end loop;
+      Port_Table (Slot) := Socket;
+   end Port_Insert;
+
+   ----------------------------------------------------------------------------
+   -- Port_Lookup
+   ----------------------------------------------------------------------------
+   function Port_Lookup
+      (Port : Unsigned_16)
+      return Socket_Type
+      is
+      Slot : Port_Slot_Type;
+   begin
+      Slot := Port_Hash (Port);
+      while Port_Table (Slot) /= NO_SOCKET loop
+         if Sockets (Port_Table (Slot)).Port = Port then
+            return Port_Table (Slot);
+         end if;
+         Slot := (Slot + 1) and (PORT_SLOTS - 1);
+      end loop;
+      return NO_SOCKET;
+   end Port_Lookup;
+
+   ----------------------------------------------------------------------------
+   -- Bind
+   ----------------------------------------------------------------------------
+   procedure Bind
+      (Port   : in     Unsigned_16;
+       Socket :    out Socket_Type)
+      is
+   begin
+      Socket := NO_SOCKET;
+      if Port = 0 or else Port_Lookup (Port) /= NO_SOCKET then
+         return;
+      end if;
+      for Index in Sockets'Range loop
+         if Sockets (Index).Port = 0 then
+            Sockets (Index).Port := Port;
+            Sockets (Index).Drops := 0;
+            Port_Insert (Index);
+            Socket := Index;
+            exit;
+         end if;
+      end loop;
+   end Bind;
+
+   ----------------------------------------------------------------------------
+   -- Close
+   ----------------------------------------------------------------------------
+   procedure Close
+      (Socket : in Socket_Type)
+      is
+      Datagram : Datagram_Type;
+      Success  : Boolean;
+   begin
+      if Socket = NO_SOCKET or else Sockets (Socket).Port = 0 then
+         return;
+      end if;
+      loop
+         Datagram_Rings.Get (Sockets (Socket).Queue'Access, Datagram, Success);
+         exit when not Success;
+         Free (Datagram.P);
+      end loop;
+      Sockets (Socket).Port := 0;
+      -- removing a key from a linear-probing table would break the probe
+      -- sequences that cross its slot: rebuild the (tiny) table instead
+      Port_Table := [others => NO_SOCKET];
+      for Index in Sockets'Range loop
+         if Sockets (Index).Port /= 0 then
+            Port_Insert (Index);
+         end if;
+      end loop;
+   end Close;
+
+   ----------------------------------------------------------------------------
+   -- Send_To
+   ----------------------------------------------------------------------------
+   procedure Send_To
+      (Socket       : in     Socket_Type;
+       Address      : in     IPv4_Address_Type;
+       Port         : in     Unsigned_16;
+       Data_Address : in     System.Address;
+       Length       : in     Natural;
+       Success      :    out Boolean)
+      is
+      HEADROOM      : constant := Ethernet.ETH_HDR_SIZE + IPv4_HDR_SIZE + UDP_HDR_SIZE;
+      P             : Pbuf_Ptr;
+      Pseudo_Header : aliased UDP_IPv4_PseudoHeader_Type;
+   begin
+      Success := False;
+      if Socket = NO_SOCKET or else Sockets (Socket).Port = 0 or else Length > UDP_PAYLOAD_SIZE then
+         return;
+      end if;
+      P := Allocate (HEADROOM + Length);
+      if P = null then
+         return;
+      end if;
+      Payload_Adjust (P, -HEADROOM);
+      Take (P, Data_Address, Length);
+      Payload_Adjust (P, +UDP_HDR_SIZE);
+      declare
+         UDP_Header : aliased UDP_Header_Type
+            with Address    => Payload_CurrentAddress (P),
+                 Import     => True,
+                 Convention => Ada;
+      begin
+         UDP_Header := (
+            Src_Port => HToN (Sockets (Socket).Port),
+            Dst_Port => HToN (Port),
+            Length   => HToN (Unsigned_16 (UDP_HDR_SIZE + Length)),
+            Checksum => 0
+            );
+         Pseudo_Header := (
+            Src_Address => Ethernet.Source_Address (Address),
+            Dst_Address => Address,
+            Zeroes      => 0,
+            Protocol    => UDP,
+            Length      => UDP_Header.Length
+            );
+         UDP_Header.Checksum := Finalize (
+            Sum (P, UDP_HDR_SIZE + Length, Sum (Pseudo_Header'Address, UDP_IPv4_PseudoHeader_SIZE))
+            );
+         if UDP_Header.Checksum = 0 then
+            -- 0 means "no checksum", transmit it as all ones
+            UDP_Header.Checksum := 16#FFFF#;
+         end if;
+      end;
+      IPv4_Output (P, UDP, Address);
+      Free (P);
+      Success := True;
+   end Send_To;
+
+   ----------------------------------------------------------------------------
+   -- Receive_From
+   ----------------------------------------------------------------------------
+   procedure Receive_From
+      (Socket  : in     Socket_Type;
+       P       :    out Pbuf_Ptr;
+       Length  :    out Natural;
+       Address :    out IPv4_Address_Type;
+       Port    :    out Unsigned_16;
+       Success :    out Boolean)
+      is
+      Datagram : Datagram_Type;
+   begin
+      P       := null;
+      Length  := 0;
+      Address := [others => 0];
+      Port    := 0;
+      Success := False;
+      if Socket = NO_SOCKET or else Sockets (Socket).Port = 0 then
+         return;
+      end if;
+      Datagram_Rings.Get (Sockets (Socket).Queue'Access, Datagram, Success);
+      if Success then
+         P       := Datagram.P;
+         Length  := Datagram.Length;
+         Address := Datagram.Address;
+         Port    := Datagram.Port;
+      end if;
+   end Receive_From;
+
+   ----------------------------------------------------------------------------
+   -- Drops
+   ----------------------------------------------------------------------------
+   function Drops
+      (Socket : Socket_Type)
+      return Unsigned_32
+      is
+   begin
+      if Socket = NO_SOCKET then
+         return 0;
+      end if;
+      return Sockets (Socket).Drops;
+   end Drops;
+
+   ----------------------------------------------------------------------------
+   -- Deliver
+   ----------------------------------------------------------------------------
+   procedure Deliver
+      (P           : in     Pbuf_Ptr;
+       Src_Address : in     IPv4_Address_Type;
+       Delivered   :    out Boolean)
+      is
+      UDP_Header : aliased UDP_Header_Type
+         with Address    => Payload_CurrentAddress (P),
+              Import     => True,
+              Convention => Ada;
+      Socket     : Socket_Type;
+      Datagram   : Datagram_Type;
+      Success    : Boolean;
+   begin
+      Socket := Port_Lookup (NToH (UDP_Header.Dst_Port));
+      Delivered := Socket /= NO_SOCKET;
+      if not Delivered then
+         return;
+      end if;
+      Datagram := (
+         P       => P,
+         Length  => Natural (NToH (UDP_Header.Length)) - UDP_HDR_SIZE,
+         Address => Src_Address,
+         Port    => NToH (UDP_Header.Src_Port)
+         );
+      -- the socket keeps the pbuf beyond the caller's reference
+      Payload_Adjust (P, -UDP_HDR_SIZE);
+      Reference (P);
+      Datagram_Rings.Put (Sockets (Socket).Queue'Access, Datagram, Success);
+      if not Success then
+         Free (P);
+         Sockets (Socket).Drops := @ + 1;
+      end if;
+   end Deliver;
+
+end UDP_Sockets;
@@ -112,6 +112,10 @@ package body A2065
    -- starting RX buffer
    RX_Buffer_Index : Natural := 0;
 
+   -- LANCE interrupts masked while the receive ring is drained by Poll
+   RX_Polling : Boolean := False
+      with Atomic => True;
+
    --========================================================================--
    --                                                                        --
    --                                                                        --
@@ -292,6 +296,7 @@ package body A2065
          CSR0,
          To_U16 (CSR0_Type'(
             STRT   => True,
+            INEA   => True,
             others => False
             ))
          );
@@ -305,7 +310,6 @@ package body A2065
       is
       Result       : Boolean;
       A2065_Status : CSR0_Type;
-      P            : PBUF.Pbuf_Ptr;
       function To_U16 is new Ada.Unchecked_Conversion (CSR0_Type, Unsigned_16);
       function To_CSR0 is new Ada.Unchecked_Conversion (Unsigned_16, CSR0_Type);
    begin
@@ -329,39 +333,21 @@ package body A2065
             Result := True;
             -- Console.Print ("A2065: Initialization done.", NL => True);
          elsif A2065_Status.RINT then
-            loop
-               exit when not Receive_Ring (RX_Buffer_Index).RMD1.OWN;
-               RX_Buffer_Index := (RX_Buffer_Index + 1) mod 2**RDR_ORDER;
-            end loop;
-            -- __FIX__ check for errors
+            -- acknowledge and mask, the ring is drained by Poll
+            RX_Polling := True;
             Register_Write (
                Am7990_Descriptor,
                CSR0,
                To_U16 (CSR0_Type'(
-                  TXON   => True,
-                  RXON   => True,
                   BABL   => True,
                   MISS   => True,
                   MERR   => True,
-                  TINT   => False,
                   RINT   => True,
+                  INEA   => False,
                   others => False
                   ))
                );
-            -- Console.Print (Natural (Receive_Ring (RX_Buffer_Index).RMD3.MCNT), Prefix => "RECEIVE = ", NL => True);
-            P := PBUF.Allocate (Natural (Receive_Ring (RX_Buffer_Index).RMD3.MCNT) - 4); -- discard FCS
-            Memory_Functions.Cpymem (
-               Receive_Buffers (RX_Buffer_Index)'Address,
-               PBUF.Payload_Address (P),
-               Bytesize (Receive_Ring (RX_Buffer_Index).RMD3.MCNT - 4)
-               );
-            -- Receive_Ring (RX_Buffer_Index).RMD3.MCNT := 0; ???
-            Receive_Ring (RX_Buffer_Index).RMD1.OWN := True;
-            declare
-               Success : Boolean;
-            begin
-               Enqueue (Packet_Queue'Access, P, Success);
-            end;
+            Poll_Schedule (A2065_Interface_Id);
             Result := True;
          elsif A2065_Status.TINT then
             Register_Write (
@@ -375,6 +361,7 @@ package body A2065
                   MERR   => True,
                   TINT   => True,
                   RINT   => False,
+                  INEA   => not RX_Polling,
                   others => False
                   ))
                );
@@ -385,6 +372,81 @@ package body A2065
       return Result;
    end Receive;
 
+   ----------------------------------------------------------------------------
+   -- Poll
+   ----------------------------------------------------------------------------
+   procedure Poll
+      (Data_Address : in     System.Address;
+       Budget       : in     Positive;
+       Done         :    out Boolean)
+      is
+      pragma Unreferenced (Data_Address);
+      Count : Natural;
+      Size  : Natural;
+      P     : PBUF.Pbuf_Ptr;
+      function To_U16 is new Ada.Unchecked_Conversion (CSR0_Type, Unsigned_16);
+   begin
+      Done := True;
+      Count := 0;
+      loop
+         -- descriptors still owned by the LANCE: ring empty
+         exit when Receive_Ring (RX_Buffer_Index).RMD1.OWN;
+         if Count = Budget then
+            Done := False;
+            exit;
+         end if;
+         Count := @ + 1;
+         if not Receive_Ring (RX_Buffer_Index).RMD1.ERR and then
+            Receive_Ring (RX_Buffer_Index).RMD1.STP     and then
+            Receive_Ring (RX_Buffer_Index).RMD1.ENP
+         then
+            Size := Natural (Receive_Ring (RX_Buffer_Index).RMD3.MCNT) - 4; -- discard FCS
+            P := PBUF.Allocate (Size);
+            if P /= null then
+               -- a full-size frame spans a pbuf chain
+               PBUF.Take (P, Receive_Buffers (RX_Buffer_Index)'Address, Size);
+               declare
+                  Success : Boolean;
+               begin
+                  Input (A2065_Interface_Id, P, Success);
+                  if not Success then
+                     PBUF.Free (P);
+                  end if;
+               end;
+            end if;
+         end if;
+         -- give the descriptor back to the LANCE
+         Receive_Ring (RX_Buffer_Index).RMD1.OWN := True;
+         RX_Buffer_Index := (RX_Buffer_Index + 1) mod 2**RDR_ORDER;
+      end loop;
+      if Done then
+         -- acknowledge first, then look again: a frame completed in between
+         -- would otherwise be acknowledged without being received
+         Register_Write (
+            Am7990_Descriptor,
+            CSR0,
+            To_U16 (CSR0_Type'(
+               RINT   => True,
+               INEA   => False,
+               others => False
+               ))
+            );
+         if Receive_Ring (RX_Buffer_Index).RMD1.OWN then
+            RX_Polling := False;
+            Register_Write (
+               Am7990_Descriptor,
+               CSR0,
+               To_U16 (CSR0_Type'(
+                  INEA   => True,
+                  others => False
+                  ))
+               );
+         else
+            Done := False;
+         end if;
+      end if;
+   end Poll;
+
    ----------------------------------------------------------------------------
    -- Transmit
    ----------------------------------------------------------------------------
@@ -410,17 +472,17 @@ package body A2065
       Transmit_Ring (0).TMD1.ENP := True;
       Transmit_Ring (0).TMD1.STP := True;
       Transmit_Ring (0).TMD1.OWN := True;
+      -- leave RINT pending and interrupts masked while Poll is draining
       Register_Write (
          Am7990_Descriptor,
          CSR0,
          To_U16 (CSR0_Type'(
-            TXON   => True,
-            RXON   => True,
+            TDMD   => True,
+            INEA   => not RX_Polling,
             BABL   => True,
             MISS   => True,
             MERR   => True,
             TINT   => True,
-            RINT   => True,
             others => False
             ))
          );
@@ -159,11 +159,21 @@ package body BSP is
             Read_8        => MMIO.Read'Access,
             Write_8       => MMIO.Write'Access,
             Read_16       => MMIO.ReadA'Access,
-            Write_16      => MMIO.WriteA'Access
+            Write_16      => MMIO.WriteA'Access,
+            others        => <>
             );
-         IDE.Init (IDE_Descriptor);
          -- disable IDE interrupts
          Gayle.IDE_Devcon.IRQDISABLE := True;
+         IDE.Init (IDE_Descriptor);
+         IDE_Block_Device := (
+            Block_Size   => IDE.SECTOR_SIZE,
+            Max_Transfer => IDE.BLOCK_MAX_TRANSFER,
+            Read_Blocks  => IDE.Read_Blocks'Access,
+            Write_Blocks => IDE.Write_Blocks'Access,
+            Flush        => IDE.Flush'Access,
+            Map_Blocks   => null,
+            Data_Address => IDE_Descriptor'Address
+            );
       end if;
       -- system timer initialization ------------------------------------------
       Tclk_Init;
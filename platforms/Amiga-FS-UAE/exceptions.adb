@@ -22,6 +22,7 @@ with MMIO;
 with Amiga;
 with BSP;
 with Gdbstub;
+with Timers;
 with A2065;
 with Console;
 
@@ -103,6 +104,16 @@ package body Exceptions
             if BSP.Tick_Count mod 500 = 0 then
                CIAA.PRA.PA1 := not @;
             end if;
+            -- network timers (ARP aging, reassembly, TCP, DHCP); a level 2
+            -- IRQ does not mask the higher levels
+            declare
+               Intcontext : Intcontext_Type;
+            begin
+               Intcontext_Get (Intcontext);
+               Irq_Disable;
+               Timers.Process;
+               Intcontext_Set (Intcontext);
+            end;
             -- clear pending interrupt
             Unused := CIAA.ICR;
          end if;
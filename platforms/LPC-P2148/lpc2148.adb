@@ -55,7 +55,7 @@ package body LPC2148
          Flags         => (PC_UART => False),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART0_Descriptor);
    end UART0_Init;
@@ -88,7 +88,7 @@ package body BSP
          Flags         => (PC_UART => False),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART1_Descriptor);
       UART16x50.Baud_Rate_Set (UART1_Descriptor, Baud_Rate_Type'Enum_Rep (BR_115200));
@@ -100,7 +100,7 @@ package body BSP
          Flags         => (PC_UART => False),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART2_Descriptor);
       UART16x50.Baud_Rate_Set (UART2_Descriptor, Baud_Rate_Type'Enum_Rep (BR_115200));
@@ -107,7 +107,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (PIIX4_UART1_Descriptor);
       PIIX4_UART2_Descriptor := (
@@ -118,7 +118,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (PIIX4_UART2_Descriptor);
       -- Console --------------------------------------------------------------
@@ -166,7 +166,7 @@ package body BSP
          Flags         => (PC_UART => False),
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (CBUS_UART_Descriptor);
       -- PIIX4 IDE ------------------------------------------------------------
@@ -176,9 +176,19 @@ package body BSP
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
          Read_16       => MMIO.ReadA'Access,
-         Write_16      => MMIO.WriteA'Access
+         Write_16      => MMIO.WriteA'Access,
+         others        => <>
          );
       IDE.Init (PIIX4_IDE_Descriptor);
+      PIIX4_IDE_Block_Device := (
+         Block_Size   => IDE.SECTOR_SIZE,
+         Max_Transfer => IDE.BLOCK_MAX_TRANSFER,
+         Read_Blocks  => IDE.Read_Blocks'Access,
+         Write_Blocks => IDE.Write_Blocks'Access,
+         Flush        => IDE.Flush'Access,
+         Map_Blocks   => null,
+         Data_Address => PIIX4_IDE_Descriptor'Address
+         );
       -- VGA ------------------------------------------------------------------
       -- assume PCI0MEM0 memory space @ 0
       VGA.Init (MIPS.KSEG1_ADDRESS + 16#000A_0000#, MIPS.KSEG1_ADDRESS + 16#000B_8000#);
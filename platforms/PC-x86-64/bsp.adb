@@ -152,7 +152,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => IO_Read'Access,
          Write_8       => IO_Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART_Descriptors (1));
       UART16x50.Baud_Rate_Set (UART_Descriptors (1), Baud_Rate_Type'Enum_Rep (BR_19200));
@@ -164,7 +164,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => IO_Read'Access,
          Write_8       => IO_Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART_Descriptors (2));
       UART16x50.Baud_Rate_Set (UART_Descriptors (2), Baud_Rate_Type'Enum_Rep (BR_19200));
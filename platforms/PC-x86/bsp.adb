@@ -34,6 +34,10 @@ with Interrupts;
 with PC;
 with PIIX;
 with PCICAN;
+with IPv4_Fragments;
+with TCP_Sockets;
+with DHCP_Client;
+with Trace;
 with VGA;
 with Console;
 
@@ -58,6 +62,10 @@ package body BSP
    use i586;
    use APIC;
 
+   -- Bus Master IDE registers, past the 256-byte NE2000 BAR0 at 16#C000#
+   -- (QEMU ne2k_pci) and below the PCICAN windows at 16#D000#
+   IDE_BMIBA : constant := 16#C100#;
+
    function Number_Of_CPUs
       return Interfaces.C.int
       with Export        => True,
@@ -71,6 +79,9 @@ package body BSP
       (Addr  : in Address;
        Value : in Unsigned_32);
 
+   function Trace_Timestamp
+      return Unsigned_32;
+
    procedure Board_Init;
 
    --========================================================================--
@@ -111,6 +122,16 @@ package body BSP
       CPU.IO.PortOut (Unsigned_16 (To_Integer (Addr) and 16#0000_FFFF#), Value);
    end PCI_Write_32;
 
+   ----------------------------------------------------------------------------
+   -- Trace_Timestamp
+   ----------------------------------------------------------------------------
+   function Trace_Timestamp
+      return Unsigned_32
+      is
+   begin
+      return Tick_Count;
+   end Trace_Timestamp;
+
    ----------------------------------------------------------------------------
    -- Tclk_Init
    ----------------------------------------------------------------------------
@@ -164,6 +185,7 @@ package body BSP
       Exceptions.Init;
       MMU.Init;
       Board_Init;
+      Trace.Timestamp_Set (Trace_Timestamp'Access);
       -- RTC ------------------------------------------------------------------
       RTC_Descriptor := (
          Base_Address  => System'To_Address (PC.RTC_BASEADDRESS),
@@ -182,7 +204,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => IO_Read'Access,
          Write_8       => IO_Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART_Descriptors (1));
       UART_Descriptors (2) := (
@@ -193,7 +215,7 @@ package body BSP
          Flags         => (PC_UART => True),
          Read_8        => IO_Read'Access,
          Write_8       => IO_Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0)
+         Data_Queue    => <>
          );
       UART16x50.Init (UART_Descriptors (2));
       -- Console --------------------------------------------------------------
@@ -291,6 +313,12 @@ package body BSP
       if PIIX.Probe (PCI_Descriptor) then
          Console.Print ("PIIX3 detected", NL => True);
          PIIX.Init (PCI_Descriptor);
+         PIIX.IDE_Bus_Master_Init (PCI_Descriptor, IDE_BMIBA);
+         IDE_DMA_Descriptors (1) := (
+            BM_Address => System'To_Address (IDE_BMIBA),
+            Write_32   => IO_Write'Access,
+            others     => <>
+            );
       end if;
       -- PPI ------------------------------------------------------------------
       PC.PPI_Init;
@@ -310,9 +338,20 @@ package body BSP
          Read_8        => IO_Read'Access,
          Write_8       => IO_Write'Access,
          Read_16       => IO_Read'Access,
-         Write_16      => IO_Write'Access
+         Write_16      => IO_Write'Access,
+         DMA           => (if IDE_DMA_Descriptors (1).Write_32 /= null then IDE_DMA_Descriptors (1)'Access else null),
+         others        => <>
          );
       IDE.Init (IDE_Descriptors (1));
+      IDE_Block_Devices (1) := (
+         Block_Size   => IDE.SECTOR_SIZE,
+         Max_Transfer => IDE.BLOCK_MAX_TRANSFER,
+         Read_Blocks  => IDE.Read_Blocks'Access,
+         Write_Blocks => IDE.Write_Blocks'Access,
+         Flush        => IDE.Flush'Access,
+         Map_Blocks   => null,
+         Data_Address => IDE_Descriptors (1)'Address
+         );
       -- NE2000 (PCI) ---------------------------------------------------------
       if True then
          declare
@@ -334,7 +373,8 @@ package body BSP
                   Write_16      => PortOut'Access,
                   Read_32       => PortIn'Access,
                   Write_32      => PortOut'Access,
-                  Next_Ptr      => 0
+                  Next_Ptr      => 0,
+                  others        => <>
                   );
                NE2000.Init_PCI (PCI_Descriptor, NE2000_Descriptors (1));
             end if;
@@ -344,11 +384,33 @@ package body BSP
       Ethernet_Descriptor := (
          Haddress     => NE2000_Descriptors (1).MAC,
          Paddress     => (if QEMU then [192, 168, 3, 2] else [192, 168, 2, 2]),
+         Netmask      => [255, 255, 255, 0],
          RX           => null,
          TX           => NE2000.Transmit'Access,
+         Poll         => NE2000.Poll'Access,
+         MTU          => Ethernet.ETH_MTU,
          Data_Address => NE2000_Descriptors (1)'Address
          );
-      Ethernet.Init (Ethernet_Descriptor);
+      Ethernet.Init;
+      Ethernet.Interface_Add (Ethernet_Descriptor, NE2000_Descriptors (1).Interface_Id);
+      -- loopback interface, 127.0.0.1/8
+      Loopback_Ethernet := (
+         Haddress     => Loopback.LOOPBACK_MAC,
+         Paddress     => [127, 0, 0, 1],
+         Netmask      => [255, 0, 0, 0],
+         RX           => null,
+         TX           => Loopback.Transmit'Access,
+         Poll         => Loopback.Poll'Access,
+         MTU          => Ethernet.ETH_MTU,
+         Data_Address => Loopback_Descriptor'Address
+         );
+      Loopback.Init (Loopback_Descriptor);
+      Ethernet.Interface_Add (Loopback_Ethernet, Loopback_Descriptor.Interface_Id);
+      Ethernet.ARP_Aging_Start (Configure.TICK_FREQUENCY); -- 1 s
+      TCP_Sockets.Timer_Start (Configure.TICK_FREQUENCY * TCP_Sockets.TCP_TICK_MS / 1_000);
+      IPv4_Fragments.Timer_Start (Configure.TICK_FREQUENCY); -- 1 s
+      DHCP_Client.Timer_Start (Configure.TICK_FREQUENCY);    -- 1 s
+      Loopback.Timer_Start (1);                              -- loopback Latency unit
       -- CAN (PCI) ------------------------------------------------------------
       declare
          Device_Number : PCI.Device_Number_Type;
@@ -373,6 +435,9 @@ package body BSP
       -- UART2
       PC.PIC_Irq_Enable (PC.PIC_Irq3);
       Interrupts.Install (PC.PIC_Irq3, UART16x50.Receive'Access, UART_Descriptors (2)'Address);
+      -- IDE
+      PC.PIC_Irq_Enable (PC.PIC_Irq14);
+      Interrupts.Install (PC.PIC_Irq14, IDE.Interrupt_Handler'Access, IDE_Descriptors (1)'Address);
       -- NE2000
       PC.PIC_Irq_Enable (PC.PIC_Irq5);
       Interrupts.Install (PC.PIC_Irq5, NE2000.Interrupt_Handler'Access, NE2000_Descriptors (1)'Address);
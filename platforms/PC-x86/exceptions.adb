@@ -18,6 +18,7 @@
 with Interfaces;
 with Abort_Library;
 with Interrupts;
+with Timers;
 with BSP;
 with GDT_Simple;
 with PC;
@@ -178,6 +179,7 @@ package body Exceptions
                      ));
                end if;
             end if;
+            Timers.Process;
             PC.PIC1_EOI;
          when PC.PIC_Irq3 =>
             Interrupts.Handler (PC.PIC_Irq3);
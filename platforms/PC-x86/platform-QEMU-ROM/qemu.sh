@@ -12,6 +12,7 @@
 #
 # Arguments:
 # -debug
+# -bench
 #
 # Environment variables:
 # OSTYPE
@@ -21,6 +22,8 @@
 # KERNEL_ROMFILE
 # TERMINAL
 # GDB
+# NETBENCH_OUTFILE
+# USE_DHCP
 #
 
 ################################################################################
@@ -100,6 +103,17 @@ TILTIMEOUT=3
 # IP address for qemu-ifup.sh
 export QEMU_IPADDRESS="192.168.3.1"
 
+# IP address of the guest, see BSP
+GUEST_IPADDRESS="192.168.3.2"
+
+# network options: TAP link to the host, or, when the guest runs DHCP
+# (USE_DHCP), the user-mode network, whose DHCP server hands out 10.0.2.15
+if [ "x${USE_DHCP}" = "xTrue" ] ; then
+  QEMU_NETWORK_OPTIONS="id=qemu,type=user"
+else
+  QEMU_NETWORK_OPTIONS="id=qemu,type=tap,script=${SHARE_DIRECTORY}/qemu-ifup.sh,downscript=${SHARE_DIRECTORY}/qemu-ifdown.sh"
+fi
+
 # QEMU machine
 "${QEMU_EXECUTABLE}" \
   -M pc -cpu pentium3 -m 256 -vga std \
@@ -111,7 +125,7 @@ export QEMU_IPADDRESS="192.168.3.1"
   -chardev "socket,id=SERIALPORT1,port=${SERIALPORT1},host=localhost,ipv4=on,server=on,telnet=on,wait=on" \
   -serial "chardev:SERIALPORT1" \
   -device "ne2k_pci,netdev=qemu,mac=02:00:00:11:22:33" \
-  -netdev "id=qemu,type=tap,script=${SHARE_DIRECTORY}/qemu-ifup.sh,downscript=${SHARE_DIRECTORY}/qemu-ifdown.sh" \
+  -netdev "${QEMU_NETWORK_OPTIONS}" \
   -device "ide-hd,drive=disk,bus=ide.0" \
   -drive "id=disk,if=none,format=raw,file=${PLATFORM_DIRECTORY}/disk.dsk" \
   -usb -device "usb-hub,bus=usb-bus.0,port=1" \
@@ -164,6 +178,14 @@ if [ "x$1" = "x-debug" ] ; then
     '
 fi
 
+# network benchmark, then shut down
+if [ "x$1" = "x-bench" ] ; then
+  python3 "${SHARE_DIRECTORY}"/netbench.py \
+    ${GUEST_IPADDRESS} \
+    "${NETBENCH_OUTFILE:-netbench.json}"
+  kill ${QEMU_PID}
+fi
+
 # wait QEMU termination
 wait ${QEMU_PID}
 
@@ -21,6 +21,7 @@ with Interfaces;
 with Bits;
 with ARMv8A;
 with Virt;
+with Timers;
 with BSP;
 with Console;
 
@@ -76,6 +77,7 @@ package body Exceptions
       BSP.Tick_Count := @ + 1;
       Virt.GICD.GICD_ICPENDR (0)(30) := True;
       BSP.Timer_Reload;
+      Timers.Process;
    end Irq_Process;
 
    ----------------------------------------------------------------------------
@@ -21,6 +21,8 @@
 # KERNEL_ROMFILE
 # TERMINAL
 # GDB
+# RAMDISK_FILENAME (optional, RAM disk image)
+# RAMDISK_BASEADDRESS
 #
 
 ################################################################################
@@ -84,6 +86,13 @@ else
   QEMU_DEBUG=
 fi
 
+# RAM disk image
+if [ "x${RAMDISK_FILENAME}" != "x" ] ; then
+  QEMU_RAMDISK="-device loader,file=${RAMDISK_FILENAME},addr=${RAMDISK_BASEADDRESS},force-raw=on"
+else
+  QEMU_RAMDISK=
+fi
+
 # telnet port numbers and listening timeout in s
 MONITORPORT=4445
 SERIALPORT0=4446
@@ -102,6 +111,7 @@ TILTIMEOUT=3
   -serial "chardev:SERIALPORT0" \
   -chardev "socket,id=SERIALPORT1,port=${SERIALPORT1},host=localhost,ipv4=on,server=on,telnet=on,wait=on" \
   -serial "chardev:SERIALPORT1" \
+  ${QEMU_RAMDISK} \
   ${QEMU_DEBUG} \
   &
 QEMU_PID=$!
@@ -24,6 +24,8 @@ with RISCV;
 with MTIME;
 with Virt;
 with Exceptions;
+with IPv4_Fragments;
+with TCP_Sockets;
 with Console;
 
 package body BSP
@@ -86,7 +88,7 @@ package body BSP
          Baud_Clock    => CLK_UART3M6,
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0),
+         Data_Queue    => <>,
          others        => <>
          );
       UART16x50.Init (UART_Descriptor);
@@ -109,6 +111,42 @@ package body BSP
       if Core.Debug_Flag then
          Console.Print ("Debug_Flag: ENABLED", NL => True);
       end if;
+      -- RAM disk -------------------------------------------------------------
+      RAMDisk_Descriptor := (
+         Base_Address => System'To_Address (Configure.RAMDISK_BASEADDRESS),
+         Size         => Configure.RAMDISK_SIZE,
+         Read_Only    => False
+         );
+      if RAMDisk.Probe (RAMDisk_Descriptor) then
+         RAMDisk_Block_Device := (
+            Block_Size   => RAMDisk.RAMDISK_BLOCK_SIZE,
+            Max_Transfer => Configure.RAMDISK_SIZE / RAMDisk.RAMDISK_BLOCK_SIZE,
+            Read_Blocks  => RAMDisk.Read_Blocks'Access,
+            Write_Blocks => RAMDisk.Write_Blocks'Access,
+            Flush        => null,
+            Map_Blocks   => RAMDisk.Map_Blocks'Access,
+            Data_Address => RAMDisk_Descriptor'Address
+            );
+         Console.Print ("RAM disk detected", NL => True);
+      end if;
+      -- loopback interface, 127.0.0.1/8 --------------------------------------
+      Loopback_Ethernet := (
+         Haddress     => Loopback.LOOPBACK_MAC,
+         Paddress     => [127, 0, 0, 1],
+         Netmask      => [255, 0, 0, 0],
+         RX           => null,
+         TX           => Loopback.Transmit'Access,
+         Poll         => Loopback.Poll'Access,
+         MTU          => Ethernet.ETH_MTU,
+         Data_Address => Loopback_Descriptor'Address
+         );
+      Ethernet.Init;
+      Loopback.Init (Loopback_Descriptor);
+      Ethernet.Interface_Add (Loopback_Ethernet, Loopback_Descriptor.Interface_Id);
+      Ethernet.ARP_Aging_Start (Configure.TICK_FREQUENCY); -- 1 s
+      TCP_Sockets.Timer_Start (Configure.TICK_FREQUENCY * TCP_Sockets.TCP_TICK_MS / 1_000);
+      IPv4_Fragments.Timer_Start (Configure.TICK_FREQUENCY); -- 1 s
+      Loopback.Timer_Start (1);                              -- loopback Latency unit
       -------------------------------------------------------------------------
       Exceptions.Init;
       -------------------------------------------------------------------------
@@ -21,6 +21,7 @@ with Bits;
 with LLutils;
 with RISCV;
 with MTIME;
+with Timers;
 with BSP;
 with Console;
 
@@ -62,6 +63,7 @@ package body Exceptions
                BSP.Tick_Count := @ + 1;
                BSP.Timer_Value := @ + BSP.Timer_Constant;
                MTIME.mtimecmp_Write (BSP.Timer_Value);
+               Timers.Process;
             when EXC_SWINT    =>
                -- Machine software interrupt
                null;
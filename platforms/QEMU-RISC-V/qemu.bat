@@ -23,6 +23,8 @@ REM KERNEL_ROMFILE
 REM TERMINAL
 REM PUTTY
 REM GDB
+REM RAMDISK_FILENAME (optional, RAM disk image)
+REM RAMDISK_BASEADDRESS
 REM
 
 REM ############################################################################
@@ -56,6 +58,13 @@ IF "%1"=="-debug" (
   SET "QEMU_DEBUG="
   )
 
+REM RAM disk image
+IF NOT "%RAMDISK_FILENAME%"=="" (
+  SET "QEMU_RAMDISK=-device loader,file=%RAMDISK_FILENAME%,addr=%RAMDISK_BASEADDRESS%,force-raw=on"
+  ) ELSE (
+  SET "QEMU_RAMDISK="
+  )
+
 REM telnet port numbers and listening timeout in s
 SET MONITORPORT=4445
 SET SERIALPORT0=4446
@@ -71,6 +80,7 @@ START "QEMU" %QEMU_EXECUTABLE% ^
   -serial chardev:SERIALPORT0 ^
   -chardev socket,id=SERIALPORT1,port=%SERIALPORT1%,host=localhost,ipv4=on,server=on,telnet=on,wait=on ^
   -serial chardev:SERIALPORT1 ^
+  %QEMU_RAMDISK% ^
   %QEMU_DEBUG%
 IF NOT "%ERRORLEVEL%"=="0" (
   ECHO *** Error: executing %QEMU_EXECUTABLE%.>&2
@@ -90,7 +90,7 @@ package body BSP
          Baud_Clock    => CLK_UART1M8,
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0),
+         Data_Queue    => <>,
          others        => <>
          );
       UART16x50.Init (UART1_Descriptor);
@@ -101,7 +101,7 @@ package body BSP
          Baud_Clock    => CLK_UART1M8,
          Read_8        => MMIO.Read'Access,
          Write_8       => MMIO.Write'Access,
-         Data_Queue    => ([others => 0], 0, 0, 0),
+         Data_Queue    => <>,
          others        => <>
          );
       UART16x50.Init (UART2_Descriptor);
@@ -0,0 +1,328 @@
+#!/usr/bin/env python3
+
+#
+# ICMP/UDP network benchmark, host side.
+#
+# Copyright (C) 2020-2026 Gabriele Galeotti
+#
+# This work is licensed under the terms of the MIT License.
+# Please consult the LICENSE.txt file located in the top-level directory.
+#
+
+#
+# Arguments:
+# $1 = IPv4 address of the target
+# $2 = results filename (JSON)
+#
+# Environment variables:
+# NETBENCH_SIZES   (payload sizes, comma-separated)
+# NETBENCH_COUNT   (requests per test)
+# NETBENCH_WINDOW  (requests in flight)
+# NETBENCH_TIMEOUT (reply timeout, in s)
+#
+
+#
+# For every payload size, floods the target with ICMP echo requests and
+# with UDP datagrams to the echo port (RFC 862), keeping NETBENCH_WINDOW
+# requests in flight, and reports replies per second, round-trip time
+# percentiles and lost requests. The target statistics port answers with
+# its stack counters, sampled around each test so that drops can be
+# attributed to the NIC, the packet queue or the UDP socket.
+#
+# ICMP uses an unprivileged datagram socket if the kernel allows it
+# (net.ipv4.ping_group_range), otherwise a raw socket, which needs root.
+#
+
+################################################################################
+# Script initialization.                                                       #
+#                                                                              #
+################################################################################
+
+import sys
+# avoid generation of *.pyc
+sys.dont_write_bytecode = True
+import os
+
+SCRIPT_FILENAME = os.path.basename(sys.argv[0])
+
+################################################################################
+#                                                                              #
+################################################################################
+
+import json
+import math
+import select
+import socket
+import struct
+import time
+
+UDP_ECHO_PORT  = 7
+UDP_STATS_PORT = 9001
+
+# target counters, 32-bit big-endian words
+STATS_NAMES = [
+    'eth_rx_frames',
+    'eth_rx_bytes',
+    'eth_rx_dropped',
+    'eth_tx_frames',
+    'eth_tx_bytes',
+    'nic_rx_frames',
+    'nic_rx_dropped',
+    'udp_echo_drops'
+    ]
+
+ICMP_ECHO_REQUEST = 8
+ICMP_ECHO_REPLY   = 0
+
+# helper function
+def printf(format, *args):
+    sys.stdout.write(format % args)
+# helper function
+def errprintf(format, *args):
+    sys.stderr.write(format % args)
+
+################################################################################
+# inet_checksum()                                                              #
+#                                                                              #
+################################################################################
+def inet_checksum(data):
+    if len(data) % 2 != 0:
+        data = data + b'\x00'
+    total = sum(struct.unpack('!%dH' % (len(data) // 2), data))
+    while total > 0xFFFF:
+        total = (total & 0xFFFF) + (total >> 16)
+    return ~total & 0xFFFF
+
+################################################################################
+# percentile()                                                                 #
+#                                                                              #
+# Nearest-rank percentile of a sorted list.                                    #
+################################################################################
+def percentile(values, p):
+    if len(values) == 0:
+        return None
+    rank = max(1, math.ceil(p / 100.0 * len(values)))
+    return values[min(rank, len(values)) - 1]
+
+################################################################################
+# stats_get()                                                                  #
+#                                                                              #
+################################################################################
+def stats_get(target, timeout):
+    s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    s.settimeout(timeout)
+    try:
+        s.sendto(b'STATS', (target, UDP_STATS_PORT))
+        data, _ = s.recvfrom(1024)
+    except (socket.timeout, OSError):
+        return None
+    finally:
+        s.close()
+    if len(data) < 4 * len(STATS_NAMES):
+        return None
+    return dict(zip(STATS_NAMES, struct.unpack('!%dI' % len(STATS_NAMES), data[:4 * len(STATS_NAMES)])))
+
+################################################################################
+# stats_delta()                                                                #
+#                                                                              #
+################################################################################
+def stats_delta(before, after):
+    if before is None or after is None:
+        return None
+    return {name: (after[name] - before[name]) & 0xFFFFFFFF for name in STATS_NAMES}
+
+################################################################################
+# IcmpProbe                                                                    #
+#                                                                              #
+################################################################################
+class IcmpProbe:
+    def __init__(self, target):
+        self.target = target
+        self.identifier = os.getpid() & 0xFFFF
+        try:
+            self.s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM, socket.IPPROTO_ICMP)
+            self.raw = False
+        except PermissionError:
+            self.s = socket.socket(socket.AF_INET, socket.SOCK_RAW, socket.IPPROTO_ICMP)
+            self.raw = True
+        self.s.setblocking(False)
+    def send(self, sequence, payload):
+        header = struct.pack('!BBHHH', ICMP_ECHO_REQUEST, 0, 0, self.identifier, sequence)
+        checksum = inet_checksum(header + payload)
+        header = struct.pack('!BBHHH', ICMP_ECHO_REQUEST, 0, checksum, self.identifier, sequence)
+        self.s.sendto(header + payload, (self.target, 0))
+    def receive(self):
+        data, address = self.s.recvfrom(65536)
+        if address[0] != self.target:
+            return None
+        if self.raw:
+            data = data[(data[0] & 0x0F) * 4:]
+        if len(data) < 8:
+            return None
+        typ, _, _, identifier, sequence = struct.unpack('!BBHHH', data[:8])
+        if typ != ICMP_ECHO_REPLY:
+            return None
+        # a datagram socket rewrites the identifier
+        if self.raw and identifier != self.identifier:
+            return None
+        return sequence
+    def close(self):
+        self.s.close()
+
+################################################################################
+# UdpProbe                                                                     #
+#                                                                              #
+################################################################################
+class UdpProbe:
+    def __init__(self, target):
+        self.target = target
+        self.s = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.s.connect((target, UDP_ECHO_PORT))
+        self.s.setblocking(False)
+    def send(self, sequence, payload):
+        # the sequence number travels in the first 2 bytes of the payload
+        self.s.send(struct.pack('!H', sequence) + payload[2:])
+    def receive(self):
+        data = self.s.recv(65536)
+        if len(data) < 2:
+            return None
+        return struct.unpack('!H', data[:2])[0]
+    def close(self):
+        self.s.close()
+
+################################################################################
+# run_test()                                                                   #
+#                                                                              #
+################################################################################
+def run_test(probe, size, count, window, timeout):
+    payload = bytes((i & 0xFF for i in range(max(size, 2))))
+    in_flight = {}
+    rtts = []
+    sent = 0
+    lost = 0
+    sequence = 0
+    time_start = time.perf_counter()
+    while sent < count or len(in_flight) > 0:
+        now = time.perf_counter()
+        # expire requests without reply
+        for s in [s for s, t in in_flight.items() if now - t > timeout]:
+            del in_flight[s]
+            lost += 1
+        # keep the window full
+        while sent < count and len(in_flight) < window:
+            sequence = (sequence + 1) & 0xFFFF
+            try:
+                probe.send(sequence, payload)
+            except BlockingIOError:
+                break
+            in_flight[sequence] = time.perf_counter()
+            sent += 1
+        readable, _, _ = select.select([probe.s], [], [], 0.01)
+        while readable:
+            try:
+                reply = probe.receive()
+            except (BlockingIOError, ConnectionRefusedError):
+                break
+            now = time.perf_counter()
+            if reply is not None and reply in in_flight:
+                rtts.append(now - in_flight.pop(reply))
+    elapsed = time.perf_counter() - time_start
+    rtts.sort()
+    def us(value):
+        return None if value is None else round(value * 1e6, 1)
+    return {
+        'size':        size,
+        'sent':        sent,
+        'received':    len(rtts),
+        'lost':        lost,
+        'elapsed_s':   round(elapsed, 6),
+        'pps':         round(len(rtts) / elapsed, 1) if elapsed > 0 else 0.0,
+        'rtt_min_us':  us(rtts[0] if rtts else None),
+        'rtt_p50_us':  us(percentile(rtts, 50)),
+        'rtt_p99_us':  us(percentile(rtts, 99)),
+        'rtt_max_us':  us(rtts[-1] if rtts else None)
+        }
+
+################################################################################
+# Main loop.                                                                   #
+#                                                                              #
+################################################################################
+
+#
+# Basic input parameters check.
+#
+if len(sys.argv) < 3:
+    errprintf('%s: *** Error: invalid number of arguments.\n', SCRIPT_FILENAME)
+    exit(1)
+
+target = sys.argv[1]
+results_filename = sys.argv[2]
+
+sizes   = [int(x) for x in os.getenv('NETBENCH_SIZES', '32,64,256,512,1024,1472,4096').split(',')]
+count   = int(os.getenv('NETBENCH_COUNT', '2000'))
+window  = int(os.getenv('NETBENCH_WINDOW', '8'))
+timeout = float(os.getenv('NETBENCH_TIMEOUT', '1'))
+
+#
+# Wait for the target to come up.
+#
+time_start = time.time()
+while stats_get(target, 1.0) is None:
+    if time.time() - time_start > 60:
+        errprintf('%s: *** Error: no answer from %s.\n', SCRIPT_FILENAME, target)
+        exit(1)
+
+results = []
+printf('%-5s %6s %7s %7s %6s %10s %10s %10s %s\n',
+       'proto', 'size', 'sent', 'recv', 'lost', 'pps', 'p50 us', 'p99 us', 'target drops')
+for protocol, probe_class in (('icmp', IcmpProbe), ('udp', UdpProbe)):
+    try:
+        probe = probe_class(target)
+    except PermissionError:
+        errprintf('%s: *** Warning: no permission for %s, skipped.\n', SCRIPT_FILENAME, protocol)
+        continue
+    for size in sizes:
+        stats_before = stats_get(target, timeout)
+        result = run_test(probe, size, count, window, timeout)
+        stats_after = stats_get(target, timeout)
+        result['protocol'] = protocol
+        result['target'] = stats_delta(stats_before, stats_after)
+        results.append(result)
+        if result['target'] is not None:
+            drops = '%d/%d/%d' % (
+                result['target']['nic_rx_dropped'],
+                result['target']['eth_rx_dropped'],
+                result['target']['udp_echo_drops']
+                )
+        else:
+            drops = '-'
+        printf('%-5s %6d %7d %7d %6d %10.1f %10s %10s %s\n',
+               protocol,
+               size,
+               result['sent'],
+               result['received'],
+               result['lost'],
+               result['pps'],
+               result['rtt_p50_us'],
+               result['rtt_p99_us'],
+               drops)
+    probe.close()
+
+with open(results_filename, 'w') as fd:
+    json.dump(
+        {
+            'target':    target,
+            'timestamp': time.strftime('%Y-%m-%dT%H:%M:%SZ', time.gmtime()),
+            'count':     count,
+            'window':    window,
+            'timeout_s': timeout,
+            'results':   results
+        },
+        fd,
+        indent=2
+        )
+    fd.write('\n')
+
+printf('%s: results written to %s\n', SCRIPT_FILENAME, results_filename)
+
+exit(0)